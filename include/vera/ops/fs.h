@@ -119,6 +119,29 @@ bool resolveGlsl(const std::string& _src, std::string *_into, const StringList&
 /// @return True if successfully resolved
 bool resolveGlsl(const std::string& _src, const std::string& _pwd, std::string *_into, const StringList& _include_folders, StringList *_dependencies);
 
+/// Read-only view of a whole file: memory mapped where available (pages are
+/// faulted in on demand, so readers go straight to the page cache), read
+/// into a buffer otherwise
+class MappedFile {
+public:
+    MappedFile(const std::string& _filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool        isOpen() const { return m_data != nullptr; }
+    const char* data() const { return m_data; }
+    size_t      size() const { return m_size; }
+
+private:
+    const char*         m_data = nullptr;
+    size_t              m_size = 0;
+#if defined(_WIN32)
+    std::vector<char>   m_buffer;
+#endif
+};
+
 // =============================================================================
 // BINARY DATA ENCODING
 // =============================================================================
@@ -123,21 +123,25 @@ Image               toSdf(      const Image& _image,
                                 float _on = 1.0f);
 
 /// Generate signed distance field from 3D mesh
+/// Distances are exact within a narrow band around the triangles, and
+/// interpolated (to a fraction of a voxel) from exact samples away from it.
 /// @param _mesh Input mesh
 /// @param _paddingPct Padding as percentage of bounding box (default 0.01)
 /// @param _resolution Resolution level (default 6)
-/// @return SDF Image representing mesh interior/exterior distance
+/// @param _bvhCachePath File to keep the mesh BVH in between runs (see BVH::save()), none by default
+/// @return One channel atlas of the Z layers, 2^_resolution voxels a side (0.5 on the surface, below inside)
 Image               toSdf(      const Mesh& _mesh, 
                                 float _paddingPct = 0.01f, 
-                                int _resolution = 6);
+                                int _resolution = 6,
+                                const std::string& _bvhCachePath = "");
 
 /// Generate single Z-layer of SDF from BVH (bounding volume hierarchy)
 /// @param _bvh Pointer to BVH structure
 /// @param _voxel_resolution Voxel grid resolution
 /// @param _z_layer Z-layer index to generate
-/// @param _refinement Refinement step size (default 0.00125)
+/// @param _tolerance How much farther than the closest triangle a distance may be, as a fraction of half the bounds diagonal (0: exact, default 0.00125)
 /// @return SDF Image for specified layer
-Image               toSdfLayer(const BVH* _bvh, size_t _voxel_resolution, size_t _z_layer, float _refinement = 0.00125f);
+Image               toSdfLayer(const BVH* _bvh, size_t _voxel_resolution, size_t _z_layer, float _tolerance = 0.00125f);
 
 // void                refineSdfLayer(const BVH* _bvh, Image& _images);
 
@@ -4,6 +4,7 @@
 #include "vera/types/line.h"
 #include "vera/types/plane.h"
 #include "vera/types/triangle.h"
+#include "vera/types/triangleSoup.h"
 #include "vera/types/boundingBox.h"
 
 #include <string>
@@ -127,6 +128,34 @@ IntersectionData    intersection(const Ray& _ray, const Triangle& _triangle);
 /// @return True if ray intersects triangle
 bool                intersection(const Ray& _ray, const Triangle& _triangle, float& _t, float& _u, float& _v);
 
+/// Test ray-triangle intersection on three vertices (Möller-Trumbore)
+/// @param _ray Ray
+/// @param _v0 First vertex
+/// @param _v1 Second vertex
+/// @param _v2 Third vertex
+/// @param _t Output distance along ray to intersection
+/// @param _u Output barycentric U coordinate
+/// @param _v Output barycentric V coordinate
+/// @return True if ray intersects triangle
+bool                intersection(const Ray& _ray, const glm::vec3& _v0, const glm::vec3& _v1, const glm::vec3& _v2, float& _t, float& _u, float& _v);
+
+/// Find intersection of ray with one face of a triangle soup
+/// @param _ray Ray
+/// @param _soup Triangle soup
+/// @param _face Face index
+/// @return Intersection data
+IntersectionData    intersection(const Ray& _ray, const TriangleSoup& _soup, size_t _face);
+
+/// Test ray intersection with one face of a triangle soup (Möller-Trumbore)
+/// @param _ray Ray
+/// @param _soup Triangle soup
+/// @param _face Face index
+/// @param _t Output distance along ray to intersection
+/// @param _u Output barycentric U coordinate
+/// @param _v Output barycentric V coordinate
+/// @return True if ray intersects the face
+bool                intersection(const Ray& _ray, const TriangleSoup& _soup, size_t _face, float& _t, float& _u, float& _v);
+
 // =============================================================================
 // LINE INTERSECTIONS
 // =============================================================================
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace vera {
+
+// =============================================================================
+// PARALLEL LOOPS
+// =============================================================================
+
+/// Number of threads worth using for a workload
+/// @param _count Number of work items
+/// @param _minPerThread Smallest number of items worth a thread
+/// @return Between 1 and the hardware concurrency
+inline size_t parallelThreads(size_t _count, size_t _minPerThread) {
+    size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+    return std::max((size_t)1, std::min(nThreads, _count / std::max(_minPerThread, (size_t)1)));
+}
+
+/// Split [0, _count) into contiguous ranges, one per thread, and run
+/// _fn(threadIndex, begin, end) on each. A single thread runs inline.
+/// @param _nThreads Number of threads (see parallelThreads())
+/// @param _count Number of work items
+/// @param _fn Callable taking (size_t thread, size_t begin, size_t end)
+template<typename F>
+void parallelFor(size_t _nThreads, size_t _count, F _fn) {
+    if (_nThreads <= 1) {
+        _fn((size_t)0, (size_t)0, _count);
+        return;
+    }
+
+    size_t perThread = _count / _nThreads;
+    size_t leftOver = _count % _nThreads;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < _nThreads; t++) {
+        size_t start = t * perThread;
+        size_t end = start + perThread;
+        if (t == _nThreads - 1)
+            end += leftOver;
+        threads.push_back(std::thread(_fn, t, start, end));
+    }
+
+    for (std::thread& t : threads)
+        t.join();
+}
+
+}
\ No newline at end of file
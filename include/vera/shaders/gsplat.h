@@ -267,6 +267,13 @@ precision highp usampler2D;
 
 uniform usampler2D  u_gsplatTex;
 
+// Quantized higher-order spherical harmonics (see Gsplat::createTextureSH())
+uniform usampler2D  u_gsplatSHTex;
+uniform int         u_gsplatSHDegree;
+uniform int         u_gsplatSHStride;
+uniform vec2        u_gsplatSHRange;
+uniform vec3        u_gsplatCameraPosition;
+
 uniform mat4        u_projectionMatrix;
 uniform mat4        u_viewMatrix;
 uniform mat4        u_modelMatrix;
@@ -291,6 +298,53 @@ vec3 octDecode(vec2 f) {
     return normalize(n);
 }
 
+const float SH_C1 = 0.4886025119029199;
+const float SH_C2[5] = float[](1.0925484305920792, -1.0925484305920792, 0.31539156525252005, -1.0925484305920792, 0.5462742152960396);
+const float SH_C3[7] = float[](-0.5900435899266435, 2.890611442640554, -0.4570457994644658, 0.3731763325901154, -0.4570457994644658, 1.445305721320277, -0.5900435899266435);
+
+uvec4 shTexels[3];
+
+// RGB of the k-th coefficient (of bands 1..3), dequantized
+vec3 shCoeff(int k) {
+    vec3 q;
+    for (int c = 0; c < 3; c++) {
+        int b = k * 3 + c;
+        uint word = shTexels[b >> 4][(b >> 2) & 3];
+        q[c] = float((word >> uint((b & 3) * 8)) & 0xffu);
+    }
+    return u_gsplatSHRange.x + q * ((u_gsplatSHRange.y - u_gsplatSHRange.x) / 255.0);
+}
+
+// View-dependent color offset of a splat (bands 1..u_gsplatSHDegree)
+vec3 evalSH(uint index, vec3 dir) {
+    ivec2 base = ivec2(int(index & 0x3ffu) * u_gsplatSHStride, int(index >> 10));
+    for (int t = 0; t < 3; t++)
+        shTexels[t] = t < u_gsplatSHStride ? texelFetch(u_gsplatSHTex, base + ivec2(t, 0), 0) : uvec4(0u);
+
+    float x = dir.x, y = dir.y, z = dir.z;
+    vec3 result = SH_C1 * (-y * shCoeff(0) + z * shCoeff(1) - x * shCoeff(2));
+
+    if (u_gsplatSHDegree > 1) {
+        float xx = x * x, yy = y * y, zz = z * z;
+        result +=   SH_C2[0] * x * y * shCoeff(3) +
+                    SH_C2[1] * y * z * shCoeff(4) +
+                    SH_C2[2] * (2.0 * zz - xx - yy) * shCoeff(5) +
+                    SH_C2[3] * x * z * shCoeff(6) +
+                    SH_C2[4] * (xx - yy) * shCoeff(7);
+
+        if (u_gsplatSHDegree > 2) {
+            result +=   SH_C3[0] * y * (3.0 * xx - yy) * shCoeff(8) +
+                        SH_C3[1] * x * y * z * shCoeff(9) +
+                        SH_C3[2] * y * (4.0 * zz - xx - yy) * shCoeff(10) +
+                        SH_C3[3] * z * (2.0 * zz - 3.0 * xx - 3.0 * yy) * shCoeff(11) +
+                        SH_C3[4] * x * (4.0 * zz - xx - yy) * shCoeff(12) +
+                        SH_C3[5] * z * (xx - yy) * shCoeff(13) +
+                        SH_C3[6] * x * (xx - 3.0 * yy) * shCoeff(14);
+        }
+    }
+    return result;
+}
+
 void main() {
     // Pixel size
     vec2 pixel = 1.0 / u_resolution;
@@ -376,6 +430,9 @@ void main() {
         float((cov.w >> 16) & 0xffu),
         float((cov.w >> 24) & 0xffu)
     ) / 255.0;
+
+    if (u_gsplatSHDegree > 0)
+        color.rgb = max(color.rgb + evalSH(a_index, normalize(v_position.xyz - u_gsplatCameraPosition)), 0.0);
     
     v_color = color;
     v_texcoord = a_position;
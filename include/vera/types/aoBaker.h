@@ -0,0 +1,80 @@
+#pragma once
+
+#include "vera/types/bvh.h"
+#include "vera/types/image.h"
+#include "vera/types/mesh.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace vera {
+
+enum BakeTarget {
+    BAKE_VERTICES = 0,
+    BAKE_TEXELS
+};
+
+// Ambient occlusion of a mesh over itself, baked on the CPU: cosine
+// weighted rays leave each vertex (BAKE_VERTICES) or each lightmap texel
+// its texcoords cover (BAKE_TEXELS) and are traced in batches against a
+// BVH of the mesh. Samples accumulate over as many passes as wanted; a
+// point stops taking rays once its estimate is within the tolerance.
+class AOBaker {
+public:
+    AOBaker();
+    virtual ~AOBaker();
+
+    virtual bool        load(const Mesh& _mesh, BakeTarget _target = BAKE_VERTICES, size_t _width = 512, size_t _height = 512);
+    virtual void        clear();
+
+    // Occluders farther than this don't count (half the mesh bounds
+    // diagonal after load())
+    void                setMaxDistance(float _distance) { m_maxDistance = _distance; }
+    float               getMaxDistance() const { return m_maxDistance; }
+
+    // A point is done once it took _minSamples rays and the 95% confidence
+    // interval of its occlusion is within +/- _tolerance
+    void                setTolerance(float _tolerance, size_t _minSamples = 16) { m_tolerance = _tolerance; m_minSamples = _minSamples; }
+
+    // Trace _samples more rays from each point not done yet, over all
+    // cores. Returns the points still not done.
+    virtual size_t      accumulate(size_t _samples = 16);
+    // accumulate() until every point is done or took _maxSamples rays
+    virtual size_t      bake(size_t _maxSamples = 1024);
+
+    size_t              getPointsTotal() const { return m_positions.size(); }
+    size_t              getPendingTotal() const { return m_pending.size(); }
+    size_t              getSamples() const { return m_samples; }
+    bool                isDone() const { return m_pending.empty(); }
+
+    // Fraction of the hemisphere left open (1.0 unoccluded, 0.0 enclosed)
+    float               getValue(size_t _point) const;
+
+    // BAKE_TEXELS: a one channel lightmap, covered texels grown _padding
+    // texels into the empty ones around them (so filtering doesn't pull
+    // in the background at UV seams)
+    virtual Image       getImage(size_t _padding = 2) const;
+    // BAKE_VERTICES: into the vertex colors of _mesh (the one loaded)
+    virtual bool        setColors(Mesh& _mesh) const;
+
+protected:
+    BVH                     m_bvh;
+    BakeTarget              m_target = BAKE_VERTICES;
+    size_t                  m_width = 0;
+    size_t                  m_height = 0;
+
+    std::vector<glm::vec3>  m_positions;    // per point
+    std::vector<glm::vec3>  m_normals;
+    std::vector<uint32_t>   m_texels;       // BAKE_TEXELS: texel of each point
+    std::vector<uint32_t>   m_hits;         // occluded rays per point
+    std::vector<uint32_t>   m_rays;         // rays per point
+    std::vector<uint32_t>   m_pending;      // points not done, in order
+
+    size_t                  m_samples = 0;  // rays each pending point took
+    size_t                  m_minSamples = 16;
+    float                   m_tolerance = 0.02f;
+    float                   m_maxDistance = 1.0f;
+    float                   m_bias = 0.0f;  // ray origins lifted off the surface by this much
+};
+
+}
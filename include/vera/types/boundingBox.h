@@ -36,6 +36,7 @@ public:
             max = glm::vec3(std::numeric_limits<float>::min());
         }
     }
+    BoundingBox& operator = (const BoundingBox& _b) { set(_b); return *this; }
     void        operator = (const glm::vec4& _b) { set(_b); }
 
     float       getWidth() const { return fabs(max.x - min.x); }
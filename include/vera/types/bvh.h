@@ -2,9 +2,13 @@
 
 #include "vera/types/boundingBox.h"
 #include "vera/types/triangle.h"
+#include "vera/types/triangleSoup.h"
 #include "vera/types/ray.h"
 
+#include <limits>
 #include <memory>
+#include <string>
+#include <stdint.h>
 
 namespace vera {
 
@@ -16,16 +20,95 @@ enum BVH_Split{
     SPLIT_SAH
 };
 
+// 32 bytes. Nodes are stored depth first: an inner node (count == 0) has
+// its first child right after it and its second child at offset. A leaf
+// covers indices [offset, offset + count) of the primitive arrays.
+struct BVHNode {
+    glm::vec3   min;
+    uint32_t    offset;
+    glm::vec3   max;
+    uint32_t    count;
+};
+
+// Result of one ray in BVH::intersect(): distance along the ray, index of
+// the element hit (NONE on a miss) and barycentric weights of its vertices
+// 1 and 2 at the hit point
+struct BVHHit {
+    static const uint32_t NONE = 0xffffffff;
+
+    float       t = 0.0f;
+    uint32_t    triangle = NONE;
+    glm::vec2   barycentric = glm::vec2(0.0f);
+
+    bool        hit() const { return triangle != NONE; }
+};
+
+// Report of the last BVH::load() or BVH::refit() (see BVH::getStats())
+struct BVHStats {
+    double  buildTime = 0.0;        // milliseconds
+    bool    cached = false;         // read from a cache file instead of built
+    double  refitTime = 0.0;        // milliseconds, 0 until refit
+    size_t  rebuiltSubtrees = 0;    // by the last refit
+    float   sahCost = 0.0f;         // expected cost of a ray through the root, in triangle tests
+    size_t  nodes = 0;
+    size_t  leaves = 0;
+    size_t  maxDepth = 0;
+    size_t  maxLeafSize = 0;
+    float   averageLeafSize = 0.0f;
+};
+
 class BVH : public BoundingBox {
 public:
     BVH();
     BVH( const std::vector<Triangle>& _elements, BVH_Split _strategy = SPLIT_BALANCED );
+    BVH( const TriangleSoup& _elements, BVH_Split _strategy = SPLIT_BALANCED );
     virtual ~BVH();
 
+    // Triangles are kept as a TriangleSoup: loading one (see
+    // TriangleSoup(const Mesh&)) avoids a Triangle object per face
     virtual void            load( const std::vector<Triangle>& _elements, BVH_Split _strategy = SPLIT_BALANCED);
+    virtual void            load( const TriangleSoup& _elements, BVH_Split _strategy = SPLIT_BALANCED);
+
+    // Same, through a cache file: the tree saved at _cachePath is used when
+    // it was built from the same positions and faces (see
+    // TriangleSoup::getHash()) with the same strategy, otherwise it is built
+    // and saved there. Returns true when it came from the cache.
+    virtual bool            load( const TriangleSoup& _elements, BVH_Split _strategy, const std::string& _cachePath);
+
+    // Write the built tree (nodes, primitive order and the hash of the
+    // elements) for load() with a cache path to read back
+    virtual bool            save( const std::string& _path ) const;
+
+    // Follow moving triangles without a new build: _elements must be the
+    // loaded ones, in the same order, with new vertex positions (anything
+    // else is loaded from scratch). Node bounds are recomputed bottom up,
+    // which keeps every query exact but lets the tree get looser as the
+    // mesh deforms. With a _rebuildThreshold, the subtrees whose SAH cost
+    // grew by more than that fraction since they were built are rebuilt
+    // with the load() strategy, or the whole tree when its own cost did.
+    // Returns the number of subtrees rebuilt.
+    virtual size_t          refit( const std::vector<Triangle>& _elements, float _rebuildThreshold = 0.0f);
+    virtual size_t          refit( const TriangleSoup& _elements, float _rebuildThreshold = 0.0f);
+    // Same with only new vertex positions (as many as elements.positions,
+    // e.g. the vertices of the animated Mesh it was loaded from)
+    virtual size_t          refit( const std::vector<glm::vec3>& _positions, float _rebuildThreshold = 0.0f);
+    // Same, after editing elements.positions in place
+    virtual size_t          refit( float _rebuildThreshold = 0.0f);
     
     virtual std::shared_ptr<BVH> hit(const Ray& _ray, float& _minDistance, float& _maxDistance);
 
+    // Closest hit of each ray within [_minDistance, _maxDistance], into
+    // _hits (resized to match). Rays are traced four at a time, so keeping
+    // rays that travel together next to each other (a tile of pixels, the
+    // samples of one texel) makes them cheaper. With _anyHit the first hit
+    // found is kept instead, which is enough for visibility tests.
+    virtual void            intersect(const std::vector<Ray>& _rays, std::vector<BVHHit>& _hits,
+                                      float _minDistance = 0.0f, float _maxDistance = std::numeric_limits<float>::max(),
+                                      bool _anyHit = false) const;
+    virtual bool            intersect(const Ray& _ray, BVHHit& _hit,
+                                      float _minDistance = 0.0f, float _maxDistance = std::numeric_limits<float>::max(),
+                                      bool _anyHit = false) const;
+
     virtual float           getCost() { return float(elements.size()) * getArea(); }
 
     virtual glm::vec3       getClosestPointOnTriangle(const glm::vec3& _point) const;
@@ -33,22 +116,77 @@ public:
     virtual float           getClosestSignedDistance(const glm::vec3& _point, float _refinement = 0.0f) const;
     virtual glm::vec4       getClosestRGBSignedDistance(const glm::vec3& _point, float _refinement = 0.0f) const;
 
-    virtual void            clear();
+    // Batched versions of the above. Points are searched four at a time,
+    // starting from the triangles found for the previous four, so
+    // neighbours (a row or a brick of voxels) should be passed next to each
+    // other. _triangles, when given, receives each closest element index.
+    // Exact by default; with a _tolerance the result may be a triangle up
+    // to that much farther than the closest, which is much faster for
+    // points far from the surface.
+    virtual void            getClosestDistances(const std::vector<glm::vec3>& _points, std::vector<float>& _distances,
+                                                std::vector<uint32_t>* _triangles = nullptr, float _tolerance = 0.0f) const;
+    virtual void            getClosestSignedDistances(const std::vector<glm::vec3>& _points, std::vector<float>& _distances,
+                                                      std::vector<uint32_t>* _triangles = nullptr, float _tolerance = 0.0f) const;
+    virtual void            getClosestRGBSignedDistances(const std::vector<glm::vec3>& _points, std::vector<glm::vec4>& _rgbd,
+                                                         std::vector<uint32_t>* _triangles = nullptr, float _tolerance = 0.0f) const;
 
-    std::vector<Triangle>   elements;
+    virtual void            clear();
 
-    std::shared_ptr<BVH>    left;
-    std::shared_ptr<BVH>    right;
+    const std::vector<BVHNode>& getNodes() const { return m_nodes; }
+    const BVHStats&         getStats() const { return m_stats; }
 
-    size_t                  axis;
-    bool                    leaf;
+    // Source triangles, in load order (primitive indices are its faces)
+    TriangleSoup            elements;
 
 protected:
-    virtual void            _split_balanced();
-    virtual void            _split_midpoint();
-    virtual void            _split_sorted_midpoint();
-    virtual void            _split_balanced_midpoint();
-    virtual void            _split_sah();
+    // Split the primitives [_begin, _end) of the node's bounds. Return the
+    // first index of the second child, or _end to keep the node a leaf.
+    // Nodes larger than a subtree task may be split with several threads.
+    virtual size_t          _split_balanced(const BVHNode& _node, size_t _begin, size_t _end);
+    virtual size_t          _split_midpoint(const BVHNode& _node, size_t _begin, size_t _end);
+    virtual size_t          _split_sorted_midpoint(const BVHNode& _node, size_t _begin, size_t _end);
+    virtual size_t          _split_balanced_midpoint(const BVHNode& _node, size_t _begin, size_t _end);
+    virtual size_t          _split_sah(const BVHNode& _node, size_t _begin, size_t _end);
+
+    // Subtree built on its own thread into its own nodes, spliced in after
+    struct BuildTask {
+        uint32_t                node;       // placeholder in the top of the tree
+        size_t                  begin, end, depth;
+        std::vector<BVHNode>    nodes;
+    };
+
+    void                    _build(std::vector<BVHNode>& _nodes, size_t _begin, size_t _end, size_t _depth, BVH_Split _strategy,
+                                   std::vector<BuildTask>* _tasks = nullptr, size_t _taskSize = 0);
+    void                    _buildTasks(std::vector<BuildTask>& _tasks, BVH_Split _strategy);
+    void                    _splice(const std::vector<BVHNode>& _top, std::vector<BuildTask>& _tasks);
+    void                    _updateStats();
+
+    // Refit units: subtrees of up to a task worth of primitives, refit and
+    // rebuilt on their own, below a few top nodes refit last
+    struct Subtree {
+        uint32_t                first, last;    // nodes [first, last)
+        size_t                  begin, end;     // primitives [begin, end)
+        size_t                  depth;
+        float                   cost;           // SAH cost when (re)built, relative to its root
+    };
+
+    void                    _findSubtrees();
+    void                    _refitTop();
+
+    uint32_t                _closest(const glm::vec3& _point, float _refinement, float& _distance2) const;
+    void                    _closest(const glm::vec3* _points, size_t _count, uint32_t* _primitives, float* _distances2, float _tolerance) const;
+    void                    _intersect(const Ray* _rays, size_t _count, BVHHit* _hits, float _minDistance, float _maxDistance, bool _anyHit) const;
+
+    std::vector<BVHNode>    m_nodes;
+    std::vector<uint32_t>   m_indices;      // primitive -> element, in leaf order
+    std::vector<glm::vec3>  m_vertices;     // three per primitive, in leaf order
+    std::vector<glm::vec3>  m_centroids;    // per element, only while building
+    std::vector<BoundingBox> m_bounds;      // per element, only while building
+    std::vector<Subtree>    m_subtrees;     // found on the first refit
+    std::vector<uint32_t>   m_topNodes;     // above the subtrees, in depth first order
+    BVH_Split               m_strategy = SPLIT_BALANCED;
+    float                   m_buildCost = 0.0f;     // SAH cost of the tree as built
+    BVHStats                m_stats;
 };
 
 }
\ No newline at end of file
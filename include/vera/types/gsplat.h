@@ -1,29 +1,89 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include <deque>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include "glm/glm.hpp"
 
 #include "vera/gl/texture.h"
 #include "vera/gl/shader.h"
 #include "camera.h"
+#include "image.h"
 
 namespace vera {
 
+class Model;
+
 struct SplatBlock {
     glm::vec3 min_bounds;
     glm::vec3 max_bounds;
     std::vector<uint32_t> indices;
-    unsigned int occlusionQuery = 0;
-    bool occluded = false;
-    int framesHidden = 0;
-    bool queryIssued = false;
+    // Occlusion culling (see Gsplat::setOcclusionScale()): whether the block
+    // is dense and opaque enough to hide what's behind it, how far its
+    // occluder hull reaches past the bounds, and how far its splats do
+    bool occluder = false;
+    glm::vec3 occluderPadding = glm::vec3(0.0f);
+    glm::vec3 splatPadding = glm::vec3(0.0f);
+};
+
+// Node of the spatial octree. Children are contiguous in the node list and
+// every node covers a contiguous range of blocks (its leaves).
+struct SplatOctreeNode {
+    glm::vec3   min_bounds;
+    glm::vec3   max_bounds;
+    uint32_t    firstChild = 0;
+    uint32_t    childCount = 0;     // 0 for leaves, which hold exactly one block
+    uint32_t    firstBlock = 0;
+    uint32_t    blockCount = 0;
+};
+
+// Node of the level-of-detail tree. Leaves group up to 8 splats of one
+// SplatBlock, parents up to 8 nodes. Every node also carries a merged proxy
+// Gaussian, stored right after the source splats (proxy start + node index).
+struct SplatNode {
+    glm::vec3   min_bounds;
+    glm::vec3   max_bounds;
+    uint32_t    firstChild = 0;     // into the LOD child list
+    uint32_t    childCount = 0;
+    int         block = -1;         // SplatBlock it lies in, -1 when spanning several
+    bool        leaf = false;       // children are splats rather than nodes
+};
+
+// Splats decoded by the progressive loader, handed to the render thread
+struct SplatBatch {
+    std::vector<glm::vec3>      positions;
+    std::vector<glm::vec3>      scales;
+    std::vector<glm::quat>      rotations;
+    std::vector<glm::u8vec4>    colors;
+    std::vector<uint8_t>        sh;
+};
+
+// What the load-time pruning dropped (see Gsplat::setPruneMinOpacity())
+struct SplatPruneStats {
+    size_t  loaded = 0;         // splats read from the file
+    size_t  dropped = 0;
+    size_t  cpuBytes = 0;       // splat array memory saved
+    size_t  gpuBytes = 0;       // texture memory saved
 };
 
 struct Frustum {
     glm::vec4 planes[6];
 };
 
+// Depth key used by the radix sort: the full float depth mapped to an
+// order-preserving uint32 (4 passes), or the depth quantized to 16 bits
+// between the nearest and farthest visible splat (2 passes, half the work,
+// ties between splats closer than range/65535 apart).
+enum SplatSortKey {
+    SORT_KEY_32BITS = 0,
+    SORT_KEY_16BITS
+};
+
 class Gsplat {
 public:
 
@@ -31,8 +91,32 @@ public:
     virtual ~Gsplat();
 
     bool    load(const std::string& _filepath);
+
+    // Writes the compact .vsplat container: one chunk per spatial block with
+    // its bounds and an importance estimate, positions quantized to 16 bits
+    // within them, smallest-three rotations, 8-bit log-scales, RGBA8 color
+    // and the 8-bit SH coefficients. load() memory maps it back and decodes
+    // the chunks in parallel. Written to _filepath + ".tmp" and renamed
+    // over; returns false (leaving any previous file) on failure.
+    bool    save(const std::string& _filepath);
     void    use(Shader* _shader);
 
+    // Progressive loading. load() returns right away and a loader thread
+    // decodes the file in batches of _splats, coarse first: .vsplat chunks
+    // by stored importance, .splat and binary .ply records straight from
+    // the file with a strided pass over all of it first, other .ply splats
+    // by opacity x volume once parsed. Each render appends what arrived and
+    // uploads only the new texture rows, so a coarse version shows up within
+    // a few frames; the layout and spatial index are built once the last
+    // batch is in.
+    void    setProgressiveLoad(bool _progressive) { m_progressiveLoad = _progressive; }
+    bool    getProgressiveLoad() const { return m_progressiveLoad; }
+    void    setLoadBatchSize(size_t _splats) { m_loadBatchSize = std::max((size_t)1, _splats); }
+    size_t  getLoadBatchSize() const { return m_loadBatchSize; }
+    bool    isLoading() const { return m_loadThread.joinable(); }
+    // Fraction of the file appended so far (1 when not loading)
+    float   getLoadProgress() const;
+
     // By default, loadPLY()/loadSPLAT() rotate every splat 180 degrees
     // around X to turn COLMAP's (Y down, Z forward) convention into
     // OpenGL's (Y up, Z back) one -- the right thing for a splat viewed on
@@ -44,8 +128,53 @@ public:
     static void setUseColmapFrame(bool _use) { s_useColmapFrame = _use; }
     static bool getUseColmapFrame() { return s_useColmapFrame; }
 
+    // Multi-view frames (Looking Glass quilts, stereo XR). Between
+    // beginMultiView() and endMultiView() every Gsplat sorts once, against
+    // the given representative view (the quilt's center camera, the head
+    // between both eyes), and draws that order in all views instead of
+    // re-sorting for each of their slightly different viewProjs. Culling
+    // uses that view's frustum widened by _guard so it still covers the
+    // off-center ones, and occlusion culling is paused. Calling it again
+    // within a frame starts a new sort (e.g. one per cluster of views).
+    static void beginMultiView(const glm::mat4& _view, const glm::mat4& _projection, float _guard = 1.5f);
+    static void endMultiView() { s_multiViewFrame = 0; }
+    static bool isMultiView() { return s_multiViewFrame != 0; }
+
+    // View-dependent color. loadPLY() keeps the f_rest_* spherical harmonics
+    // coefficients of 3DGS outputs up to this degree (0 drops them, 3 is the
+    // maximum), quantized to 8 bits against a per-scene range and packed in
+    // their own texture. Lower degrees trade quality for memory and bandwidth.
+    // Set before loading; lowering it afterwards only caps the evaluation.
+    void    setMaxSHDegree(int _degree) { m_shMaxDegree = glm::clamp(_degree, 0, 3); }
+    int     getMaxSHDegree() const { return m_shMaxDegree; }
+    int     getSHDegree() const { return m_shDegree; }
+
+    // Load-time pruning, applied before the layout and spatial index get
+    // built: splats under _opacity (0..1) or whose largest axis (one standard
+    // deviation) is under _extent world units are dropped, then only the
+    // _splats largest by opacity x volume are kept (0: no cap). All off by
+    // default. Set before loading; getPruneStats() reports the last load.
+    void    setPruneMinOpacity(float _opacity) { m_pruneMinOpacity = _opacity; }
+    float   getPruneMinOpacity() const { return m_pruneMinOpacity; }
+    void    setPruneMinExtent(float _extent) { m_pruneMinExtent = _extent; }
+    float   getPruneMinExtent() const { return m_pruneMinExtent; }
+    void    setPruneMaxCount(size_t _splats) { m_pruneMaxCount = _splats; }
+    size_t  getPruneMaxCount() const { return m_pruneMaxCount; }
+    const SplatPruneStats& getPruneStats() const { return m_pruneStats; }
+
     void    clear();
-    size_t  count() const { return m_positions.size(); }
+
+    // Replaces splats [_first, _first + _count) with the given values (null
+    // arrays leave that attribute as is). Only the texture rows holding
+    // them get re-packed and uploaded, on the next render.
+    void    updateSplats(size_t _first, size_t _count, const glm::vec3* _positions,
+                         const glm::vec3* _scales = nullptr, const glm::quat* _rotations = nullptr,
+                         const glm::u8vec4* _colors = nullptr);
+
+    // Source splats (LOD proxies excluded)
+    size_t  count() const { return m_lodNodes.empty() ? m_positions.size() : m_lodProxyStart; }
+    // Bumped whenever the splats are loaded, pruned or edited in place
+    size_t  getGeneration() const { return m_generation; }
     
     void    render(Camera* _camera, glm::mat4 _model = glm::mat4(1.0f), bool _sort = false);
     void    renderNormal(Camera* _camera, glm::mat4 _model = glm::mat4(1.0f), bool _sort = false);
@@ -60,10 +189,71 @@ public:
     void    renderDepth(Camera* _camera, glm::mat4 _model = glm::mat4(1.0f), bool _sort = false);
     void    renderBlocks(Camera* _camera, glm::mat4 _model = glm::mat4(1.0f));
 
+    // Headless counterpart of render(), for machines without a GPU: the same
+    // splats, footprints and colors, rasterized on the CPU in 16x16 pixel
+    // tiles (binned front to back, composited with early termination) over
+    // all cores. Writes premultiplied color over black and coverage in alpha
+    // into _image, top row first; an unallocated _image gets the camera's
+    // viewport size and 4 channels.
+    bool    renderImage(Camera* _camera, Image& _image, glm::mat4 _model = glm::mat4(1.0f));
+
+    // Spatial index used for culling and occlusion tests: an octree over
+    // the Morton-ordered splats, split until leaves (blocks) hold at most
+    // _splats. 0 (default) derives it from the grid dimension, aiming at
+    // about _dim^3 blocks like the uniform grid it replaces.
+    void    setBlockSize(size_t _splats);
+    size_t  getBlockSize() const { return m_blockSize; }
+    size_t  getBlockCount() const { return m_blocks.size(); }
     void    setGridDim(int _dim);
+
+    // Occlusion culling, done by the sort on the CPU (no GPU queries, no
+    // frame of lag): blocks dense and opaque enough to be solid get their
+    // bounds (scaled by _scale around their center, grown by the size of
+    // their splats) rasterized into a small depth buffer, and blocks found
+    // behind it are not drawn. Lower the scale for curved or volumetric
+    // content whose bounds overstate it. A block must test hidden for more
+    // than _threshold consecutive sorts to be culled.
     void    setOcclusionThreshold(int _threshold);
     void    setOcclusionScale(float _scale);
 
+    // Moves the depth sort off the render thread. A worker thread sorts
+    // against a snapshot of the latest viewProj into a back buffer and
+    // publishes it once done; render() keeps drawing the last completed
+    // order in the meantime, so frame time no longer depends on splat count.
+    void    setAsyncSort(bool _async);
+    bool    getAsyncSort() const { return m_asyncSort; }
+
+    // How many newer viewpoints the drawn order may lag behind before
+    // render() blocks on the worker to catch up (negative: never block).
+    // Only meaningful when the async sort is enabled.
+    void    setSortMaxStaleness(int _staleness) { m_sortMaxStaleness = _staleness; }
+    int     getSortMaxStaleness() const { return m_sortMaxStaleness; }
+
+    void    setSortKey(SplatSortKey _key);
+    SplatSortKey getSortKey() const { return m_sortKey; }
+
+    // Temporally coherent re-sort: start from the previous frame's order,
+    // recompute its depths and repair it with an adaptive insertion sort,
+    // falling back to a full radix sort when more than _threshold of the
+    // neighbouring pairs came out of order (or the repair runs too long).
+    void    setIncrementalSort(bool _incremental);
+    bool    getIncrementalSort() const { return m_incrementalSort; }
+    void    setIncrementalSortThreshold(float _threshold);
+    float   getIncrementalSortThreshold() const { return m_incrementalSortThreshold; }
+
+    // Level of detail. When enabled, a tree of merged (moment-matched)
+    // proxy Gaussians is built over every block at load time, and each sort
+    // cuts it: nodes whose projected size is under _pixels are drawn as their
+    // proxy, the largest ones get refined first, and refinement stops once
+    // the cut would exceed the splat budget (0: no budget).
+    void    setLodEnabled(bool _enabled);
+    bool    getLodEnabled() const { return m_lodEnabled; }
+    void    setLodBudget(size_t _splats);
+    size_t  getLodBudget() const { return m_lodBudget; }
+    void    setLodErrorThreshold(float _pixels);
+    float   getLodErrorThreshold() const { return m_lodErrorThreshold; }
+    size_t  getLodNodeCount() const { return m_lodNodes.size(); }
+
     int     getGridDim() const { return m_gridDim; }
     int     getOcclusionThreshold() const { return m_occlusionThreshold; }
     float   getOcclusionScale() const { return m_occlusionScale; }
@@ -73,26 +263,122 @@ public:
     void    optimizeDataLayout();
 
 private:
+    friend class GsplatCompositor;
+
     static bool s_useColmapFrame;
 
-    // Radix sort helper
-    void    radixSort(std::vector<std::pair<float, uint32_t>>& arr);
+    // Current multi-view frame (0 outside of one) and its shared view
+    static size_t       s_multiViewFrame;
+    static size_t       s_multiViewFrameCount;
+    static glm::mat4    s_multiViewViewProj;
+    static float        s_multiViewGuard;
+
+    // Parallel LSD radix sort of the first _count entries of m_sortKeys
+    // (ascending), carrying m_sortValues along.
+    void    radixSort(size_t _count, int _keyBits);
+    // Fills m_sortKeys from m_sortDepths, returns the key width in bits
+    int     buildSortKeys(size_t _count);
+    // Insertion-sorts an almost sorted m_sortKeys/m_sortValues in place.
+    // Returns false (leaving a valid but unsorted permutation) when the
+    // input was too disordered for that to beat a radix sort.
+    bool    repairOrder(size_t _count);
 
     bool    loadPLY(const std::string& _filepath);
     bool    loadSPLAT(const std::string& _filepath);
+    bool    loadVSPLAT(const std::string& _filepath);
+    // Pruning, data layout and spatial index of freshly loaded splats
+    void    finishLoad(bool _optimizeLayout);
+    void    pruneSplats();
+    // Splat data only: shaders, VAOs and buffers are kept
+    void    clearSplats();
+
+    // Replaces the splats with the first count() of each source, moved into
+    // world space by its matrix (see GsplatCompositor). Each source keeps a
+    // contiguous range, in source order.
+    void    mergeFrom(const std::vector<const Gsplat*>& _sources, const std::vector<glm::mat4>& _matrices);
+    // Moves the range mergeFrom() gave _source (starting at _first) by a
+    // new matrix, in place: the blocks are refit, only its rows uploaded
+    void    moveSource(const Gsplat* _source, const glm::mat4& _matrix, size_t _first);
+    void    transformSource(const Gsplat* _source, const glm::mat4& _matrix, size_t _first);
+    // Longest SH band (per channel) among the first _coeffs coefficients,
+    // the same under any rotation
+    float   shBandExtent(int _coeffs) const;
+    // Bookkeeping after splats [_begin, _end) were edited in place: upload,
+    // update the LOD proxies above them, and when _moved re-sort and refit
+    // the blocks
+    void    splatsChanged(size_t _begin, size_t _end, bool _moved);
+
+    // Progressive loader (see setProgressiveLoad()). The loader thread only
+    // pushes batches; updateProgressiveLoad() appends them on the render
+    // thread, where GL and the sort are.
+    void    loadThreadLoop(std::string _filepath, int _shMaxDegree, size_t _batchSize);
+    // Pushes _count fixed-size records as batches, _decode filling a batch
+    // slot from a record. False when the load was cancelled.
+    bool    streamLoadRecords(size_t _count, size_t _batchSize, size_t _shBytes,
+                              const std::function<void(size_t, SplatBatch&, size_t)>& _decode);
+    void    loadStagedBatches(const std::string& _filepath, int _shMaxDegree, size_t _batchSize);
+    bool    pushLoadBatch(SplatBatch& _batch);
+    void    updateProgressiveLoad();
+    void    cancelLoad();
 
     Texture* createTextureFloat();
     Texture* createTextureUint();
+    Texture* createTextureSH();
+    // Pack the splats of texture rows [_rowBegin, _rowEnd) into _dst
+    void     packRowsFloat(size_t _rowBegin, size_t _rowEnd, float* _dst) const;
+    void     packRowsUint(size_t _rowBegin, size_t _rowEnd, uint32_t* _dst) const;
+    void     packSplatFloat(size_t _index, float* _texel) const;
+    void     packSplatUint(size_t _index, uint32_t* _texel) const;
+    void     packRowsSH(size_t _rowBegin, size_t _rowEnd, uint8_t* _dst) const;
+    size_t   textureCapacity() const;
+    void     updateTextureRows(size_t _begin, size_t _end);
+    int      shCoeffCount() const { return (m_shDegree + 1) * (m_shDegree + 1) - 1; }
 
     void    buildSpatialIndex();
-    void    performOcclusionQuery(const glm::mat4& _viewProj);
-    void    sort(const glm::mat4& _viewProj);
-
-    // Lazily creates/resizes the private depth-only FBO performOcclusionQuery()
-    // draws its coarse block-shaped occluder proxies into, so that internal
-    // culling heuristic never pollutes whatever depth buffer is actually
-    // bound during render() (e.g. the main scene's, backing u_sceneDepth).
-    void    ensureOcclusionFbo(int _width, int _height);
+    // Deletes the blocks and the octree
+    void    clearBlocks();
+    void    refitBlocks(size_t _begin, size_t _end);
+    void    cullBlocks(const Frustum& _frustum, std::vector<uint8_t>& _visible) const;
+    // Software occlusion (see setOcclusionScale()): rasterizes the occluders
+    // among the _visible blocks, then clears (and flags in _occluded) the
+    // ones hidden behind them
+    void    occludeBlocks(const glm::mat4& _viewProj, std::vector<uint8_t>& _visible, std::vector<uint8_t>& _occluded);
+    // Sets SplatBlock::occluder from the block's splats and bounds
+    void    classifyOccluder(SplatBlock& _block) const;
+    void    sort(const glm::mat4& _viewProj, float _viewportHeight);
+
+    // LOD tree (see setLodEnabled()). buildLOD() appends the proxies after
+    // the source splats, dropLOD() truncates them away again.
+    void    buildLOD();
+    void    dropLOD();
+    // Re-merges (and uploads) only the nodes over splats [_begin, _end) and
+    // their ancestors, keeping the tree, after those splats were edited
+    void    updateLOD(size_t _begin, size_t _end);
+    void    mergeLODNode(size_t _node);
+    void    mergeSplats(const uint32_t* _splats, size_t _count, size_t _target);
+    size_t  cutLOD(const glm::mat4& _viewProj, float _viewportHeight, const Frustum& _frustum, uint32_t* _values);
+
+    // Deletes the GPU copies of the splat data (rebuilt lazily on next use)
+    void    resetTextures();
+
+    // Sorting is split so the CPU-only part (computeOrder()) can run on the
+    // worker thread, while everything touching GL (uploading the index
+    // buffer) stays on the render thread. _occluded gets which blocks the
+    // occlusion test culled (none when _occlusion is off).
+    void    computeOrder(const glm::mat4& _viewProj, float _viewportHeight, bool _occlusion, std::vector<uint32_t>& _order, std::vector<uint8_t>& _occluded);
+    void    publishOrder(std::vector<uint32_t>& _order);
+    void    uploadIndexBuffer(int _shaderVersion);
+
+    // Async sort worker (see setAsyncSort())
+    void    startSortThread();
+    void    stopSortThread();
+    void    sortThreadLoop();
+    void    requestSort(const glm::mat4& _viewProj, float _viewportHeight);
+    bool    collectSort(bool _wait);
+    // Waits for any in-flight sort and drops pending ones, so the next
+    // ensureSorted() asks for a new one. Must be called before touching
+    // anything the worker reads (splat arrays, blocks, sort settings).
+    void    finishSort();
 
     // Lazy-init / shared-state helpers used by render()/renderNormal()/renderDepth()
     void    ensureColorShader();
@@ -100,27 +386,80 @@ private:
     void    ensureDepthShader();
     void    ensureSharedBuffers();
     void    ensureTexture(int _shaderVersion);
-    void    ensureSorted(const glm::mat4& _viewProj, bool _sort);
+    void    ensureSorted(const glm::mat4& _viewProj, const glm::mat4& _model, float _viewportHeight, bool _sort);
 
 
     // Frustum helpers
     Frustum extractFrustum(const glm::mat4& _viewProj) const;
     bool    isBoxInFrustum(const glm::vec3& min, const glm::vec3& max, const Frustum& _frustum) const;
+    int     classifyBox(const glm::vec3& min, const glm::vec3& max, const Frustum& _frustum) const;
 
     int     m_gridDim               = 16;
-    int     m_occlusionThreshold    = 10;
-    float   m_occlusionScale        = 0.8f;
+    size_t  m_blockSize             = 0;
+    int     m_occlusionThreshold    = 0;
+    float   m_occlusionScale        = 1.0f;
 
 
     std::vector<glm::u8vec4>    m_colors;
     std::vector<glm::quat>      m_rotations;
     std::vector<glm::vec3>      m_positions;
     std::vector<glm::vec3>      m_scales;
+
+    // Spherical harmonics bands 1..m_shDegree, per splat shCoeffCount() RGB
+    // triplets (coefficient-major), each byte mapping linearly onto m_shRange
+    int                         m_shMaxDegree = 3;
+    int                         m_shDegree = 0;
+    std::vector<uint8_t>        m_shCoeffs;
+    glm::vec2                   m_shRange = glm::vec2(0.0f);
+
+    float                       m_pruneMinOpacity = 0.0f;
+    float                       m_pruneMinExtent = 0.0f;
+    size_t                      m_pruneMaxCount = 0;
+    SplatPruneStats             m_pruneStats;
+    size_t                      m_generation = 0;
     
     std::vector<SplatBlock>     m_blocks;
-
-    // Sorting cache to avoid reallocation
-    std::vector<std::pair<float, uint32_t>> m_sorter;
+    std::vector<SplatOctreeNode> m_octree;     // root first
+    bool                        m_blocksContiguous = false; // each block is a run of consecutive splats
+
+    // LOD tree: nodes are created bottom-up (children before parents), the
+    // last one is the root. m_lodChildren holds node or splat indices.
+    bool                        m_lodEnabled = false;
+    size_t                      m_lodBudget = 0;
+    float                       m_lodErrorThreshold = 1.0f;
+    size_t                      m_lodProxyStart = 0;
+    std::vector<SplatNode>      m_lodNodes;
+    std::vector<uint32_t>       m_lodChildren;
+    std::vector<std::pair<float, uint32_t>> m_lodHeap;
+
+    // Sorting cache to avoid reallocation. Sized to the splat count once and
+    // reused by every sort; the *Tmp ones are the radix sort scatter targets.
+    SplatSortKey            m_sortKey = SORT_KEY_32BITS;
+    std::vector<float>      m_sortDepths;
+    std::vector<float>      m_sortDepthsTmp;
+    std::vector<uint32_t>   m_sortKeys;
+    std::vector<uint32_t>   m_sortValues;
+    std::vector<uint32_t>   m_sortKeysTmp;
+    std::vector<uint32_t>   m_sortValuesTmp;
+
+    // Previous order, for the incremental re-sort. m_sortSlot is per-splat
+    // scratch matching it against the splats visible now (kept all zeros).
+    bool                    m_incrementalSort = true;
+    float                   m_incrementalSortThreshold = 0.05f;
+    bool                    m_sortPreviousValid = false;
+    float                   m_sortDepthRange = 0.0f;
+    std::vector<uint32_t>   m_sortPrevious;
+    std::vector<uint32_t>   m_sortSlot;
+    std::vector<uint8_t>    m_sortVisible;
+
+    // Software occlusion scratch, owned by whichever thread sorts: an NDC
+    // depth buffer of the occluders (nearest wins), the farthest depth of
+    // each of its tiles, and how many sorts in a row each block was hidden
+    std::vector<float>      m_occlusionDepth;
+    std::vector<float>      m_occlusionTileMax;
+    std::vector<uint8_t>    m_occlusionHiddenSorts;
+    std::vector<uint8_t>    m_sortOccluded;     // scratch for the synchronous path
+    std::vector<uint8_t>    m_occludedBlocks;   // blocks culled by the drawn order
 
     std::vector<float>      m_depthFloatIndex;
     std::vector<uint32_t>   m_depthUintIndex;
@@ -130,11 +469,64 @@ private:
     // which may already have been consumed elsewhere earlier in the frame.
     glm::mat4               m_lastSortViewProj = glm::mat4(0.0f);
     bool                    m_hasSorted = false;
-
-
-    std::vector<float>      m_worldPositions;   // Only needed for sorting
+    size_t                  m_multiViewFrame = 0;   // multi-view frame last sorted in
+
+    // Set whenever a new order gets published, so the shared index VBO is
+    // only re-uploaded when it actually changed (not once per pass/frame).
+    bool                    m_indexDirty = true;
+    int                     m_indexUploadVersion = 0;
+
+    // Async sort worker state. Everything below m_sortMutex is shared with
+    // the worker and only touched while holding it.
+    bool                    m_asyncSort = false;
+    int                     m_sortMaxStaleness = -1;
+    size_t                  m_sortRequestTicket = 0;
+    size_t                  m_sortPublishedTicket = 0;
+    std::vector<uint32_t>   m_sortOrder;        // scratch for the synchronous path
+    std::thread             m_sortThread;
+    std::mutex              m_sortMutex;
+    std::condition_variable m_sortCondition;
+    glm::mat4               m_sortRequestViewProj = glm::mat4(1.0f);
+    float                   m_sortRequestViewportHeight = 0.0f;
+    bool                    m_sortRequestOcclusion = true;
+    size_t                  m_sortPendingTicket = 0;
+    std::vector<uint32_t>   m_sortBack;         // finished order waiting to be published
+    std::vector<uint8_t>    m_sortBackOccluded;
+    size_t                  m_sortBackTicket = 0;
+    bool                    m_sortPending = false;
+    bool                    m_sortBusy = false;
+    bool                    m_sortReady = false;
+    bool                    m_sortExit = false;
+
+
+    // Structure-of-arrays copy of m_positions read by the depth kernel,
+    // refreshed by the next sort whenever the splats changed
+    std::vector<float>      m_sortX;
+    std::vector<float>      m_sortY;
+    std::vector<float>      m_sortZ;
+    bool                    m_sortPositionsDirty = true;
 
     Texture*                m_texture = nullptr;
+    Texture*                m_shTexture = nullptr;
+    int                     m_textureVersion = 0;   // shader version m_texture was packed for
+    size_t                  m_dirtyBegin = 0;       // splats changed since the last upload
+    size_t                  m_dirtyEnd = 0;
+
+    // Progressive loader state. Everything below m_loadMutex is shared with
+    // the loader thread and only touched while holding it.
+    bool                    m_progressiveLoad = false;
+    size_t                  m_loadBatchSize = 65536;
+    size_t                  m_loadTotal = 0;        // render thread copy of m_loadFileTotal
+    std::thread             m_loadThread;
+    std::mutex              m_loadMutex;
+    std::condition_variable m_loadCondition;
+    std::deque<SplatBatch>  m_loadQueue;
+    size_t                  m_loadFileTotal = 0;
+    int                     m_loadSHDegree = 0;
+    glm::vec2               m_loadSHRange = glm::vec2(0.0f);
+    std::string             m_loadError;
+    bool                    m_loadDone = false;
+    bool                    m_loadCancel = false;
     Shader*                 m_shader = nullptr;
 
     // Buffers (shared between the color and normal-buffer VAOs)
@@ -161,13 +553,67 @@ private:
     GLuint                  m_depthVao = 0;
     GLint                   m_depthPosition = -1;
     GLint                   m_depthIndex = -1;
+};
 
-    // Private depth-only FBO used exclusively by performOcclusionQuery() --
-    // see ensureOcclusionFbo().
-    GLuint                  m_occlusionFbo = 0;
-    GLuint                  m_occlusionDepthTex = 0;
-    int                     m_occlusionFboWidth = 0;
-    int                     m_occlusionFboHeight = 0;
+// Draws several Gsplats as one. Their splats are merged into a single
+// world-space copy (positions, covariances and SH rotated by each source's
+// matrix), so a scene of several splat models is sorted once and blended
+// correctly across models in one draw, instead of one sort and one draw per
+// model composited in draw order. The copy is rebuilt only when a source is
+// added, removed or resized. A source whose matrix changes has its range
+// transformed in place (moveSource()): the blocks are refit and only its
+// rows uploaded, and the spatial index is rebuilt once the refit blocks
+// have grown past COMPOSITOR_REINDEX_AREA times their area when it was
+// built. Sources drawn through a compositor should not also be rendered on
+// their own.
+class GsplatCompositor {
+public:
+    GsplatCompositor() {}
+    virtual ~GsplatCompositor() {}
+
+    void    add(Gsplat* _gsplat, const glm::mat4& _matrix = glm::mat4(1.0f));
+    // Follows the model's transform and Gsplat
+    void    add(Model* _model);
+    void    add(const std::map<std::string, Model*>& _models);
+    void    clear();
+    // Forces a re-merge
+    void    invalidate() { m_dirty = true; }
+    size_t  getSourceCount() const { return m_sources.size(); }
+
+    void    use(Shader* _shader) { m_merged.use(_shader); }
+    void    render(Camera* _camera, bool _sort = false);
+    void    renderNormal(Camera* _camera, bool _sort = false);
+    void    renderDepth(Camera* _camera, bool _sort = false);
+
+    // The merged splats, for their sort, LOD and culling settings
+    Gsplat& getGsplat() { update(); return m_merged; }
+
+private:
+    struct Source {
+        Gsplat*     gsplat;
+        Model*      model;
+        glm::mat4   matrix;
+        Gsplat*     mergedGsplat = nullptr;
+        glm::mat4   mergedMatrix;
+        size_t      mergedCount = 0;
+        size_t      mergedFirst = 0;    // where its range starts in m_merged
+        size_t      mergedGeneration = 0;
+    };
+
+    // Re-merges the sources when any of them was added, removed or resized,
+    // and only transforms again the ranges of the ones whose matrix or
+    // content (at the same size) changed
+    void    update();
+    // Whether a source edited or reloaded at the same size can be transformed
+    // in place: its SH bands must fit the merged degree and range
+    bool    fitsMerged(const Gsplat* _gsplat) const;
+    // Surface area summed over the merged splat blocks
+    float   blocksArea() const;
+
+    std::vector<Source> m_sources;
+    Gsplat              m_merged;
+    float               m_mergedArea = 0.0f;    // blocksArea() when the index was built
+    bool                m_dirty = true;
 };
 
 }
\ No newline at end of file
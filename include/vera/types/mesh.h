@@ -38,7 +38,7 @@ public:
     DrawMode            getDrawMode() const { return m_drawMode; }
 
     void                setMaterial(Material* _material) { m_material = _material; }
-    Material*           getMaterial() { return m_material; }
+    Material*           getMaterial() const { return m_material; }
     bool                haveMaterial() const { return m_material != nullptr; }
 
     // VERTICES
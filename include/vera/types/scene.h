@@ -18,6 +18,7 @@
 #include "light.h"
 #include "camera.h"
 #include "model.h"
+#include "sceneBVH.h"
 #include "material.h"
 #include "label.h"
 
@@ -125,6 +126,16 @@ public:
     // a single geometry file without disturbing the others.
     virtual void        removeModelsByPrefix(const std::string& _prefix);
 
+    // Closest model triangle along a ray (models without triangles are
+    // skipped), through a SceneBVH brought up to date on every call: adding
+    // or removing models rebuilds its top level, moving them refits it
+    virtual bool        raycast(const Ray& _ray, SceneHit& _hit, float _maxDistance = std::numeric_limits<float>::max());
+    virtual Model*      raycast(const Ray& _ray);
+    // Model under a pixel of the active camera (nullptr if none). _x and _y
+    // are pixels from the top left of its viewport, like getMouseX() and
+    // getMouseY() when the viewport covers the window.
+    virtual Model*      pick(float _x, float _y, SceneHit* _hit = nullptr);
+
     // Node Tree
     std::vector<Node*>  root;
 
@@ -161,6 +172,8 @@ protected:
     bool                m_changed;
     bool                m_haveLights = false;
 
+    SceneBVH            m_modelsBVH;
+
 };
 
 }
\ No newline at end of file
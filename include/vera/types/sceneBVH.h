@@ -0,0 +1,70 @@
+#pragma once
+
+#include "vera/types/bvh.h"
+#include "vera/types/model.h"
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace vera {
+
+// Result of SceneBVH::intersect(): the BVHHit in the model's mesh (triangle
+// is a face of TriangleSoup(model->mesh)) plus the model and, in world
+// space, the point and face normal hit
+struct SceneHit : public BVHHit {
+    Model*      model = nullptr;
+    glm::vec3   position = glm::vec3(0.0f);
+    glm::vec3   normal = glm::vec3(0.0f);
+};
+
+// Two levels of BVH over the triangle meshes of a set of models: a top
+// level over their world bounds (Model::getBoundingBox() through the model
+// matrix) with up to two models per leaf, and a BVH per mesh in its own
+// space, built the first time a ray reaches it. Moving a model only refits
+// the top level.
+class SceneBVH {
+public:
+    SceneBVH();
+    virtual ~SceneBVH();
+
+    // Catch up with _models: the top level is built again when models were
+    // added, removed or replaced their mesh, and refit when they only moved
+    virtual void            update(const ModelsMap& _models);
+    virtual void            clear();
+
+    // Drop the mesh BVH of _model, to build it again after its mesh was
+    // edited in place (a new mesh of another size is noticed by update())
+    virtual void            invalidate(const Model* _model);
+
+    // Closest hit within [0, _maxDistance], over the models of the last
+    // update()
+    virtual bool            intersect(const Ray& _ray, SceneHit& _hit, float _maxDistance = std::numeric_limits<float>::max());
+
+    size_t                  getModelsTotal() const { return m_instances.size(); }
+    const std::vector<BVHNode>& getNodes() const { return m_nodes; }
+
+protected:
+    struct Instance {
+        Model*                  model = nullptr;
+        glm::mat4               matrix;         // as of the last update()
+        glm::mat4               inverse;
+        BoundingBox             localBounds;    // Model::getBoundingBox() as of the last update()
+        BoundingBox             bounds;         // in world space
+        size_t                  vertices = 0;   // mesh sizes, to notice a new mesh
+        size_t                  indices = 0;
+        std::shared_ptr<BVH>    bvh;            // built on the first ray that reaches it
+    };
+
+    void                    _build();
+    void                    _build(size_t _begin, size_t _end);
+    void                    _refit();
+    float                   _cost() const;
+
+    std::vector<Instance>   m_instances;    // in ModelsMap order
+    std::vector<uint32_t>   m_order;        // instance of each leaf slot
+    std::vector<BVHNode>    m_nodes;        // same layout as BVH::getNodes()
+    float                   m_buildCost = 0.0f;
+};
+
+}
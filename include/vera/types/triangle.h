@@ -65,6 +65,7 @@ public :
     Material*           material = nullptr;
     // size_t              getClosestCoorner(const glm::vec3& _p) const;
     glm::vec3           getClosestPoint(const glm::vec3& _p) const;
+    static glm::vec3    getClosestPoint(const glm::vec3& _v0, const glm::vec3& _v1, const glm::vec3& _v2, const glm::vec3& _p);
     float               getClosestDistance(const glm::vec3& _p) const;
     float               getClosestSignedDistance(const glm::vec3& _p) const;
     glm::vec4           getClosestRGBSignedDistance(const glm::vec3& _p) const;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include "glm/glm.hpp"
+#include "vera/types/triangle.h"
+#include "vera/types/material.h"
+
+namespace vera {
+
+class Mesh;
+
+// Indexed triangles with one flat array per vertex attribute, for spatial
+// queries (BVH, intersection(), toSdf()) over large meshes: where a
+// std::vector<Triangle> holds a full Triangle (with its own attribute
+// vectors) per face, this holds a few arrays for the whole mesh. Colors,
+// normals, texcoords and tangents are optional (empty or one per vertex),
+// materials are one for all faces or one per face.
+class TriangleSoup {
+public:
+
+    TriangleSoup();
+    TriangleSoup(const Mesh& _mesh);
+    TriangleSoup(const std::vector<Triangle>& _triangles);
+
+    void                load(const Mesh& _mesh);
+    void                load(const std::vector<Triangle>& _triangles);
+    void                clear();
+
+    // Appends face _face of _soup (its three vertices are copied, not shared)
+    void                addFace(const TriangleSoup& _soup, size_t _face);
+    void                addFace(uint32_t _i0, uint32_t _i1, uint32_t _i2) { faces.push_back(glm::uvec3(_i0, _i1, _i2)); }
+
+    size_t              size() const { return faces.size(); }
+    bool                empty() const { return faces.empty(); }
+
+    // 64-bit hash of positions and faces (what a BVH over them depends on),
+    // to tell whether a cached one still matches
+    uint64_t            getHash() const;
+
+    // Per face, as Triangle computes them
+    const glm::vec3&    getVertex(size_t _face, size_t _index) const { return positions[faces[_face][_index]]; }
+    glm::vec3           getCentroid(size_t _face) const { return (getVertex(_face, 0) + getVertex(_face, 1) + getVertex(_face, 2)) * 0.3333333333333f; }
+    glm::vec3           getMin(size_t _face) const { return glm::min(getVertex(_face, 0), glm::min(getVertex(_face, 1), getVertex(_face, 2))); }
+    glm::vec3           getMax(size_t _face) const { return glm::max(getVertex(_face, 0), glm::max(getVertex(_face, 1), getVertex(_face, 2))); }
+    glm::vec3           getNormal(size_t _face) const;
+    glm::vec3           getBarycentricOf(size_t _face, const glm::vec3& _p) const;
+
+    bool                haveColors() const { return !colors.empty(); }
+    bool                haveNormals() const { return !normals.empty(); }
+    bool                haveTexCoords() const { return !texCoords.empty(); }
+    bool                haveTangents() const { return !tangents.empty(); }
+    bool                haveMaterial() const { return material != nullptr || !materials.empty(); }
+    Material*           getMaterial(size_t _face) const { return materials.empty() ? material : materials[_face]; }
+
+    // Interpolated at barycentric coordinates of a face
+    glm::vec4           getColor(size_t _face, const glm::vec3& _barycenterCoord) const;
+    glm::vec3           getNormal(size_t _face, const glm::vec3& _barycenterCoord) const;
+    glm::vec2           getTexCoord(size_t _face, const glm::vec3& _barycenterCoord) const;
+    glm::vec4           getTangent(size_t _face, const glm::vec3& _barycenterCoord) const;
+
+    glm::vec3           getClosestPoint(size_t _face, const glm::vec3& _p) const;
+    float               getClosestDistance(size_t _face, const glm::vec3& _p) const;
+    float               getClosestSignedDistance(size_t _face, const glm::vec3& _p) const;
+    glm::vec4           getClosestRGBSignedDistance(size_t _face, const glm::vec3& _p) const;
+
+    // Materializes a face (for code that still takes Triangles)
+    Triangle            getTriangle(size_t _face) const;
+
+    std::vector<glm::vec3>  positions;
+    std::vector<glm::vec4>  colors;
+    std::vector<glm::vec3>  normals;
+    std::vector<glm::vec2>  texCoords;
+    std::vector<glm::vec4>  tangents;
+    std::vector<glm::uvec3> faces;          // vertex indices
+
+    Material*               material = nullptr;
+    std::vector<Material*>  materials;      // per face, when they differ
+};
+
+}
@@ -16,6 +16,10 @@
 #include "webxr.h"
 #endif
 
+#ifdef SUPPORT_GSPLAT
+#include "vera/types/gsplat.h"
+#endif
+
 namespace vera {
 
 #if defined(__EMSCRIPTEN__)
@@ -282,6 +286,21 @@ void App::run(WindowProperties _properties) {
 
             glm::vec3 cam_pos = cam->getPosition();
             glm::vec3 head_pos = glm::make_vec3(_headPose->position);
+
+#ifdef SUPPORT_GSPLAT
+            // Both eyes share one splat sort, done from between them (first
+            // eye's orientation and projection)
+            if (_viewCount > 1) {
+                glm::vec3 center_pos = glm::vec3(0.0f);
+                for(int viewIndex = 0; viewIndex < _viewCount; viewIndex++)
+                    center_pos += glm::make_vec3(_views[viewIndex].viewPose.position);
+                center_pos = center_pos / float(_viewCount) + head_pos;
+                glm::mat4 t = glm::translate(glm::mat4(1.), center_pos);
+                glm::mat4 r = glm::toMat4( glm::quat(_views[0].viewPose.orientation[3], _views[0].viewPose.orientation[0], _views[0].viewPose.orientation[1], _views[0].viewPose.orientation[2]) );
+                Gsplat::beginMultiView( t * r, glm::make_mat4(_views[0].projectionMatrix), 1.2f );
+            }
+#endif
+
             for(int viewIndex = 0; viewIndex < _viewCount; viewIndex++) {
                 WebXRView view = _views[ viewIndex];
                 glViewport( view.viewport[0], view.viewport[1], view.viewport[2], view.viewport[3] );
@@ -294,6 +313,10 @@ void App::run(WindowProperties _properties) {
                 _app->draw();
             } 
 
+#ifdef SUPPORT_GSPLAT
+            Gsplat::endMultiView();
+#endif
+
             renderGL();
 
             cam->setPosition(cam_pos);
@@ -18,6 +18,9 @@
 #include <windows.h>
 #else
 #include "glob.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 
@@ -442,6 +445,40 @@ std::vector<std::string> glob(const std::string& _pattern) {
     return files;
 }
 
+MappedFile::MappedFile(const std::string& _filepath) {
+#if defined(_WIN32)
+    std::ifstream file(_filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return;
+    m_buffer.resize((size_t)file.tellg());
+    file.seekg(0, std::ios::beg);
+    if (!file.read(m_buffer.data(), m_buffer.size()))
+        return;
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#else
+    int fd = ::open(_filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const char*>(data);
+            m_size = (size_t)st.st_size;
+        }
+    }
+    ::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if !defined(_WIN32)
+    if (m_data)
+        ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+}
+
 
 static const std::string base64_chars =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
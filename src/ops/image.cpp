@@ -16,6 +16,7 @@
 #include "vera/ops/geom.h"
 #include "vera/ops/string.h"
 #include "vera/ops/intersection.h"
+#include "vera/ops/parallel.h"
 
 #define	RED_WEIGHT	    0.299
 #define GREEN_WEIGHT	0.587
@@ -590,11 +591,27 @@ Image fade(const Image& _A, const Image& _B, float _pct) {
     return out;
 }
 
-Image   toSdf(const Mesh& _mesh, float _paddingPct, int _resolution) {
+// toSdf(Mesh) works on cells of voxels, SDF_CELL wide at first. A cell off
+// the narrow band (SDF_BAND voxels around the triangles) is interpolated
+// from exact distances at its corners, when the voxels it is checked
+// against are within SDF_TOLERANCE voxels of it. Cells on the band, or that
+// don't interpolate well (close to the surface, or crossed by a ridge of the
+// field), split in eight down to SDF_CELL_MIN wide, and then get exact
+// distances voxel by voxel.
+static const int    SDF_CELL        = 8;
+static const int    SDF_CELL_MIN    = 4;
+static const float  SDF_BAND        = 2.0f;
+static const float  SDF_TOLERANCE   = 0.25f;
+static const size_t SDF_BATCH       = 1 << 20;  // points per batched query
+
+Image   toSdf(const Mesh& _mesh, float _paddingPct, int _resolution, const std::string& _bvhCachePath) {
     Mesh mesh = _mesh;
     center(mesh);
-    std::vector<Triangle> tris = mesh.getTriangles();
-    BVH acc(tris, vera::SPLIT_MIDPOINT);
+    BVH acc;
+    if (_bvhCachePath.empty())
+        acc.load(TriangleSoup(mesh), vera::SPLIT_MIDPOINT);
+    else
+        acc.load(TriangleSoup(mesh), vera::SPLIT_MIDPOINT, _bvhCachePath);
 
     acc.square();
 
@@ -604,122 +621,242 @@ Image   toSdf(const Mesh& _mesh, float _paddingPct, int _resolution) {
 
     int    voxel_resolution = std::pow(2, _resolution);
     float        voxel_size = 1.0/float(voxel_resolution);
-    int         layersTotal = std::sqrt(voxel_resolution);
+    int         layersTotal = std::ceil(std::sqrt(voxel_resolution));
     int    image_resolution = voxel_resolution * layersTotal;
 
     Image rta;
     rta.allocate(image_resolution, image_resolution, 1);
 
-    const int nThreads  = std::thread::hardware_concurrency();
-    int layersPerThread = voxel_resolution / nThreads;
-    int layersLeftOver  = voxel_resolution % nThreads;
     max_dist *= 0.5f;
 
-    std::vector<std::thread> threads;
-    for (int i = 0; i < nThreads; ++i) {
-        int start_layer = i * layersPerThread;
-        int end_layer = start_layer + layersPerThread;
-        if (i == nThreads - 1)
-            end_layer = start_layer + layersPerThread + layersLeftOver;
+    // for each voxel convert it into a point in the space containing a mesh
+    glm::vec3   voxel       = bdiagonal * voxel_size;
+    glm::vec3   origin      = acc.min;
+    auto position = [&](const glm::ivec3& _voxel) {
+        return origin + glm::vec3(_voxel) * voxel;
+    };
+    auto store = [&](const glm::ivec3& _voxel, float _distance) {
+        size_t layerX = (_voxel.z % layersTotal) * voxel_resolution;
+        size_t layerY = (_voxel.z / layersTotal) * voxel_resolution;
+        rta.setValue(rta.getIndex(layerX + _voxel.x, layerY + _voxel.y), glm::clamp(_distance/max_dist, -1.0f, 1.0f) * 0.5f + 0.5f);
+    };
+
+    // Grids too small to have cells off the band are all exact
+    int cellMax = SDF_CELL;
+    int cellMin = SDF_CELL_MIN;
+    if (voxel_resolution < SDF_CELL * 4)
+        cellMax = cellMin = voxel_resolution;
+
+    // Band map, one flag per smallest cell: the ones a triangle, grown by the
+    // band, reaches (by its bounds and plane)
+    int cells = voxel_resolution / cellMin;
+    std::vector<uint8_t> band((size_t)cells * cells * cells, cellMax == cellMin ? 1 : 0);
+    float reach = cellMin * 0.8660254f + SDF_BAND;
+    for (size_t f = 0; f < acc.elements.size() && cellMax != cellMin; f++) {
+        glm::vec3 v0 = (acc.elements.getVertex(f, 0) - origin) / voxel;
+        glm::vec3 v1 = (acc.elements.getVertex(f, 1) - origin) / voxel;
+        glm::vec3 v2 = (acc.elements.getVertex(f, 2) - origin) / voxel;
+        glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+        float area = glm::length(normal);
+        if (area > 0.0f)
+            normal /= area;
+
+        glm::ivec3 lo = glm::clamp(glm::ivec3(glm::floor((glm::min(v0, glm::min(v1, v2)) - SDF_BAND) / float(cellMin))), 0, cells - 1);
+        glm::ivec3 hi = glm::clamp(glm::ivec3(glm::floor((glm::max(v0, glm::max(v1, v2)) + SDF_BAND) / float(cellMin))), 0, cells - 1);
+        for (int z = lo.z; z <= hi.z; z++)
+        for (int y = lo.y; y <= hi.y; y++)
+        for (int x = lo.x; x <= hi.x; x++) {
+            glm::vec3 middle = (glm::vec3(x, y, z) + 0.5f) * float(cellMin);
+            if (area == 0.0f || std::abs(glm::dot(normal, middle - v0)) <= reach)
+                band[((size_t)z * cells + y) * cells + x] = 1;
+        }
+    }
+    auto onBand = [&](const glm::ivec3& _cell, int _size) {
+        for (int z = 0; z < _size; z += cellMin)
+        for (int y = 0; y < _size; y += cellMin)
+        for (int x = 0; x < _size; x += cellMin) {
+            glm::ivec3 c = (_cell + glm::ivec3(x, y, z)) / cellMin;
+            if (band[((size_t)c.z * cells + c.y) * cells + c.x])
+                return true;
+        }
+        return false;
+    };
+
+    // Exact distances on cell corners, shared by the cells around them
+    int corners = cells + 1;
+    std::vector<float> lattice((size_t)corners * corners * corners, 0.0f);
+    std::vector<uint8_t> sampled(lattice.size(), 0);
+    auto corner = [&](const glm::ivec3& _voxel) {
+        glm::ivec3 c = _voxel / cellMin;
+        return ((size_t)c.z * corners + c.y) * corners + c.x;
+    };
+
+    std::vector<glm::ivec3> level;
+    for (int z = 0; z < voxel_resolution; z += cellMax)
+    for (int y = 0; y < voxel_resolution; y += cellMax)
+    for (int x = 0; x < voxel_resolution; x += cellMax)
+        level.push_back(glm::ivec3(x, y, z));
+
+    std::vector<glm::ivec3> exact;
+    std::vector<glm::ivec3> next;
+    std::vector<glm::ivec3> tried;
+    std::vector<glm::vec3>  points;
+    std::vector<size_t>     requested;
+    std::vector<float>      distances;
+    std::vector<uint8_t>    interpolated;
+    for (int size = cellMax; !level.empty(); size /= 2) {
+        next.clear();
+        tried.clear();
+        auto split = [&](const glm::ivec3& _cell) {
+            if (size == cellMin) {
+                exact.push_back(_cell);
+                return;
+            }
+            int half = size / 2;
+            for (int i = 0; i < 8; i++)
+                next.push_back(_cell + glm::ivec3((i & 1) ? half : 0, (i & 2) ? half : 0, (i & 4) ? half : 0));
+        };
+
+        for (const glm::ivec3& cell : level) {
+            if (onBand(cell, size))
+                split(cell);
+            else
+                tried.push_back(cell);
+        }
 
-        std::thread t(
-            [&acc, &rta, start_layer, end_layer, voxel_resolution, voxel_size, layersTotal, bdiagonal, max_dist ]() {
-                for (int z = start_layer; z < end_layer; z++)
-                for (int y = 0; y < voxel_resolution; y++)
-                for (int x = 0; x < voxel_resolution; x++) {
-                    // for each voxel convert it into a point in the space containing a mesh
-                    glm::vec3 p = glm::vec3(x, y, z) * voxel_size;
-                    p = acc.min + p * bdiagonal;
-
-                    glm::vec4 c = acc.getClosestRGBSignedDistance(p);
-                    c.a = glm::clamp(c.a/max_dist, -1.0f, 1.0f) * 0.5 + 0.5;
-
-                    size_t layerX = (z % layersTotal) * voxel_resolution; 
-                    size_t layerY = floor(z / layersTotal) * voxel_resolution;
-                    rta.setColor(rta.getIndex(layerX + x, layerY + y), c);
+        // The corners not sampled yet, then a voxel in each octant of each cell
+        points.clear();
+        requested.clear();
+        for (const glm::ivec3& cell : tried)
+            for (int i = 0; i < 8; i++) {
+                glm::ivec3 v = cell + glm::ivec3((i & 1) ? size : 0, (i & 2) ? size : 0, (i & 4) ? size : 0);
+                size_t c = corner(v);
+                if (!sampled[c]) {
+                    sampled[c] = 1;
+                    requested.push_back(c);
+                    points.push_back(position(v));
                 }
             }
-        );
-        threads.push_back(std::move(t));
+        int probeA = size / 4;
+        int probeB = size - probeA;
+        for (const glm::ivec3& cell : tried)
+            for (int i = 0; i < 8; i++)
+                points.push_back(position(cell + glm::ivec3((i & 1) ? probeB : probeA, (i & 2) ? probeB : probeA, (i & 4) ? probeB : probeA)));
+
+        acc.getClosestSignedDistances(points, distances);
+        for (size_t i = 0; i < requested.size(); i++)
+            lattice[requested[i]] = distances[i];
+        const float* probes = distances.data() + requested.size();
+
+        // Fill the cells that interpolate well, over all cores
+        float tolerance = SDF_TOLERANCE * std::min(voxel.x, std::min(voxel.y, voxel.z));
+        interpolated.assign(tried.size(), 0);
+        parallelFor(parallelThreads(tried.size(), 16), tried.size(), [&](size_t, size_t _start, size_t _end) {
+            for (size_t t = _start; t < _end; t++) {
+                const glm::ivec3& cell = tried[t];
+                float c[8];
+                bool inside = false, outside = false;
+                for (int i = 0; i < 8; i++) {
+                    c[i] = lattice[corner(cell + glm::ivec3((i & 1) ? size : 0, (i & 2) ? size : 0, (i & 4) ? size : 0))];
+                    inside |= c[i] < 0.0f;
+                    outside |= c[i] >= 0.0f;
+                }
+                if (inside && outside)
+                    continue;
+
+                auto trilinear = [&](int _x, int _y, int _z) {
+                    float fx = float(_x) / size, fy = float(_y) / size, fz = float(_z) / size;
+                    float c00 = glm::mix(c[0], c[1], fx), c10 = glm::mix(c[2], c[3], fx);
+                    float c01 = glm::mix(c[4], c[5], fx), c11 = glm::mix(c[6], c[7], fx);
+                    return glm::mix(glm::mix(c00, c10, fy), glm::mix(c01, c11, fy), fz);
+                };
+
+                bool agree = true;
+                for (int i = 0; i < 8 && agree; i++)
+                    agree = std::abs(probes[t * 8 + i] - trilinear((i & 1) ? probeB : probeA, (i & 2) ? probeB : probeA, (i & 4) ? probeB : probeA)) <= tolerance;
+                if (!agree)
+                    continue;
+
+                interpolated[t] = 1;
+                for (int z = 0; z < size; z++)
+                for (int y = 0; y < size; y++)
+                for (int x = 0; x < size; x++)
+                    store(cell + glm::ivec3(x, y, z), trilinear(x, y, z));
+            }
+        });
+
+        for (size_t t = 0; t < tried.size(); t++)
+            if (!interpolated[t])
+                split(tried[t]);
+        level.swap(next);
     }
 
-    for (std::thread& t : threads)
-        t.join();
+    // Everything else voxel by voxel, the voxels of a cell next to each
+    // other for the batched query
+    size_t cellVoxels = (size_t)cellMin * cellMin * cellMin;
+    size_t perBatch = std::max((size_t)1, SDF_BATCH / cellVoxels);
+    for (size_t first = 0; first < exact.size(); first += perBatch) {
+        size_t count = std::min(perBatch, exact.size() - first);
+        points.resize(count * cellVoxels);
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3* p = &points[i * cellVoxels];
+            for (int z = 0; z < cellMin; z++)
+            for (int y = 0; y < cellMin; y++)
+            for (int x = 0; x < cellMin; x++)
+                *p++ = position(exact[first + i] + glm::ivec3(x, y, z));
+        }
+
+        acc.getClosestSignedDistances(points, distances);
+
+        for (size_t i = 0; i < count; i++) {
+            const float* d = &distances[i * cellVoxels];
+            for (int z = 0; z < cellMin; z++)
+            for (int y = 0; y < cellMin; y++)
+            for (int x = 0; x < cellMin; x++)
+                store(exact[first + i] + glm::ivec3(x, y, z), *d++);
+        }
+    }
 
     return rta;
 }
 
-Image toSdfLayer( const BVH* _acc, size_t _voxel_resolution, size_t _z_layer, float _refinement) {
+Image toSdfLayer( const BVH* _acc, size_t _voxel_resolution, size_t _z_layer, float _tolerance) {
     float voxel_size    = 1.0/float(_voxel_resolution);
-    int nThreads  = std::thread::hardware_concurrency();
-
-    if (nThreads > _voxel_resolution)
-        nThreads = _voxel_resolution;
-
-    int layersPerThread = _voxel_resolution / nThreads;
-    int layersLeftOver  = _voxel_resolution % nThreads;
     glm::vec3 bdiagonal = _acc->getDiagonal();
     float max_dist      = glm::length(bdiagonal) * 0.5f;
 
     Image layer = Image(_voxel_resolution, _voxel_resolution, 4);
 
-    bool RGBD = _acc->elements[0].haveColors();
-    if (!RGBD && _acc->elements[0].material != nullptr)
-        if (_acc->elements[0].material->haveProperty("diffuse"))
+    bool RGBD = _acc->elements.haveColors();
+    if (!RGBD && _acc->elements.getMaterial(0) != nullptr)
+        if (_acc->elements.getMaterial(0)->haveProperty("diffuse"))
             RGBD = true;
     // RGBD = false;
 
-    std::vector<std::thread> threads;
-    for (int i = 0; i < nThreads; ++i) {
-        int start_row = i * layersPerThread;
-        int end_row = start_row + layersPerThread;
-        if (i == nThreads - 1)
-            end_row = start_row + layersPerThread + layersLeftOver;
-
-
-        if (RGBD) {
-            std::thread t(
-                [_acc, &layer, start_row, end_row, _z_layer, _voxel_resolution, voxel_size, bdiagonal, max_dist, _refinement]() {
-                    for (int y = start_row; y < end_row; y++)
-                    for (int x = 0; x < _voxel_resolution; x++) {
-                        glm::vec3 p = (glm::vec3(x, y, _z_layer) + 0.5f) * voxel_size;
-                        p = _acc->min + p * bdiagonal;
-
-                        glm::vec4 c = _acc->getClosestRGBSignedDistance(p, max_dist * _refinement);
-
-                        c.a = glm::clamp(c.a/max_dist, -1.0f, 1.0f) * 0.5 + 0.5;
-                        size_t index = layer.getIndex(x, y);
-
-                        layer.setColor(index, c);
-                    }
-                }
-            );
-            threads.push_back(std::move(t));
-        }
-        else {
-            std::thread t(
-                [_acc, &layer, start_row, end_row, _z_layer, _voxel_resolution, voxel_size, bdiagonal, max_dist, _refinement]() {
-                    for (int y = start_row; y < end_row; y++)
-                    for (int x = 0; x < _voxel_resolution; x++) {
-
-                        glm::vec3 p = (glm::vec3(x, y, _z_layer) + 0.5f) * voxel_size;
-                        p = _acc->min + p * bdiagonal;
-
-                        glm::vec4 c = glm::vec4( 1.0f, 1.0f, 1.0f, _acc->getClosestSignedDistance(p, max_dist * _refinement) );
-
-                        c.a = glm::clamp(c.a/max_dist, -1.0f, 1.0f) * 0.5 + 0.5;
-                        size_t index = layer.getIndex(x, y);
+    std::vector<glm::vec3> points(_voxel_resolution * _voxel_resolution);
+    for (size_t y = 0; y < _voxel_resolution; y++)
+    for (size_t x = 0; x < _voxel_resolution; x++) {
+        glm::vec3 p = (glm::vec3(x, y, _z_layer) + 0.5f) * voxel_size;
+        points[y * _voxel_resolution + x] = _acc->min + p * bdiagonal;
+    }
 
-                        layer.setColor(index, c);
-                    }
-                }
-            );
-            threads.push_back(std::move(t));
-        }
+    std::vector<glm::vec4> rgbd;
+    if (RGBD)
+        _acc->getClosestRGBSignedDistances(points, rgbd, nullptr, max_dist * _tolerance);
+    else {
+        std::vector<float> distances;
+        _acc->getClosestSignedDistances(points, distances, nullptr, max_dist * _tolerance);
+        rgbd.resize(distances.size());
+        for (size_t i = 0; i < distances.size(); i++)
+            rgbd[i] = glm::vec4( 1.0f, 1.0f, 1.0f, distances[i] );
     }
 
-    for (std::thread& t : threads)
-        t.join();
+    for (size_t y = 0; y < _voxel_resolution; y++)
+    for (size_t x = 0; x < _voxel_resolution; x++) {
+        glm::vec4 c = rgbd[y * _voxel_resolution + x];
+        c.a = glm::clamp(c.a/max_dist, -1.0f, 1.0f) * 0.5 + 0.5;
+        layer.setColor(layer.getIndex(x, y), c);
+    }
 
     return layer;
 }
@@ -771,8 +908,8 @@ void refineSdfLayers(const BVH* _acc, std::vector<Image>& _images, float _dist)
                     // glm::vec3 p = (glm::vec3(x, y, _z_layer) + 0.5f) * voxel_size;
                     // p = _acc->min + p * bdiagonal;
 
-                    glm::vec3 p = _acc->elements[t].getCentroid();
-                    p = p + (_acc->elements[t].getNormal() * max_dist * _dist) + samples[t%64] * max_dist * _dist * 0.5f;
+                    glm::vec3 p = _acc->elements.getCentroid(t);
+                    p = p + (_acc->elements.getNormal(t) * max_dist * _dist) + samples[t%64] * max_dist * _dist * 0.5f;
 
                     if (_acc->contains(p)) {
                         glm::vec4 c = _acc->getClosestRGBSignedDistance(p);
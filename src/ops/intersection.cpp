@@ -169,9 +169,9 @@ IntersectionData intersection(const Ray& _ray, const BoundingBox& _bbox) {
 
 // MOLLER_TRUMBORE
 // #define CULLING
-bool intersection(const Ray& _ray, const Triangle& _triangle, float& _t, float& _u, float& _v) {
-    glm::vec3 v0v1 = _triangle[1] - _triangle[0]; 
-    glm::vec3 v0v2 = _triangle[2] - _triangle[0]; 
+bool intersection(const Ray& _ray, const glm::vec3& _v0, const glm::vec3& _v1, const glm::vec3& _v2, float& _t, float& _u, float& _v) {
+    glm::vec3 v0v1 = _v1 - _v0; 
+    glm::vec3 v0v2 = _v2 - _v0; 
     glm::vec3 pvec = glm::cross(_ray.getDirection(), v0v2); 
     float det = glm::dot(v0v1, pvec); 
 
@@ -186,7 +186,7 @@ bool intersection(const Ray& _ray, const Triangle& _triangle, float& _t, float&
 
     float invDet = 1.0f / det; 
  
-    glm::vec3 tvec = _ray.getOrigin() - _triangle[0]; 
+    glm::vec3 tvec = _ray.getOrigin() - _v0; 
     _u = glm::dot(tvec, pvec) * invDet; 
     if (_u < 0.0f || _u > 1.0f) return false; 
  
@@ -199,6 +199,14 @@ bool intersection(const Ray& _ray, const Triangle& _triangle, float& _t, float&
     return true; // this ray hits the triangle 
 }
 
+bool intersection(const Ray& _ray, const Triangle& _triangle, float& _t, float& _u, float& _v) {
+    return intersection(_ray, _triangle[0], _triangle[1], _triangle[2], _t, _u, _v);
+}
+
+bool intersection(const Ray& _ray, const TriangleSoup& _soup, size_t _face, float& _t, float& _u, float& _v) {
+    return intersection(_ray, _soup.getVertex(_face, 0), _soup.getVertex(_face, 1), _soup.getVertex(_face, 2), _t, _u, _v);
+}
+
 IntersectionData intersection(const Ray& _ray, const Triangle& _triangle) {
 
     IntersectionData idata;
@@ -219,6 +227,18 @@ IntersectionData intersection(const Ray& _ray, const Triangle& _triangle) {
 
 }
 
+IntersectionData intersection(const Ray& _ray, const TriangleSoup& _soup, size_t _face) {
+    IntersectionData idata;
+
+    float t,u,v;
+    idata.hit = intersection(_ray, _soup, _face, t, u, v);
+    if (!idata.hit) return idata;
+
+    idata.distance = t;
+    idata.position = _ray.getAt(t);
+    return idata;
+}
+
 float distance(const glm::vec3& _point, const Plane& _plane) {
     return glm::dot(_plane.getNormal(), _point - _plane.getOrigin());
 }
@@ -0,0 +1,301 @@
+#include "vera/types/aoBaker.h"
+
+#include "vera/ops/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+namespace vera {
+
+// Rays traced per BVH::intersect() call, and per pass of bake()
+static const size_t AO_BATCH_RAYS = 1 << 18;
+static const size_t AO_PASS_SAMPLES = 16;
+
+// Barycentric slack when rasterizing texel centers into UV triangles
+static const float AO_TEXEL_EPSILON = 1e-4f;
+
+// Ray origins are lifted off the surface by this fraction of the bounds
+// diagonal, so they don't hit the triangle they start on
+static const float AO_BIAS = 1e-4f;
+
+// Each point walks the R2 sequence (a 2D golden ratio sequence) from its
+// own random start: well spread samples per point, uncorrelated between
+// neighbours, and the same result for any number of threads
+static inline uint32_t hashPoint(uint32_t _x) {
+    _x ^= _x >> 16;
+    _x *= 0x7feb352dU;
+    _x ^= _x >> 15;
+    _x *= 0x846ca68bU;
+    _x ^= _x >> 16;
+    return _x;
+}
+
+static inline glm::vec2 samplePoint(uint32_t _point, uint32_t _sample) {
+    double u = hashPoint(_point) / 4294967296.0 + _sample * 0.7548776662466927;
+    double v = hashPoint(_point ^ 0x9e3779b9U) / 4294967296.0 + _sample * 0.5698402909980532;
+    return glm::vec2(float(u - std::floor(u)), float(v - std::floor(v)));
+}
+
+// Occlusion estimate within tolerance: 95% Agresti-Coull interval, which
+// stays open for points that so far saw all rays hit or all miss
+static inline bool settled(uint32_t _hits, uint32_t _rays, size_t _minSamples, float _tolerance) {
+    if (_rays < _minSamples)
+        return false;
+    double n = _rays + 4.0;
+    double p = (_hits + 2.0) / n;
+    return 1.96 * std::sqrt(p * (1.0 - p) / n) <= _tolerance;
+}
+
+AOBaker::AOBaker() {
+}
+
+AOBaker::~AOBaker() {
+    clear();
+}
+
+void AOBaker::clear() {
+    m_bvh.clear();
+    m_positions.clear();
+    m_normals.clear();
+    m_texels.clear();
+    m_hits.clear();
+    m_rays.clear();
+    m_pending.clear();
+    m_width = 0;
+    m_height = 0;
+    m_samples = 0;
+}
+
+bool AOBaker::load(const Mesh& _mesh, BakeTarget _target, size_t _width, size_t _height) {
+    clear();
+
+    TriangleSoup soup(_mesh);
+    if (soup.empty())
+        return false;
+
+    if (_target == BAKE_TEXELS && (!soup.haveTexCoords() || _width == 0 || _height == 0)) {
+        std::cout << "ERROR: AOBaker: BAKE_TEXELS needs a mesh with texcoords and a lightmap size" << std::endl;
+        return false;
+    }
+
+    // Area weighted vertex normals when the mesh has none
+    std::vector<glm::vec3> normals = soup.normals;
+    if (normals.empty()) {
+        normals.assign(soup.positions.size(), glm::vec3(0.0f));
+        for (size_t f = 0; f < soup.size(); f++) {
+            const glm::vec3& v0 = soup.getVertex(f, 0);
+            glm::vec3 n = glm::cross(soup.getVertex(f, 1) - v0, soup.getVertex(f, 2) - v0);
+            for (size_t v = 0; v < 3; v++)
+                normals[soup.faces[f][v]] += n;
+        }
+    }
+    for (glm::vec3& n : normals) {
+        float length = glm::length(n);
+        n = (length > 0.0f) ? n / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    m_target = _target;
+    m_bvh.load(soup, SPLIT_SAH);
+    float diagonal = glm::length(m_bvh.getDiagonal());
+    m_maxDistance = diagonal * 0.5f;
+    m_bias = diagonal * AO_BIAS;
+
+    if (_target == BAKE_VERTICES) {
+        m_positions = soup.positions;
+        m_normals = normals;
+    }
+    else {
+        // One point per texel center covered by a UV triangle (the first
+        // one, where they overlap)
+        m_width = _width;
+        m_height = _height;
+        std::vector<uint8_t> taken(m_width * m_height, 0);
+        glm::vec2 size((float)m_width, (float)m_height);
+        for (size_t f = 0; f < soup.size(); f++) {
+            const glm::uvec3& face = soup.faces[f];
+            glm::vec2 uv0 = soup.texCoords[face.x] * size;
+            glm::vec2 uv1 = soup.texCoords[face.y] * size;
+            glm::vec2 uv2 = soup.texCoords[face.z] * size;
+            float area = (uv1.x - uv0.x) * (uv2.y - uv0.y) - (uv2.x - uv0.x) * (uv1.y - uv0.y);
+            if (std::fabs(area) < 1e-12f)
+                continue;
+
+            glm::vec2 lo = glm::min(uv0, glm::min(uv1, uv2));
+            glm::vec2 hi = glm::max(uv0, glm::max(uv1, uv2));
+            int x0 = std::max(0, (int)std::floor(lo.x - 0.5f));
+            int y0 = std::max(0, (int)std::floor(lo.y - 0.5f));
+            int x1 = std::min((int)m_width - 1, (int)std::ceil(hi.x - 0.5f));
+            int y1 = std::min((int)m_height - 1, (int)std::ceil(hi.y - 0.5f));
+            for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) {
+                glm::vec2 p(x + 0.5f, y + 0.5f);
+                float w0 = ((uv1.x - p.x) * (uv2.y - p.y) - (uv2.x - p.x) * (uv1.y - p.y)) / area;
+                float w1 = ((uv2.x - p.x) * (uv0.y - p.y) - (uv0.x - p.x) * (uv2.y - p.y)) / area;
+                float w2 = 1.0f - w0 - w1;
+                if (w0 < -AO_TEXEL_EPSILON || w1 < -AO_TEXEL_EPSILON || w2 < -AO_TEXEL_EPSILON)
+                    continue;
+
+                size_t texel = (size_t)y * m_width + x;
+                if (taken[texel])
+                    continue;
+                taken[texel] = 1;
+
+                m_positions.push_back(soup.positions[face.x] * w0 + soup.positions[face.y] * w1 + soup.positions[face.z] * w2);
+                glm::vec3 n = normals[face.x] * w0 + normals[face.y] * w1 + normals[face.z] * w2;
+                float length = glm::length(n);
+                m_normals.push_back((length > 0.0f) ? n / length : soup.getNormal(f));
+                m_texels.push_back((uint32_t)texel);
+            }
+        }
+    }
+
+    m_hits.assign(m_positions.size(), 0);
+    m_rays.assign(m_positions.size(), 0);
+    m_pending.resize(m_positions.size());
+    std::iota(m_pending.begin(), m_pending.end(), 0);
+    return true;
+}
+
+size_t AOBaker::accumulate(size_t _samples) {
+    if (m_pending.empty() || _samples == 0)
+        return m_pending.size();
+
+    // Rays of a point go next to each other: they start together, which
+    // BVH::intersect() traces best
+    size_t perBatch = std::max((size_t)1, AO_BATCH_RAYS / _samples);
+    std::vector<Ray> rays;
+    std::vector<BVHHit> hits;
+    for (size_t first = 0; first < m_pending.size(); first += perBatch) {
+        size_t count = std::min(perBatch, m_pending.size() - first);
+        size_t nThreads = parallelThreads(count, 64);
+        rays.resize(count * _samples);
+
+        parallelFor(nThreads, count, [&](size_t, size_t _start, size_t _end) {
+            for (size_t i = _start; i < _end; i++) {
+                uint32_t point = m_pending[first + i];
+                const glm::vec3& n = m_normals[point];
+                glm::vec3 origin = m_positions[point] + n * m_bias;
+
+                // Tangent frame around the normal (Duff et al. 2017)
+                float sign = std::copysign(1.0f, n.z);
+                float a = -1.0f / (sign + n.z);
+                float b = n.x * n.y * a;
+                glm::vec3 tangent(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+                glm::vec3 bitangent(b, sign + n.y * n.y * a, -n.y);
+
+                for (size_t k = 0; k < _samples; k++) {
+                    // Cosine weighted: uniform on the disk, lifted onto the hemisphere
+                    glm::vec2 u = samplePoint(point, m_rays[point] + (uint32_t)k);
+                    float r = std::sqrt(u.x);
+                    float phi = 6.2831853f * u.y;
+                    glm::vec3 direction = tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + n * std::sqrt(std::max(0.0f, 1.0f - u.x));
+                    rays[i * _samples + k].set(origin, direction);
+                }
+            }
+        });
+
+        m_bvh.intersect(rays, hits, 0.0f, m_maxDistance, true);
+
+        parallelFor(nThreads, count, [&](size_t, size_t _start, size_t _end) {
+            for (size_t i = _start; i < _end; i++) {
+                uint32_t point = m_pending[first + i];
+                uint32_t occluded = 0;
+                for (size_t k = 0; k < _samples; k++)
+                    occluded += hits[i * _samples + k].hit() ? 1 : 0;
+                m_hits[point] += occluded;
+                m_rays[point] += (uint32_t)_samples;
+            }
+        });
+    }
+    m_samples += _samples;
+
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [&](uint32_t _point) {
+        return settled(m_hits[_point], m_rays[_point], m_minSamples, m_tolerance);
+    }), m_pending.end());
+    return m_pending.size();
+}
+
+size_t AOBaker::bake(size_t _maxSamples) {
+    while (!m_pending.empty() && m_samples < _maxSamples)
+        accumulate(std::min(AO_PASS_SAMPLES, _maxSamples - m_samples));
+    return m_pending.size();
+}
+
+float AOBaker::getValue(size_t _point) const {
+    if (m_rays[_point] == 0)
+        return 1.0f;
+    return 1.0f - float(m_hits[_point]) / float(m_rays[_point]);
+}
+
+Image AOBaker::getImage(size_t _padding) const {
+    Image image;
+    if (m_target != BAKE_TEXELS) {
+        std::cout << "ERROR: AOBaker: getImage() needs points loaded with BAKE_TEXELS" << std::endl;
+        return image;
+    }
+
+    size_t total = m_width * m_height;
+    std::vector<float> values(total, 1.0f);
+    std::vector<uint8_t> covered(total, 0);
+    for (size_t i = 0; i < m_texels.size(); i++) {
+        values[m_texels[i]] = getValue(i);
+        covered[m_texels[i]] = 1;
+    }
+
+    // Each pass, empty texels take the average of their covered neighbours
+    std::vector<uint8_t> next;
+    for (size_t pass = 0; pass < _padding; pass++) {
+        next = covered;
+        for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++) {
+            size_t texel = y * m_width + x;
+            if (covered[texel])
+                continue;
+
+            float sum = 0.0f;
+            int count = 0;
+            for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++) {
+                int nx = (int)x + dx;
+                int ny = (int)y + dy;
+                if (nx < 0 || ny < 0 || nx >= (int)m_width || ny >= (int)m_height)
+                    continue;
+                size_t neighbour = (size_t)ny * m_width + nx;
+                if (covered[neighbour]) {
+                    sum += values[neighbour];
+                    count++;
+                }
+            }
+            if (count > 0) {
+                values[texel] = sum / count;
+                next[texel] = 1;
+            }
+        }
+        covered.swap(next);
+    }
+
+    image.allocate(m_width, m_height, 1);
+    for (size_t i = 0; i < total; i++)
+        image.setValue(i, values[i]);
+    return image;
+}
+
+bool AOBaker::setColors(Mesh& _mesh) const {
+    if (m_target != BAKE_VERTICES || _mesh.getVerticesTotal() != m_positions.size()) {
+        std::cout << "ERROR: AOBaker: setColors() needs the mesh loaded with BAKE_VERTICES" << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec4> colors(m_positions.size());
+    for (size_t i = 0; i < colors.size(); i++) {
+        float value = getValue(i);
+        colors[i] = glm::vec4(value, value, value, 1.0f);
+    }
+    _mesh.clearColors();
+    _mesh.addColors(colors);
+    return true;
+}
+
+}
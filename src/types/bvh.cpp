@@ -1,20 +1,326 @@
 #include "vera/types/bvh.h"
 
 #include "vera/ops/intersection.h"
+#include "vera/ops/parallel.h"
+#include "vera/ops/fs.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <numeric>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define BVH_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define BVH_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 namespace vera {
 
-BVH::BVH() : left(nullptr), right(nullptr), axis(0), leaf(true) {
+// Past this depth nodes are split at the median, which bounds the depth of
+// any tree (and so the traversal stacks) whatever the strategy
+static const size_t BVH_MAX_SPLIT_DEPTH = 48;
+// Deepest tree a build makes: median splits take at most 32 more levels
+// (counts are 32 bits). Traversals keep at most one entry per level, plus
+// the one being visited.
+static const size_t BVH_MAX_DEPTH = BVH_MAX_SPLIT_DEPTH + 32;
+static const size_t BVH_STACK_SIZE = 96;
+static_assert(BVH_MAX_DEPTH < BVH_STACK_SIZE, "BVH traversal stacks must hold the deepest tree");
+static const uint32_t BVH_NONE = std::numeric_limits<uint32_t>::max();
+
+const uint32_t BVHHit::NONE;
+
+// Binned SAH. Costs are in units of one triangle test.
+static const size_t BVH_SAH_BINS = 32;
+static const size_t BVH_MAX_LEAF_SIZE = 8;
+static const float BVH_TRAVERSAL_COST = 1.0f;
+
+// Nodes above this size are binned with several threads; below the task
+// size whole subtrees are built one per thread instead
+static const size_t BVH_PARALLEL_NODE = 1 << 15;
+static const size_t BVH_MIN_TASK = 1 << 12;
+
+// Ray/triangle determinants under this count as parallel (as in intersection())
+static const float BVH_RAY_EPSILON = 1.0e-10f;
+
+// Cache file (see BVH::save()), read back as it was written, so only on
+// machines of the same endianness:
+//
+//   BVHCacheHeader
+//   BVHNode[nodeCount]
+//   uint32_t[elementCount]     primitive order (BVH::m_indices)
+//
+// Bump the version whenever the nodes or the way they are built change.
+static const char       BVH_CACHE_MAGIC[4] = { 'V', 'B', 'V', 'H' };
+static const uint32_t   BVH_CACHE_VERSION = 1;
+
+struct BVHCacheHeader {
+    char        magic[4];
+    uint32_t    version;
+    uint64_t    hash;               // TriangleSoup::getHash() of the elements
+    uint64_t    elementCount;
+    uint64_t    vertexCount;
+    uint32_t    strategy;
+    uint32_t    nodeCount;
+    // BVHStats of the tree, which would take a walk over it to recompute
+    float       sahCost;
+    float       averageLeafSize;
+    uint32_t    leaves;
+    uint32_t    maxDepth;
+    uint32_t    maxLeafSize;
+    uint32_t    reserved;
+};
+
+// Four float lanes and four lane masks (all bits set when true), used to
+// trace rays four at a time
+#if defined(BVH_SIMD_SSE)
+typedef __m128 Lanes;
+typedef __m128 LaneMask;
+static inline Lanes     lanes(float _v) { return _mm_set1_ps(_v); }
+static inline Lanes     lanesLoad(const float* _p) { return _mm_loadu_ps(_p); }
+static inline void      lanesStore(float* _p, Lanes _a) { _mm_storeu_ps(_p, _a); }
+static inline Lanes     add(Lanes _a, Lanes _b) { return _mm_add_ps(_a, _b); }
+static inline Lanes     sub(Lanes _a, Lanes _b) { return _mm_sub_ps(_a, _b); }
+static inline Lanes     mul(Lanes _a, Lanes _b) { return _mm_mul_ps(_a, _b); }
+static inline Lanes     div(Lanes _a, Lanes _b) { return _mm_div_ps(_a, _b); }
+static inline Lanes     lanesMin(Lanes _a, Lanes _b) { return _mm_min_ps(_a, _b); }
+static inline Lanes     lanesMax(Lanes _a, Lanes _b) { return _mm_max_ps(_a, _b); }
+static inline Lanes     abs(Lanes _a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), _a); }
+static inline Lanes     sqrt(Lanes _a) { return _mm_sqrt_ps(_a); }
+static inline LaneMask  less(Lanes _a, Lanes _b) { return _mm_cmplt_ps(_a, _b); }
+static inline LaneMask  lessEqual(Lanes _a, Lanes _b) { return _mm_cmple_ps(_a, _b); }
+static inline LaneMask  both(LaneMask _a, LaneMask _b) { return _mm_and_ps(_a, _b); }
+static inline LaneMask  without(LaneMask _a, LaneMask _b) { return _mm_andnot_ps(_b, _a); }
+static inline Lanes     select(LaneMask _m, Lanes _a, Lanes _b) { return _mm_or_ps(_mm_and_ps(_m, _a), _mm_andnot_ps(_m, _b)); }
+static inline int       laneBits(LaneMask _m) { return _mm_movemask_ps(_m); }
+static inline float     laneMin(Lanes _a) {
+    _a = _mm_min_ps(_a, _mm_shuffle_ps(_a, _a, _MM_SHUFFLE(2, 3, 0, 1)));
+    _a = _mm_min_ps(_a, _mm_shuffle_ps(_a, _a, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(_a);
+}
+static inline LaneMask  laneMask(int _bits) {
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(_bits), _mm_setr_epi32(1, 2, 4, 8)), _mm_setr_epi32(1, 2, 4, 8)));
+}
+#elif defined(BVH_SIMD_NEON)
+typedef float32x4_t Lanes;
+typedef uint32x4_t LaneMask;
+static inline Lanes     lanes(float _v) { return vdupq_n_f32(_v); }
+static inline Lanes     lanesLoad(const float* _p) { return vld1q_f32(_p); }
+static inline void      lanesStore(float* _p, Lanes _a) { vst1q_f32(_p, _a); }
+static inline Lanes     add(Lanes _a, Lanes _b) { return vaddq_f32(_a, _b); }
+static inline Lanes     sub(Lanes _a, Lanes _b) { return vsubq_f32(_a, _b); }
+static inline Lanes     mul(Lanes _a, Lanes _b) { return vmulq_f32(_a, _b); }
+static inline Lanes     div(Lanes _a, Lanes _b) { return vdivq_f32(_a, _b); }
+static inline Lanes     lanesMin(Lanes _a, Lanes _b) { return vminq_f32(_a, _b); }
+static inline Lanes     lanesMax(Lanes _a, Lanes _b) { return vmaxq_f32(_a, _b); }
+static inline Lanes     abs(Lanes _a) { return vabsq_f32(_a); }
+static inline Lanes     sqrt(Lanes _a) { return vsqrtq_f32(_a); }
+static inline LaneMask  less(Lanes _a, Lanes _b) { return vcltq_f32(_a, _b); }
+static inline LaneMask  lessEqual(Lanes _a, Lanes _b) { return vcleq_f32(_a, _b); }
+static inline LaneMask  both(LaneMask _a, LaneMask _b) { return vandq_u32(_a, _b); }
+static inline LaneMask  without(LaneMask _a, LaneMask _b) { return vbicq_u32(_a, _b); }
+static inline Lanes     select(LaneMask _m, Lanes _a, Lanes _b) { return vbslq_f32(_m, _a, _b); }
+static inline int       laneBits(LaneMask _m) {
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    return (int)vaddvq_u32(vandq_u32(_m, vld1q_u32(weights)));
+}
+static inline float     laneMin(Lanes _a) { return vminvq_f32(_a); }
+static inline LaneMask  laneMask(int _bits) {
+    static const uint32_t weights[4] = { 1, 2, 4, 8 };
+    uint32x4_t w = vld1q_u32(weights);
+    return vceqq_u32(vandq_u32(vdupq_n_u32((uint32_t)_bits), w), w);
+}
+#else
+struct Lanes { float v[4]; };
+struct LaneMask { bool v[4]; };
+static inline Lanes     lanes(float _v) { Lanes r; for (int k = 0; k < 4; k++) r.v[k] = _v; return r; }
+static inline Lanes     lanesLoad(const float* _p) { Lanes r; for (int k = 0; k < 4; k++) r.v[k] = _p[k]; return r; }
+static inline void      lanesStore(float* _p, Lanes _a) { for (int k = 0; k < 4; k++) _p[k] = _a.v[k]; }
+#define BVH_LANES_OP(NAME, EXPR) \
+static inline Lanes     NAME(Lanes _a, Lanes _b) { Lanes r; for (int k = 0; k < 4; k++) { float a = _a.v[k], b = _b.v[k]; r.v[k] = (EXPR); } return r; }
+BVH_LANES_OP(add, a + b)
+BVH_LANES_OP(sub, a - b)
+BVH_LANES_OP(mul, a * b)
+BVH_LANES_OP(div, a / b)
+BVH_LANES_OP(lanesMin, a < b ? a : b)
+BVH_LANES_OP(lanesMax, a > b ? a : b)
+#undef BVH_LANES_OP
+static inline Lanes     abs(Lanes _a) { Lanes r; for (int k = 0; k < 4; k++) r.v[k] = std::fabs(_a.v[k]); return r; }
+static inline Lanes     sqrt(Lanes _a) { Lanes r; for (int k = 0; k < 4; k++) r.v[k] = std::sqrt(_a.v[k]); return r; }
+static inline LaneMask  less(Lanes _a, Lanes _b) { LaneMask r; for (int k = 0; k < 4; k++) r.v[k] = _a.v[k] < _b.v[k]; return r; }
+static inline LaneMask  lessEqual(Lanes _a, Lanes _b) { LaneMask r; for (int k = 0; k < 4; k++) r.v[k] = _a.v[k] <= _b.v[k]; return r; }
+static inline LaneMask  both(LaneMask _a, LaneMask _b) { LaneMask r; for (int k = 0; k < 4; k++) r.v[k] = _a.v[k] && _b.v[k]; return r; }
+static inline LaneMask  without(LaneMask _a, LaneMask _b) { LaneMask r; for (int k = 0; k < 4; k++) r.v[k] = _a.v[k] && !_b.v[k]; return r; }
+static inline Lanes     select(LaneMask _m, Lanes _a, Lanes _b) { Lanes r; for (int k = 0; k < 4; k++) r.v[k] = _m.v[k] ? _a.v[k] : _b.v[k]; return r; }
+static inline int       laneBits(LaneMask _m) { int r = 0; for (int k = 0; k < 4; k++) r |= _m.v[k] ? (1 << k) : 0; return r; }
+static inline float     laneMin(Lanes _a) { return std::min(std::min(_a.v[0], _a.v[1]), std::min(_a.v[2], _a.v[3])); }
+static inline LaneMask  laneMask(int _bits) { LaneMask r; for (int k = 0; k < 4; k++) r.v[k] = (_bits >> k) & 1; return r; }
+#endif
+
+// Four rays, one per lane. tmax shrinks to the closest hit so far.
+struct RayPacket {
+    Lanes       ox, oy, oz;
+    Lanes       dx, dy, dz;
+    Lanes       ix, iy, iz;
+    Lanes       tmin, tmax;
+    LaneMask    active;
+};
+
+// Lanes whose ray crosses the node before tmax, and where they enter it
+static inline LaneMask packetHitsNode(const RayPacket& _r, const BVHNode& _node, Lanes& _enter) {
+    Lanes tx0 = mul(sub(lanes(_node.min.x), _r.ox), _r.ix);
+    Lanes tx1 = mul(sub(lanes(_node.max.x), _r.ox), _r.ix);
+    Lanes ty0 = mul(sub(lanes(_node.min.y), _r.oy), _r.iy);
+    Lanes ty1 = mul(sub(lanes(_node.max.y), _r.oy), _r.iy);
+    Lanes tz0 = mul(sub(lanes(_node.min.z), _r.oz), _r.iz);
+    Lanes tz1 = mul(sub(lanes(_node.max.z), _r.oz), _r.iz);
+    _enter = lanesMax(lanesMax(lanesMin(tx0, tx1), lanesMin(ty0, ty1)), lanesMax(lanesMin(tz0, tz1), _r.tmin));
+    Lanes exit = lanesMin(lanesMin(lanesMax(tx0, tx1), lanesMax(ty0, ty1)), lanesMin(lanesMax(tz0, tz1), _r.tmax));
+    return both(_r.active, lessEqual(_enter, exit));
+}
+
+// Moller-Trumbore on the lanes of _mask, keeping the hits closer than tmax.
+// Returns the lanes that hit.
+static inline int packetHitsTriangle(RayPacket& _r, LaneMask _mask, const glm::vec3* _v, Lanes& _u, Lanes& _w) {
+    glm::vec3 e1 = _v[1] - _v[0];
+    glm::vec3 e2 = _v[2] - _v[0];
+    Lanes e1x = lanes(e1.x), e1y = lanes(e1.y), e1z = lanes(e1.z);
+    Lanes e2x = lanes(e2.x), e2y = lanes(e2.y), e2z = lanes(e2.z);
+
+    Lanes px = sub(mul(_r.dy, e2z), mul(_r.dz, e2y));
+    Lanes py = sub(mul(_r.dz, e2x), mul(_r.dx, e2z));
+    Lanes pz = sub(mul(_r.dx, e2y), mul(_r.dy, e2x));
+    Lanes det = add(add(mul(e1x, px), mul(e1y, py)), mul(e1z, pz));
+    Lanes invDet = div(lanes(1.0f), det);
+
+    Lanes sx = sub(_r.ox, lanes(_v[0].x));
+    Lanes sy = sub(_r.oy, lanes(_v[0].y));
+    Lanes sz = sub(_r.oz, lanes(_v[0].z));
+    Lanes u = mul(add(add(mul(sx, px), mul(sy, py)), mul(sz, pz)), invDet);
+
+    Lanes qx = sub(mul(sy, e1z), mul(sz, e1y));
+    Lanes qy = sub(mul(sz, e1x), mul(sx, e1z));
+    Lanes qz = sub(mul(sx, e1y), mul(sy, e1x));
+    Lanes w = mul(add(add(mul(_r.dx, qx), mul(_r.dy, qy)), mul(_r.dz, qz)), invDet);
+    Lanes t = mul(add(add(mul(e2x, qx), mul(e2y, qy)), mul(e2z, qz)), invDet);
+
+    LaneMask m = both(_mask, less(lanes(BVH_RAY_EPSILON), abs(det)));
+    m = both(m, lessEqual(lanes(0.0f), u));
+    m = both(m, lessEqual(lanes(0.0f), w));
+    m = both(m, lessEqual(add(u, w), lanes(1.0f)));
+    m = both(m, lessEqual(_r.tmin, t));
+    m = both(m, less(t, _r.tmax));
+
+    _r.tmax = select(m, t, _r.tmax);
+    _u = select(m, u, _u);
+    _w = select(m, w, _w);
+    return laneBits(m);
+}
+
+// Squared distances of four points to a node's bounds
+static inline Lanes packetNodeDistance2(const Lanes& _x, const Lanes& _y, const Lanes& _z, const BVHNode& _node) {
+    Lanes zero = lanes(0.0f);
+    Lanes dx = lanesMax(lanesMax(sub(lanes(_node.min.x), _x), sub(_x, lanes(_node.max.x))), zero);
+    Lanes dy = lanesMax(lanesMax(sub(lanes(_node.min.y), _y), sub(_y, lanes(_node.max.y))), zero);
+    Lanes dz = lanesMax(lanesMax(sub(lanes(_node.min.z), _z), sub(_z, lanes(_node.max.z))), zero);
+    return add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz));
+}
+
+// Squared distance of four points to the segment _a + h * _edge, h in [0, 1]
+static inline Lanes packetEdgeDistance2(const Lanes& _x, const Lanes& _y, const Lanes& _z, const glm::vec3& _a, const glm::vec3& _edge) {
+    float invLength2 = 1.0f / std::max(glm::dot(_edge, _edge), 1e-30f);
+    Lanes px = sub(_x, lanes(_a.x));
+    Lanes py = sub(_y, lanes(_a.y));
+    Lanes pz = sub(_z, lanes(_a.z));
+    Lanes h = mul(add(add(mul(px, lanes(_edge.x)), mul(py, lanes(_edge.y))), mul(pz, lanes(_edge.z))), lanes(invLength2));
+    h = lanesMin(lanesMax(h, lanes(0.0f)), lanes(1.0f));
+    Lanes ex = sub(mul(lanes(_edge.x), h), px);
+    Lanes ey = sub(mul(lanes(_edge.y), h), py);
+    Lanes ez = sub(mul(lanes(_edge.z), h), pz);
+    return add(add(mul(ex, ex), mul(ey, ey)), mul(ez, ez));
+}
+
+static inline Lanes packetPlaneSide(const Lanes& _x, const Lanes& _y, const Lanes& _z, const glm::vec3& _a, const glm::vec3& _normal) {
+    return add(add(mul(sub(_x, lanes(_a.x)), lanes(_normal.x)), mul(sub(_y, lanes(_a.y)), lanes(_normal.y))), mul(sub(_z, lanes(_a.z)), lanes(_normal.z)));
+}
+
+// Squared distances of four points to a triangle (as Triangle::getClosestDistance():
+// the plane when the point projects inside, the nearest edge otherwise)
+static inline Lanes packetTriangleDistance2(const Lanes& _x, const Lanes& _y, const Lanes& _z, const glm::vec3* _v) {
+    glm::vec3 v21 = _v[1] - _v[0];
+    glm::vec3 v32 = _v[2] - _v[1];
+    glm::vec3 v13 = _v[0] - _v[2];
+    glm::vec3 nor = glm::cross(v21, v13);
+
+    Lanes edges = lanesMin(lanesMin(packetEdgeDistance2(_x, _y, _z, _v[0], v21),
+                          packetEdgeDistance2(_x, _y, _z, _v[1], v32)),
+                          packetEdgeDistance2(_x, _y, _z, _v[2], v13));
+
+    float nor2 = glm::dot(nor, nor);
+    if (nor2 <= 1e-30f)
+        return edges;
+
+    Lanes zero = lanes(0.0f);
+    LaneMask inside = lessEqual(zero, packetPlaneSide(_x, _y, _z, _v[0], glm::cross(v21, nor)));
+    inside = both(inside, lessEqual(zero, packetPlaneSide(_x, _y, _z, _v[1], glm::cross(v32, nor))));
+    inside = both(inside, lessEqual(zero, packetPlaneSide(_x, _y, _z, _v[2], glm::cross(v13, nor))));
+
+    Lanes plane = packetPlaneSide(_x, _y, _z, _v[0], nor);
+    return select(inside, mul(mul(plane, plane), lanes(1.0f / nor2)), edges);
+}
+
+static size_t longestAxis(const BVHNode& _node) {
+    glm::vec3 e = _node.max - _node.min;
+    return  (e.x > std::max(e.y, e.z) ) ?   0
+            : (e.y > std::max(e.x, e.z) ) ? 1
+            :                               2;
+}
+
+static float nodeArea(const glm::vec3& _min, const glm::vec3& _max) {
+    glm::vec3 e = _max - _min;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+// SAH cost of the nodes [_first, _last) (a whole subtree), relative to
+// the first one
+static float subtreeCost(const BVHNode* _nodes, size_t _first, size_t _last) {
+    float cost = 0.0f;
+    for (size_t n = _first; n < _last; n++)
+        cost += nodeArea(_nodes[n].min, _nodes[n].max) * (_nodes[n].count == 0 ? BVH_TRAVERSAL_COST : float(_nodes[n].count));
+    return cost / std::max(nodeArea(_nodes[_first].min, _nodes[_first].max), 1e-30f);
+}
+
+static float nodeDistance2(const BVHNode& _node, const glm::vec3& _point) {
+    glm::vec3 d = glm::max(glm::max(_node.min - _point, _point - _node.max), glm::vec3(0.0f));
+    return glm::dot(d, d);
+}
+
+// Slab test of the node bounds against [_minDistance, _maxDistance]
+static bool nodeHit(const BVHNode& _node, const glm::vec3& _origin, const glm::vec3& _invDirection, float _minDistance, float _maxDistance) {
+    glm::vec3 t0 = (_node.min - _origin) * _invDirection;
+    glm::vec3 t1 = (_node.max - _origin) * _invDirection;
+    glm::vec3 tmin = glm::min(t0, t1);
+    glm::vec3 tmax = glm::max(t0, t1);
+    float enter = std::max(_minDistance, std::max(tmin.x, std::max(tmin.y, tmin.z)));
+    float exit = std::min(_maxDistance, std::min(tmax.x, std::min(tmax.y, tmax.z)));
+    return enter <= exit;
+}
+
+BVH::BVH() {
 }
 
 BVH::BVH( const std::vector<Triangle>& _elements, BVH_Split _strategy) {
-    left = nullptr;
-    right = nullptr;
-    axis = 0;
-    leaf = true;
+    load(_elements, _strategy);
+}
 
+BVH::BVH( const TriangleSoup& _elements, BVH_Split _strategy) {
     load(_elements, _strategy);
 }
 
@@ -23,383 +329,1211 @@ BVH::~BVH() {
 }
 
 void BVH::clear() {
-    left = nullptr;
-    right = nullptr;
+    elements.clear();
+    m_nodes.clear();
+    m_indices.clear();
+    m_vertices.clear();
+    m_centroids.clear();
+    m_subtrees.clear();
+    m_topNodes.clear();
 }
 
 void BVH::load( const std::vector<Triangle>& _elements, BVH_Split _strategy ) {
+    load(TriangleSoup(_elements), _strategy);
+}
+
+void BVH::load( const TriangleSoup& _elements, BVH_Split _strategy ) {
+    auto start = std::chrono::steady_clock::now();
+
+    clear();
     elements = _elements;
 
     // Exapand bounds to contain all elements
-    for (size_t i = 0; i < _elements.size(); i++ )
-        expand(_elements[i]);
+    min = glm::vec3(std::numeric_limits<float>::max());
+    max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < elements.size(); i++ ) {
+        expand(elements.getMin(i));
+        expand(elements.getMax(i));
+    }
 
     // // Exapand a bit for padding
     // glm::vec3   bdiagonal = getDiagonal();
     // float max_dist = glm::length(bdiagonal);
     // expand(max_dist * 0.01f);
 
-    leaf = _elements.size() < 2;
+    m_strategy = _strategy;
+    m_stats = BVHStats();
+    if (elements.empty())
+        return;
 
-    if (!leaf) {
-        if (_strategy == SPLIT_BALANCED)
-            _split_balanced();
-        else if (_strategy == SPLIT_MIDPOINT)
-            _split_midpoint();
-        else if (_strategy == SPLIT_SORTED_MIDPOINT)
-            _split_sorted_midpoint();
-        else if (_strategy == SPLIT_BALANCED_MIDPOINT)
-            _split_balanced_midpoint();
-        else if (_strategy == SPLIT_SAH)
-            _split_sah();
+    size_t count = elements.size();
+    size_t nThreads = parallelThreads(count, BVH_MIN_TASK);
+
+    m_centroids.resize(count);
+    m_bounds.resize(count);
+    parallelFor(nThreads, count, [&](size_t, size_t _start, size_t _end) {
+        for (size_t i = _start; i < _end; i++) {
+            m_centroids[i] = elements.getCentroid(i);
+            m_bounds[i].min = elements.getMin(i);
+            m_bounds[i].max = elements.getMax(i);
+        }
+    });
+
+    m_indices.resize(count);
+    std::iota(m_indices.begin(), m_indices.end(), 0);
+
+    // The top of the tree is built here; subtrees small enough go to tasks,
+    // enough of them for the threads to balance out
+    std::vector<BuildTask> tasks;
+    size_t taskSize = std::min(BVH_PARALLEL_NODE, std::max(BVH_MIN_TASK, count / (nThreads * 4)));
+    std::vector<BVHNode> top;
+    top.reserve(nThreads > 1 ? count / taskSize * 4 : count * 2);
+    _build(top, 0, count, 0, _strategy, nThreads > 1 ? &tasks : nullptr, taskSize);
+
+    if (tasks.empty()) {
+        m_nodes.swap(top);
     }
+    else {
+        _buildTasks(tasks, _strategy);
+        _splice(top, tasks);
+    }
+
+    // Leaves read their vertices in order, without touching the Triangles
+    m_vertices.resize(m_indices.size() * 3);
+    parallelFor(nThreads, count, [&](size_t, size_t _start, size_t _end) {
+        for (size_t i = _start; i < _end; i++)
+            for (size_t v = 0; v < 3; v++)
+                m_vertices[i * 3 + v] = elements.getVertex(m_indices[i], v);
+    });
+
+    std::vector<glm::vec3>().swap(m_centroids);
+    std::vector<BoundingBox>().swap(m_bounds);
+
+    _updateStats();
+    m_buildCost = m_stats.sahCost;
+    m_stats.buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
-// Returns element closest to target in arr[]
-size_t findClosest(const std::vector<Triangle>& _list, size_t _axis, size_t _size, float _target) {
-    // left-side case
-    if (_target <= _list[0].getCentroid()[_axis] )
-        return 0;
+bool BVH::load( const TriangleSoup& _elements, BVH_Split _strategy, const std::string& _cachePath ) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t hash = _elements.getHash();
 
-    //right-side case
-    if (_target >= _list[_size - 1].getCentroid()[_axis])
-        return _size - 1;
-
-    // binary search
-    size_t i = 0, j = _size, mid = 0;
-    while (i < j) {
-        mid = (i + j) / 2;
-        if (_list[mid].getCentroid()[_axis] == _target)
-            return mid;
-
-        /* If target is less than _list element,
-            then search in left */
-        if (_target < _list[mid].getCentroid()[_axis]) {
-            // If target is greater than previous
-            // to mid, return closest of two
-            if (mid > 0 && _target > _list[mid - 1].getCentroid()[_axis])
-                // return getClosest(_list[mid - 1], _list[mid], target);
-                return mid;
-
-            j = mid;
-        }
-        /* Repeat for left half */
-        // If target is greater than mid
-        else {
-            if (mid < _size - 1 && _target < _list[mid + 1].getCentroid()[_axis])
-                // return getClosest(  _list[mid], _list[mid + 1], target);
-                return mid;
+    // Anything off (missing, stale, truncated) is just a cache miss
+    MappedFile file(_cachePath);
+    BVHCacheHeader header;
+    bool match = file.isOpen() && file.size() >= sizeof(BVHCacheHeader) && !_elements.empty();
+    if (match) {
+        std::memcpy(&header, file.data(), sizeof(BVHCacheHeader));
+        match = std::memcmp(header.magic, BVH_CACHE_MAGIC, 4) == 0 && header.version == BVH_CACHE_VERSION &&
+                header.hash == hash && header.strategy == (uint32_t)_strategy &&
+                header.elementCount == _elements.size() && header.vertexCount == _elements.positions.size() &&
+                header.nodeCount > 0 &&
+                file.size() == sizeof(BVHCacheHeader) + header.nodeCount * sizeof(BVHNode) + header.elementCount * sizeof(uint32_t);
+    }
+
+    if (match) {
+        clear();
+        elements = _elements;
+        m_strategy = _strategy;
+        m_stats = BVHStats();
 
-            // update i
-            i = mid + 1;
+        size_t count = elements.size();
+        const char* data = file.data() + sizeof(BVHCacheHeader);
+        m_nodes.resize(header.nodeCount);
+        std::memcpy(m_nodes.data(), data, m_nodes.size() * sizeof(BVHNode));
+        m_indices.resize(count);
+        std::memcpy(m_indices.data(), data + m_nodes.size() * sizeof(BVHNode), count * sizeof(uint32_t));
+
+        // The hash only vouches for the elements: a damaged tree must not
+        // send queries out of bounds, nor overflow the traversal stacks.
+        // Children come after their parent, so depths are known in order.
+        std::vector<uint8_t> depths(m_nodes.size(), 0);
+        for (size_t i = 0; i < m_nodes.size() && match; i++) {
+            const BVHNode& node = m_nodes[i];
+            if (node.count == 0) {
+                match = i + 1 < m_nodes.size() && node.offset > i + 1 && node.offset < m_nodes.size() &&
+                        depths[i] < BVH_MAX_DEPTH;
+                if (match) {
+                    depths[i + 1] = std::max(depths[i + 1], (uint8_t)(depths[i] + 1));
+                    depths[node.offset] = std::max(depths[node.offset], (uint8_t)(depths[i] + 1));
+                }
+            }
+            else
+                match = (size_t)node.offset + node.count <= count;
         }
+        for (size_t i = 0; i < count && match; i++)
+            match = m_indices[i] < count;
+
+        if (!match)
+            std::cout << "ERROR: BVH: corrupted cache " << _cachePath << ", building it again" << std::endl;
     }
 
-    // Only single element left after search
-    return mid;
+    if (!match) {
+        load(_elements, _strategy);
+        if (!save(_cachePath))
+            std::cout << "ERROR: BVH: could not write cache " << _cachePath << std::endl;
+        return false;
+    }
+
+    min = m_nodes[0].min;
+    max = m_nodes[0].max;
+
+    size_t count = m_indices.size();
+    m_vertices.resize(count * 3);
+    parallelFor(parallelThreads(count, BVH_MIN_TASK), count, [&](size_t, size_t _start, size_t _end) {
+        for (size_t i = _start; i < _end; i++)
+            for (size_t v = 0; v < 3; v++)
+                m_vertices[i * 3 + v] = elements.getVertex(m_indices[i], v);
+    });
+
+    m_stats.sahCost = header.sahCost;
+    m_stats.nodes = m_nodes.size();
+    m_stats.leaves = header.leaves;
+    m_stats.maxDepth = header.maxDepth;
+    m_stats.maxLeafSize = header.maxLeafSize;
+    m_stats.averageLeafSize = header.averageLeafSize;
+    m_stats.cached = true;
+    m_buildCost = m_stats.sahCost;
+    m_stats.buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
 }
 
-void BVH::_split_balanced() {
-    float width = getWidth();
-    float height = getHeight();
-    float depth = getDepth();
-    glm::vec3 center = getCenter();
+// Written next to the destination and renamed over it, so a job reading
+// the cache meanwhile sees the old file or the new one, never half of it
+bool BVH::save( const std::string& _path ) const {
+    BVHCacheHeader header;
+    std::memcpy(header.magic, BVH_CACHE_MAGIC, 4);
+    header.version = BVH_CACHE_VERSION;
+    header.hash = elements.getHash();
+    header.elementCount = elements.size();
+    header.vertexCount = elements.positions.size();
+    header.strategy = (uint32_t)m_strategy;
+    header.nodeCount = (uint32_t)m_nodes.size();
+    header.sahCost = m_stats.sahCost;
+    header.averageLeafSize = m_stats.averageLeafSize;
+    header.leaves = (uint32_t)m_stats.leaves;
+    header.maxDepth = (uint32_t)m_stats.maxDepth;
+    header.maxLeafSize = (uint32_t)m_stats.maxLeafSize;
+    header.reserved = 0;
 
-    axis =  (width > std::max(height, depth) ) ?  0
-            : (height > std::max(width, depth) ) ?  1
-            : 2;
-                    
-    auto comparator =   (width > std::max(height, depth) ) ? Triangle::compareX
-                        :(height > std::max(width, depth) ) ? Triangle::compareY
-                        : Triangle::compareZ;
+    std::string tmpPath = _path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open())
+            return false;
 
-    // Sort elements by the longest axis
-    std::sort(elements.begin(), elements.end(), comparator);    
-    std::size_t half_array_size = elements.size() / 2;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(BVHCacheHeader));
+        file.write(reinterpret_cast<const char*>(m_nodes.data()), m_nodes.size() * sizeof(BVHNode));
+        file.write(reinterpret_cast<const char*>(m_indices.data()), m_indices.size() * sizeof(uint32_t));
+        if (!file.good()) {
+            file.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
 
-    left = std::make_shared<BVH>( std::vector<Triangle>(elements.begin(), elements.begin() + half_array_size), SPLIT_BALANCED );
-    right = std::make_shared<BVH>( std::vector<Triangle>(elements.begin() + half_array_size, elements.end()), SPLIT_BALANCED );
+    // rename() does not replace an existing file on Windows
+#if defined(_WIN32)
+    std::remove(_path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
 }
 
-void BVH::_split_sorted_midpoint() {
-    float width = getWidth();
-    float height = getHeight();
-    float depth = getDepth();
+size_t BVH::refit( const std::vector<Triangle>& _elements, float _rebuildThreshold ) {
+    return refit(TriangleSoup(_elements), _rebuildThreshold);
+}
 
-    axis =  (width > std::max(height, depth) ) ?    0
-            : (height > std::max(width, depth) ) ?  1
-            :                                       2;
+size_t BVH::refit( const TriangleSoup& _elements, float _rebuildThreshold ) {
+    if (_elements.size() != elements.size() || m_nodes.empty()) {
+        load(_elements, m_strategy);
+        return 0;
+    }
 
-    auto comparator =   (width > std::max(height, depth) ) ? Triangle::compareX
-                        :(height > std::max(width, depth) ) ? Triangle::compareY
-                        : Triangle::compareZ;
+    elements = _elements;
+    return refit(_rebuildThreshold);
+}
 
-    // Sort elements by the longest axis
-    std::sort(elements.begin(), elements.end(), comparator);
-    float splitPos = getCenter()[axis];
-
-    std::size_t half_array_size = findClosest(elements, axis, elements.size(), splitPos);
-
-    if (half_array_size == 0)
-        half_array_size++;
-
-    left = std::make_shared<BVH>( std::vector<Triangle>(elements.begin(), elements.begin() + half_array_size), SPLIT_SORTED_MIDPOINT );
-    right = std::make_shared<BVH>( std::vector<Triangle>(elements.begin() + half_array_size, elements.end()), SPLIT_SORTED_MIDPOINT );
-}
-
-void BVH::_split_midpoint() {
-    float width = getWidth();
-    float height = getHeight();
-    float depth = getDepth();
-
-    axis =  (width > std::max(height, depth) ) ?    0
-            : (height > std::max(width, depth) ) ?  1
-            :                                       2;
-    float splitPos = getCenter()[axis];
-    std::vector<Triangle> left_el;
-    std::vector<Triangle> right_el;
-    for (size_t i = 0; i < elements.size(); i++) {
-        if (elements[i].getCentroid()[axis] < splitPos)
-            left_el.push_back(elements[i]);
-        else
-            right_el.push_back(elements[i]);
+size_t BVH::refit( const std::vector<glm::vec3>& _positions, float _rebuildThreshold ) {
+    if (_positions.size() != elements.positions.size()) {
+        std::cout << "ERROR: BVH::refit(): " << _positions.size() << " positions for " << elements.positions.size() << " vertices" << std::endl;
+        return 0;
     }
 
-    if (left_el.size() == 0 || right_el.size() == 0)
-        leaf = true;
-    else {
-        left = std::make_shared<BVH>( left_el, SPLIT_MIDPOINT );
-        right = std::make_shared<BVH>( right_el, SPLIT_MIDPOINT );
+    elements.positions = _positions;
+    return refit(_rebuildThreshold);
+}
+
+size_t BVH::refit( float _rebuildThreshold ) {
+    if (m_nodes.empty())
+        return 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // The costs to compare against are the ones of the tree as built
+    if (m_subtrees.empty())
+        _findSubtrees();
+
+    size_t count = m_indices.size();
+    size_t nThreads = parallelThreads(count, BVH_MIN_TASK);
+    parallelFor(nThreads, count, [&](size_t, size_t _start, size_t _end) {
+        for (size_t i = _start; i < _end; i++)
+            for (size_t v = 0; v < 3; v++)
+                m_vertices[i * 3 + v] = elements.getVertex(m_indices[i], v);
+    });
+
+    // Children always come after their parent, so each subtree refits
+    // back to front on its own, then the nodes above them
+    std::vector<float> costs(m_subtrees.size());
+    parallelFor(std::min(nThreads, m_subtrees.size()), m_subtrees.size(), [&](size_t, size_t _start, size_t _end) {
+        for (size_t k = _start; k < _end; k++) {
+            const Subtree& subtree = m_subtrees[k];
+            for (size_t n = subtree.last; n-- > subtree.first; ) {
+                BVHNode& node = m_nodes[n];
+                if (node.count == 0) {
+                    node.min = glm::min(m_nodes[n + 1].min, m_nodes[node.offset].min);
+                    node.max = glm::max(m_nodes[n + 1].max, m_nodes[node.offset].max);
+                    continue;
+                }
+
+                const glm::vec3* v = &m_vertices[node.offset * 3];
+                node.min = node.max = v[0];
+                for (size_t i = 1; i < node.count * 3; i++) {
+                    node.min = glm::min(node.min, v[i]);
+                    node.max = glm::max(node.max, v[i]);
+                }
+            }
+
+            if (_rebuildThreshold > 0.0f)
+                costs[k] = subtreeCost(m_nodes.data(), subtree.first, subtree.last);
+        }
+    });
+    _refitTop();
+
+    size_t rebuilt = 0;
+    std::vector<uint8_t> rebuild(m_subtrees.size(), 0);
+    if (_rebuildThreshold > 0.0f) {
+        float rootArea = std::max(nodeArea(m_nodes[0].min, m_nodes[0].max), 1e-30f);
+        float cost = 0.0f;
+        for (uint32_t n : m_topNodes)
+            cost += nodeArea(m_nodes[n].min, m_nodes[n].max) / rootArea * BVH_TRAVERSAL_COST;
+        for (size_t k = 0; k < m_subtrees.size(); k++)
+            cost += nodeArea(m_nodes[m_subtrees[k].first].min, m_nodes[m_subtrees[k].first].max) / rootArea * costs[k];
+
+        // Loosened all over (a stretch, a twist): the top of the tree is as
+        // bad as the rest and only a new build fixes it
+        if (cost > m_buildCost * (1.0f + _rebuildThreshold)) {
+            rebuilt = m_subtrees.size();
+            TriangleSoup moved;
+            std::swap(moved, elements);
+            load(moved, m_strategy);
+            m_stats.rebuiltSubtrees = rebuilt;
+            m_stats.refitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return rebuilt;
+        }
+
+        for (size_t k = 0; k < m_subtrees.size(); k++) {
+            if (costs[k] > m_subtrees[k].cost * (1.0f + _rebuildThreshold)) {
+                rebuild[k] = 1;
+                rebuilt++;
+            }
+        }
+    }
+
+    if (rebuilt > 0) {
+        // Degraded subtrees are built again over their own primitives, the
+        // others move over as they are
+        m_centroids.resize(elements.size());
+        m_bounds.resize(elements.size());
+        std::vector<BuildTask> tasks(m_subtrees.size());
+        parallelFor(std::min(nThreads, m_subtrees.size()), m_subtrees.size(), [&](size_t, size_t _start, size_t _end) {
+            for (size_t k = _start; k < _end; k++) {
+                const Subtree& subtree = m_subtrees[k];
+                BuildTask& task = tasks[k];
+                task.node = subtree.first;
+                task.begin = subtree.begin;
+                task.end = subtree.end;
+                task.depth = subtree.depth;
+                if (rebuild[k]) {
+                    for (size_t i = subtree.begin; i < subtree.end; i++) {
+                        uint32_t e = m_indices[i];
+                        m_centroids[e] = elements.getCentroid(e);
+                        m_bounds[e].min = elements.getMin(e);
+                        m_bounds[e].max = elements.getMax(e);
+                    }
+                    continue;
+                }
+
+                task.nodes.assign(m_nodes.begin() + subtree.first, m_nodes.begin() + subtree.last);
+                for (BVHNode& node : task.nodes)
+                    if (node.count == 0)
+                        node.offset -= subtree.first;
+            }
+        });
+
+        std::vector<BuildTask> rebuilding;
+        for (size_t k = 0; k < tasks.size(); k++)
+            if (rebuild[k])
+                rebuilding.push_back(tasks[k]);
+        _buildTasks(rebuilding, m_strategy);
+        for (size_t k = 0, r = 0; k < tasks.size(); k++)
+            if (rebuild[k])
+                tasks[k].nodes.swap(rebuilding[r++].nodes);
+
+        for (size_t k = 0; k < tasks.size(); k++) {
+            if (!rebuild[k])
+                continue;
+            for (size_t i = tasks[k].begin; i < tasks[k].end; i++)
+                for (size_t v = 0; v < 3; v++)
+                    m_vertices[i * 3 + v] = elements.getVertex(m_indices[i], v);
+        }
+
+        std::vector<BVHNode> top;
+        top.swap(m_nodes);
+        _splice(top, tasks);
+
+        std::vector<glm::vec3>().swap(m_centroids);
+        std::vector<BoundingBox>().swap(m_bounds);
+
+        // Same primitive ranges, so the same subtrees in the same order:
+        // only the rebuilt ones take a new reference cost
+        std::vector<Subtree> previous;
+        previous.swap(m_subtrees);
+        _findSubtrees();
+        for (size_t k = 0; k < m_subtrees.size(); k++)
+            if (!rebuild[k])
+                m_subtrees[k].cost = previous[k].cost;
     }
+
+    min = m_nodes[0].min;
+    max = m_nodes[0].max;
+
+    double buildTime = m_stats.buildTime;
+    m_stats = BVHStats();
+    m_stats.buildTime = buildTime;
+    _updateStats();
+    m_stats.rebuiltSubtrees = rebuilt;
+    m_stats.refitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return rebuilt;
 }
 
-void BVH::_split_balanced_midpoint() {
-    glm::vec3 splitPos = getCenter();
+void BVH::_refitTop() {
+    for (size_t k = m_topNodes.size(); k-- > 0; ) {
+        BVHNode& node = m_nodes[m_topNodes[k]];
+        node.min = glm::min(m_nodes[m_topNodes[k] + 1].min, m_nodes[node.offset].min);
+        node.max = glm::max(m_nodes[m_topNodes[k] + 1].max, m_nodes[node.offset].max);
+    }
+}
 
-    std::vector<Triangle> left_el[3];
-    std::vector<Triangle> right_el[3];
-    for (size_t a = 0; a < 3; a++) {
-        for (size_t i = 0; i < elements.size(); i++) {
-            if (elements[i].getCentroid()[a] < splitPos[a])
-                left_el[a].push_back(elements[i]);
-            else
-                right_el[a].push_back(elements[i]);
+// Splits the tree into subtrees of up to BVH_MIN_TASK primitives, and the
+// nodes above them
+void BVH::_findSubtrees() {
+    m_subtrees.clear();
+    m_topNodes.clear();
+
+    std::vector<std::pair<uint32_t, size_t> > stack;
+    stack.push_back(std::make_pair(0u, (size_t)0));
+    while (!stack.empty()) {
+        uint32_t i = stack.back().first;
+        size_t depth = stack.back().second;
+        stack.pop_back();
+
+        // Leftmost and rightmost leaves bound both ranges
+        uint32_t first = i, last = i;
+        while (m_nodes[first].count == 0)
+            first++;
+        while (m_nodes[last].count == 0)
+            last = m_nodes[last].offset;
+
+        Subtree subtree;
+        subtree.first = i;
+        subtree.last = last + 1;
+        subtree.begin = m_nodes[first].offset;
+        subtree.end = m_nodes[last].offset + m_nodes[last].count;
+        subtree.depth = depth;
+        if (m_nodes[i].count > 0 || subtree.end - subtree.begin <= BVH_MIN_TASK) {
+            subtree.cost = subtreeCost(m_nodes.data(), subtree.first, subtree.last);
+            m_subtrees.push_back(subtree);
+            continue;
         }
+
+        m_topNodes.push_back(i);
+        stack.push_back(std::make_pair(m_nodes[i].offset, depth + 1));
+        stack.push_back(std::make_pair(i + 1, depth + 1));
     }
+}
 
-    int lower_diff = elements.size();
-    for (size_t a = 0; a < 3; a++) {
-        int diff = abs(int(left_el[a].size()) - int(right_el[a].size()));
-        if (diff < lower_diff) {
-            axis = a;
-            lower_diff = diff;
+void BVH::_build(std::vector<BVHNode>& _nodes, size_t _begin, size_t _end, size_t _depth, BVH_Split _strategy,
+                 std::vector<BuildTask>* _tasks, size_t _taskSize) {
+    size_t index = _nodes.size();
+    _nodes.push_back(BVHNode());
+
+    size_t count = _end - _begin;
+    if (_tasks != nullptr && count <= _taskSize) {
+        BuildTask task;
+        task.node = (uint32_t)index;
+        task.begin = _begin;
+        task.end = _end;
+        task.depth = _depth;
+        _tasks->push_back(task);
+        return;
+    }
+
+    size_t nThreads = (count > BVH_PARALLEL_NODE) ? parallelThreads(count, BVH_PARALLEL_NODE / 4) : 1;
+    std::vector<BVHNode> partial(nThreads);
+    parallelFor(nThreads, count, [&](size_t _t, size_t _start, size_t _end) {
+        glm::vec3 bmin(std::numeric_limits<float>::max());
+        glm::vec3 bmax(std::numeric_limits<float>::lowest());
+        for (size_t i = _begin + _start; i < _begin + _end; i++) {
+            const BoundingBox& b = m_bounds[m_indices[i]];
+            bmin = glm::min(bmin, b.min);
+            bmax = glm::max(bmax, b.max);
         }
+        partial[_t].min = bmin;
+        partial[_t].max = bmax;
+    });
+
+    BVHNode node = partial[0];
+    for (size_t t = 1; t < nThreads; t++) {
+        node.min = glm::min(node.min, partial[t].min);
+        node.max = glm::max(node.max, partial[t].max);
     }
+    node.offset = (uint32_t)_begin;
+    node.count = (uint32_t)count;
 
-    if (left_el[axis].size() == 0 || right_el[axis].size() == 0)
-        leaf = true;
-    else {
-        left = std::make_shared<BVH>( left_el[axis], SPLIT_BALANCED_MIDPOINT );
-        right = std::make_shared<BVH>( right_el[axis], SPLIT_BALANCED_MIDPOINT );
+    size_t split = _end;
+    if (count >= 2) {
+        if (_depth >= BVH_MAX_SPLIT_DEPTH || _strategy == SPLIT_BALANCED)
+            split = _split_balanced(node, _begin, _end);
+        else if (_strategy == SPLIT_MIDPOINT)
+            split = _split_midpoint(node, _begin, _end);
+        else if (_strategy == SPLIT_SORTED_MIDPOINT)
+            split = _split_sorted_midpoint(node, _begin, _end);
+        else if (_strategy == SPLIT_BALANCED_MIDPOINT)
+            split = _split_balanced_midpoint(node, _begin, _end);
+        else if (_strategy == SPLIT_SAH)
+            split = _split_sah(node, _begin, _end);
+    }
+
+    if (split <= _begin || split >= _end) {
+        _nodes[index] = node;
+        return;
     }
+
+    node.count = 0;
+    _nodes[index] = node;
+    _build(_nodes, _begin, split, _depth + 1, _strategy, _tasks, _taskSize);
+    _nodes[index].offset = (uint32_t)_nodes.size();
+    _build(_nodes, split, _end, _depth + 1, _strategy, _tasks, _taskSize);
 }
 
-float evaluateSAH( const std::vector<vera::Triangle>& _triangles, int _axis, float _pos ) {
-    vera::BoundingBox leftBox;
-    vera::BoundingBox rightBox;
-    size_t leftCount = 0;
-    size_t rightCount = 0;
-    for (size_t i = 0; i < _triangles.size(); i++ ) {
-        if (_triangles[i].getCentroid()[_axis] < _pos) {
-            leftBox.expand( _triangles[i] );
-            leftCount++;
+// Largest first, each thread takes the next one when done
+void BVH::_buildTasks(std::vector<BuildTask>& _tasks, BVH_Split _strategy) {
+    std::vector<size_t> order(_tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t _a, size_t _b) {
+        return _tasks[_a].end - _tasks[_a].begin > _tasks[_b].end - _tasks[_b].begin;
+    });
+
+    size_t nThreads = std::min(parallelThreads(m_indices.size(), BVH_MIN_TASK), _tasks.size());
+    std::atomic<size_t> next(0);
+    parallelFor(nThreads, nThreads, [&](size_t, size_t, size_t) {
+        for (size_t k = next++; k < order.size(); k = next++) {
+            BuildTask& task = _tasks[order[k]];
+            task.nodes.reserve((task.end - task.begin) * 2);
+            _build(task.nodes, task.begin, task.end, task.depth, _strategy);
+        }
+    });
+}
+
+// Rebuilds m_nodes depth first from the top of the tree, with the subtree
+// of each task in place of its node. The subtrees keep their layout, only
+// their second child offsets move.
+void BVH::_splice(const std::vector<BVHNode>& _top, std::vector<BuildTask>& _tasks) {
+    std::vector<int> taskOf(_top.size(), -1);
+    for (size_t k = 0; k < _tasks.size(); k++)
+        taskOf[_tasks[k].node] = (int)k;
+
+    size_t total = _top.size();
+    for (const BuildTask& task : _tasks)
+        total += task.nodes.size();
+    m_nodes.clear();
+    m_nodes.reserve(total);
+
+    std::vector<std::pair<uint32_t, size_t> > stack;   // top node, parent to patch
+    stack.push_back(std::make_pair(0u, (size_t)BVH_NONE));
+    while (!stack.empty()) {
+        uint32_t i = stack.back().first;
+        size_t parent = stack.back().second;
+        stack.pop_back();
+
+        if (parent != BVH_NONE)
+            m_nodes[parent].offset = (uint32_t)m_nodes.size();
+
+        if (taskOf[i] >= 0) {
+            uint32_t base = (uint32_t)m_nodes.size();
+            for (BVHNode node : _tasks[taskOf[i]].nodes) {
+                if (node.count == 0)
+                    node.offset += base;
+                m_nodes.push_back(node);
+            }
+            std::vector<BVHNode>().swap(_tasks[taskOf[i]].nodes);
+            continue;
+        }
+
+        size_t index = m_nodes.size();
+        m_nodes.push_back(_top[i]);
+        if (_top[i].count == 0) {
+            stack.push_back(std::make_pair(_top[i].offset, index));
+            stack.push_back(std::make_pair(i + 1, (size_t)BVH_NONE));
+        }
+    }
+}
+
+void BVH::_updateStats() {
+    m_stats.nodes = m_nodes.size();
+    float rootArea = std::max(nodeArea(m_nodes[0].min, m_nodes[0].max), 1e-30f);
+
+    size_t leafElements = 0;
+    std::vector<std::pair<uint32_t, size_t> > stack;
+    stack.push_back(std::make_pair(0u, (size_t)0));
+    while (!stack.empty()) {
+        uint32_t i = stack.back().first;
+        size_t depth = stack.back().second;
+        stack.pop_back();
+
+        const BVHNode& node = m_nodes[i];
+        float area = nodeArea(node.min, node.max) / rootArea;
+        m_stats.maxDepth = std::max(m_stats.maxDepth, depth);
+        if (node.count == 0) {
+            m_stats.sahCost += area * BVH_TRAVERSAL_COST;
+            stack.push_back(std::make_pair(i + 1, depth + 1));
+            stack.push_back(std::make_pair(node.offset, depth + 1));
         }
         else {
-            rightBox.expand( _triangles[i] );
-            rightCount++;
+            m_stats.sahCost += area * node.count;
+            m_stats.leaves++;
+            m_stats.maxLeafSize = std::max(m_stats.maxLeafSize, (size_t)node.count);
+            leafElements += node.count;
         }
     }
-    float cost = leftCount * leftBox.getArea() + rightCount * rightBox.getArea();
-    return cost > 0 ? cost : 1e30f;
+    m_stats.averageLeafSize = float(leafElements) / float(m_stats.leaves);
 }
 
-void BVH::_split_sah() {
-    float width = getWidth();
-    float height = getHeight();
-    float depth = getDepth();
+size_t BVH::_split_balanced(const BVHNode& _node, size_t _begin, size_t _end) {
+    size_t axis = longestAxis(_node);
 
-    int bestAxis = -1;
-    float bestPos = 0;
-    float bestCost = 1e30f;
-
-    for (size_t a = 0; a < 3; a++ ) 
-    for (size_t i = 0; i < elements.size(); i++) {
-        float candidatePos = elements[i].getCentroid()[a];
-        float cost = evaluateSAH( elements, a, candidatePos );
-        if (cost < bestCost) {
-            bestPos = candidatePos;
-            bestAxis = a;
-            bestCost = cost;
+    // Median of the longest axis
+    size_t half = _begin + (_end - _begin) / 2;
+    std::nth_element(m_indices.begin() + _begin, m_indices.begin() + half, m_indices.begin() + _end, [&](uint32_t _a, uint32_t _b) {
+        return m_centroids[_a][axis] < m_centroids[_b][axis];
+    });
+    return half;
+}
+
+size_t BVH::_split_sorted_midpoint(const BVHNode& _node, size_t _begin, size_t _end) {
+    size_t axis = longestAxis(_node);
+
+    // Sort elements by the longest axis
+    std::sort(m_indices.begin() + _begin, m_indices.begin() + _end, [&](uint32_t _a, uint32_t _b) {
+        return m_centroids[_a][axis] < m_centroids[_b][axis];
+    });
+    float splitPos = (_node.min[axis] + _node.max[axis]) * 0.5f;
+
+    size_t half = std::lower_bound(m_indices.begin() + _begin, m_indices.begin() + _end, splitPos, [&](uint32_t _a, float _pos) {
+        return m_centroids[_a][axis] < _pos;
+    }) - m_indices.begin();
+
+    return glm::clamp(half, _begin + 1, _end - 1);
+}
+
+size_t BVH::_split_midpoint(const BVHNode& _node, size_t _begin, size_t _end) {
+    size_t axis = longestAxis(_node);
+    float splitPos = (_node.min[axis] + _node.max[axis]) * 0.5f;
+
+    size_t half = std::partition(m_indices.begin() + _begin, m_indices.begin() + _end, [&](uint32_t _a) {
+        return m_centroids[_a][axis] < splitPos;
+    }) - m_indices.begin();
+
+    // Centroids all on one side of the box center: fall back to the median
+    // rather than leaving a large leaf
+    if ((half == _begin || half == _end) && _end - _begin > BVH_MAX_LEAF_SIZE)
+        return _split_balanced(_node, _begin, _end);
+    return half;
+}
+
+size_t BVH::_split_balanced_midpoint(const BVHNode& _node, size_t _begin, size_t _end) {
+    glm::vec3 splitPos = (_node.min + _node.max) * 0.5f;
+
+    size_t left[3] = { 0, 0, 0 };
+    for (size_t i = _begin; i < _end; i++)
+        for (size_t a = 0; a < 3; a++)
+            if (m_centroids[m_indices[i]][a] < splitPos[a])
+                left[a]++;
+
+    // Axis that splits the count the most evenly
+    size_t count = _end - _begin;
+    size_t axis = 0;
+    size_t lower_diff = count;
+    for (size_t a = 0; a < 3; a++) {
+        size_t diff = (size_t)std::abs(int(left[a]) - int(count - left[a]));
+        if (diff < lower_diff) {
+            axis = a;
+            lower_diff = diff;
         }
     }
-    axis = bestAxis;
-    float splitPos = bestPos;
 
-    std::vector<Triangle> left_el;
-    std::vector<Triangle> right_el;
+    size_t half = std::partition(m_indices.begin() + _begin, m_indices.begin() + _end, [&](uint32_t _a) {
+        return m_centroids[_a][axis] < splitPos[axis];
+    }) - m_indices.begin();
+
+    if ((half == _begin || half == _end) && _end - _begin > BVH_MAX_LEAF_SIZE)
+        return _split_balanced(_node, _begin, _end);
+    return half;
+}
+
+// Binned SAH over the centroid bounds, all three axes in one pass. Nodes
+// become leaves when splitting would not pay off and they are small enough.
+size_t BVH::_split_sah(const BVHNode& _node, size_t _begin, size_t _end) {
+    struct Bin {
+        glm::vec3   min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3   max = glm::vec3(std::numeric_limits<float>::lowest());
+        size_t      count = 0;
+    };
+
+    size_t count = _end - _begin;
+    size_t nThreads = (count > BVH_PARALLEL_NODE) ? parallelThreads(count, BVH_PARALLEL_NODE / 4) : 1;
 
-    for (size_t i = 0; i < elements.size(); i++) {
-        if (elements[i].getCentroid()[axis] < splitPos)
-            left_el.push_back(elements[i]);
-        else
-            right_el.push_back(elements[i]);
+    std::vector<Bin> partial(nThreads);
+    parallelFor(nThreads, count, [&](size_t _t, size_t _start, size_t _end) {
+        Bin& b = partial[_t];
+        for (size_t i = _begin + _start; i < _begin + _end; i++) {
+            b.min = glm::min(b.min, m_centroids[m_indices[i]]);
+            b.max = glm::max(b.max, m_centroids[m_indices[i]]);
+        }
+    });
+    glm::vec3 cmin = partial[0].min;
+    glm::vec3 cmax = partial[0].max;
+    for (size_t t = 1; t < nThreads; t++) {
+        cmin = glm::min(cmin, partial[t].min);
+        cmax = glm::max(cmax, partial[t].max);
     }
 
-    if (left_el.size() == 0 || right_el.size() == 0)
-        leaf = true;
-    else {
-        left = std::make_shared<BVH>( left_el, SPLIT_SAH );
-        right = std::make_shared<BVH>( right_el, SPLIT_SAH );
+    glm::vec3 extent = cmax - cmin;
+    glm::vec3 scale;
+    for (size_t a = 0; a < 3; a++)
+        scale[a] = (extent[a] > 0.0f) ? BVH_SAH_BINS / extent[a] : 0.0f;
+
+    auto binOf = [&](uint32_t _element, size_t _axis) {
+        size_t b = (size_t)((m_centroids[_element][_axis] - cmin[_axis]) * scale[_axis]);
+        return std::min(b, BVH_SAH_BINS - 1);
+    };
+
+    std::vector<Bin> bins(nThreads * 3 * BVH_SAH_BINS);
+    parallelFor(nThreads, count, [&](size_t _t, size_t _start, size_t _end) {
+        Bin* local = &bins[_t * 3 * BVH_SAH_BINS];
+        for (size_t i = _begin + _start; i < _begin + _end; i++) {
+            uint32_t e = m_indices[i];
+            const BoundingBox& box = m_bounds[e];
+            for (size_t a = 0; a < 3; a++) {
+                Bin& b = local[a * BVH_SAH_BINS + binOf(e, a)];
+                b.min = glm::min(b.min, box.min);
+                b.max = glm::max(b.max, box.max);
+                b.count++;
+            }
+        }
+    });
+    for (size_t t = 1; t < nThreads; t++)
+        for (size_t k = 0; k < 3 * BVH_SAH_BINS; k++) {
+            Bin& b = bins[k];
+            const Bin& o = bins[t * 3 * BVH_SAH_BINS + k];
+            b.min = glm::min(b.min, o.min);
+            b.max = glm::max(b.max, o.max);
+            b.count += o.count;
+        }
+
+    int bestAxis = -1;
+    size_t bestBin = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    float rightArea[BVH_SAH_BINS];
+    size_t rightCount[BVH_SAH_BINS];
+    for (size_t a = 0; a < 3; a++) {
+        if (scale[a] == 0.0f)
+            continue;
+
+        const Bin* axisBins = &bins[a * BVH_SAH_BINS];
+        Bin acc;
+        for (size_t b = BVH_SAH_BINS - 1; b > 0; b--) {
+            acc.min = glm::min(acc.min, axisBins[b].min);
+            acc.max = glm::max(acc.max, axisBins[b].max);
+            acc.count += axisBins[b].count;
+            rightArea[b] = acc.count ? nodeArea(acc.min, acc.max) : 0.0f;
+            rightCount[b] = acc.count;
+        }
+
+        acc = Bin();
+        for (size_t b = 0; b < BVH_SAH_BINS - 1; b++) {
+            acc.min = glm::min(acc.min, axisBins[b].min);
+            acc.max = glm::max(acc.max, axisBins[b].max);
+            acc.count += axisBins[b].count;
+            if (acc.count == 0 || rightCount[b + 1] == 0)
+                continue;
+
+            float cost = acc.count * nodeArea(acc.min, acc.max) + rightCount[b + 1] * rightArea[b + 1];
+            if (cost < bestCost) {
+                bestAxis = (int)a;
+                bestBin = b;
+                bestCost = cost;
+            }
+        }
     }
+
+    // All centroids in one spot: only a median split can still divide them
+    if (bestAxis < 0)
+        return (count > BVH_MAX_LEAF_SIZE) ? _split_balanced(_node, _begin, _end) : _end;
+
+    float splitCost = BVH_TRAVERSAL_COST + bestCost / std::max(nodeArea(_node.min, _node.max), 1e-30f);
+    if (count <= BVH_MAX_LEAF_SIZE && splitCost >= float(count))
+        return _end;
+
+    return std::partition(m_indices.begin() + _begin, m_indices.begin() + _end, [&](uint32_t _a) {
+        return binOf(_a, bestAxis) <= bestBin;
+    }) - m_indices.begin();
 }
 
+// Returns a leaf holding the elements of every leaf the ray crosses
 std::shared_ptr<BVH> BVH::hit(const Ray& _ray, float& _minDistance, float& _maxDistance) {
-    if ( !intersection(_ray, (BoundingBox)*this, _minDistance, _maxDistance) )
+    if ( m_nodes.empty() || !intersection(_ray, (BoundingBox)*this, _minDistance, _maxDistance) )
         return nullptr;
 
-    if (!leaf) {
-        float left_minT = _minDistance;
-        float left_maxT = _maxDistance;
-        std::shared_ptr<BVH> left_hit = left->hit(_ray, left_minT, left_maxT);
+    const glm::vec3& origin = _ray.getOrigin();
+    const glm::vec3& invDirection = _ray.getInvertDirection();
 
-        float right_minT = _minDistance;
-        float right_maxT = _maxDistance;
-        std::shared_ptr<BVH> right_hit = right->hit(_ray, right_minT, right_maxT);
+    std::shared_ptr<BVH> rta;
+    uint32_t stack[BVH_STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const BVHNode& node = m_nodes[index];
+        if ( !nodeHit(node, origin, invDirection, _minDistance, _maxDistance) )
+            continue;
 
-        if (left_hit != nullptr && right_hit != nullptr)
-            return std::make_shared<BVH>( *this );
-        else if (left_hit != nullptr) 
-            return left_hit;
-        else if (right_hit != nullptr)
-            return right_hit;
+        if (node.count == 0) {
+            stack[top++] = node.offset;
+            stack[top++] = index + 1;
+            continue;
+        }
 
-        return nullptr;
+        if (rta == nullptr) {
+            rta = std::make_shared<BVH>();
+            rta->min = node.min;
+            rta->max = node.max;
+        }
+        for (size_t i = node.offset; i < node.offset + node.count; i++) {
+            rta->elements.addFace( elements, m_indices[i] );
+            rta->m_vertices.insert(rta->m_vertices.end(), m_vertices.begin() + i * 3, m_vertices.begin() + i * 3 + 3);
+        }
+        rta->expand(node.min);
+        rta->expand(node.max);
+    }
+
+    if (rta != nullptr) {
+        rta->m_indices.resize(rta->elements.size());
+        std::iota(rta->m_indices.begin(), rta->m_indices.end(), 0);
+
+        BVHNode leaf;
+        leaf.min = rta->min;
+        leaf.max = rta->max;
+        leaf.offset = 0;
+        leaf.count = (uint32_t)rta->elements.size();
+        rta->m_nodes.push_back(leaf);
     }
-    else
-        return std::make_shared<BVH>( *this );
+
+    return rta;
 }
 
-glm::vec3 BVH::getClosestPointOnTriangle(const glm::vec3& _point) const {
-    glm::vec3 closest = elements[0].getClosestPoint(_point);
-    float minDist = glm::distance(closest, _point);
-
-    if (leaf) {
-        for (size_t i = 1; i < elements.size(); i++) {
-            glm::vec3 c = elements[i].getClosestPoint(_point);
-            float d = glm::distance(closest, _point);
-            if (d < minDist) {
-                closest = c;
-                minDist = d;
+void BVH::intersect(const std::vector<Ray>& _rays, std::vector<BVHHit>& _hits, float _minDistance, float _maxDistance, bool _anyHit) const {
+    _hits.assign(_rays.size(), BVHHit());
+    if (m_nodes.empty())
+        return;
+
+    // Threads take whole packets
+    size_t packets = (_rays.size() + 3) / 4;
+    parallelFor(parallelThreads(packets, 256), packets, [&](size_t, size_t _start, size_t _end) {
+        size_t begin = _start * 4;
+        size_t end = std::min(_end * 4, _rays.size());
+        _intersect(_rays.data() + begin, end - begin, _hits.data() + begin, _minDistance, _maxDistance, _anyHit);
+    });
+}
+
+bool BVH::intersect(const Ray& _ray, BVHHit& _hit, float _minDistance, float _maxDistance, bool _anyHit) const {
+    _hit = BVHHit();
+    if (!m_nodes.empty())
+        _intersect(&_ray, 1, &_hit, _minDistance, _maxDistance, _anyHit);
+    return _hit.hit();
+}
+
+// Packets of four rays walk the tree together: a node is visited when any
+// of their lanes still reaches it, the child they enter first first
+void BVH::_intersect(const Ray* _rays, size_t _count, BVHHit* _hits, float _minDistance, float _maxDistance, bool _anyHit) const {
+    float o[3][4], d[3][4], inv[3][4];
+    for (size_t first = 0; first < _count; first += 4) {
+        size_t n = std::min(_count - first, (size_t)4);
+        for (size_t k = 0; k < 4; k++) {
+            const Ray& ray = _rays[first + std::min(k, n - 1)];
+            for (size_t a = 0; a < 3; a++) {
+                o[a][k] = ray.getOrigin()[a];
+                d[a][k] = ray.getDirection()[a];
+                inv[a][k] = ray.getInvertDirection()[a];
             }
         }
+
+        RayPacket r;
+        r.ox = lanesLoad(o[0]); r.oy = lanesLoad(o[1]); r.oz = lanesLoad(o[2]);
+        r.dx = lanesLoad(d[0]); r.dy = lanesLoad(d[1]); r.dz = lanesLoad(d[2]);
+        r.ix = lanesLoad(inv[0]); r.iy = lanesLoad(inv[1]); r.iz = lanesLoad(inv[2]);
+        r.tmin = lanes(_minDistance);
+        r.tmax = lanes(_maxDistance);
+        r.active = laneMask((1 << n) - 1);
+
+        Lanes u = lanes(0.0f);
+        Lanes w = lanes(0.0f);
+        uint32_t prims[4] = { BVH_NONE, BVH_NONE, BVH_NONE, BVH_NONE };
+
+        // Children are tested before they are pushed; when popped, only the
+        // lanes that entered them before their current tmax go on
+        struct Entry {
+            Lanes       enter;
+            uint32_t    node;
+            int         bits;
+        };
+        Entry stack[BVH_STACK_SIZE];
+        size_t top = 0;
+        stack[top].node = 0;
+        stack[top].bits = laneBits(packetHitsNode(r, m_nodes[0], stack[top].enter));
+        top += (stack[top].bits != 0) ? 1 : 0;
+
+        while (top > 0) {
+            Entry entry = stack[--top];
+            LaneMask mask = both(laneMask(entry.bits), lessEqual(entry.enter, r.tmax));
+            mask = both(mask, r.active);
+            if (laneBits(mask) == 0)
+                continue;
+
+            uint32_t index = entry.node;
+            const BVHNode& node = m_nodes[index];
+            if (node.count == 0) {
+                Lanes enterA, enterB;
+                LaneMask maskA = both(mask, packetHitsNode(r, m_nodes[index + 1], enterA));
+                LaneMask maskB = both(mask, packetHitsNode(r, m_nodes[node.offset], enterB));
+                Entry childA = { enterA, index + 1, laneBits(maskA) };
+                Entry childB = { enterB, node.offset, laneBits(maskB) };
+
+                // Nearest last, so it is popped first
+                Lanes far = lanes(std::numeric_limits<float>::max());
+                if (childA.bits && childB.bits && laneMin(select(maskA, enterA, far)) < laneMin(select(maskB, enterB, far)))
+                    std::swap(childA, childB);
+                if (childA.bits)
+                    stack[top++] = childA;
+                if (childB.bits)
+                    stack[top++] = childB;
+                continue;
+            }
+
+            for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                int bits = packetHitsTriangle(r, mask, &m_vertices[i * 3], u, w);
+                for (int k = 0; k < 4; k++)
+                    if (bits & (1 << k))
+                        prims[k] = i;
+
+                // Lanes that hit something are done
+                if (_anyHit && bits) {
+                    r.active = without(r.active, laneMask(bits));
+                    mask = without(mask, laneMask(bits));
+                }
+            }
+
+            if (_anyHit && laneBits(r.active) == 0)
+                break;
+        }
+
+        float t[4], uu[4], ww[4];
+        lanesStore(t, r.tmax);
+        lanesStore(uu, u);
+        lanesStore(ww, w);
+        for (size_t k = 0; k < n; k++) {
+            if (prims[k] == BVH_NONE)
+                continue;
+            BVHHit& hit = _hits[first + k];
+            hit.t = t[k];
+            hit.triangle = m_indices[prims[k]];
+            hit.barycentric = glm::vec2(uu[k], ww[k]);
+        }
     }
-    else if (right != nullptr && left != nullptr) {
-        glm::vec3 left_c = left->getClosestPointOnTriangle(_point);
-        float left_dist = glm::distance(left_c, _point);
-        glm::vec3 right_c = right->getClosestPointOnTriangle(_point);
-        float right_dist = glm::distance(right_c, _point);
-        return (left_dist <= right_dist)? left_c : right_c;
+}
+
+// Nearest primitive (position in the leaf order) and its squared distance.
+// Children whose distances differ by more than _refinement only get the
+// nearest one visited, so small values trade exactness for speed; nodes
+// farther than the best candidate so far are always skipped.
+uint32_t BVH::_closest(const glm::vec3& _point, float _refinement, float& _distance2) const {
+    uint32_t best = BVH_NONE;
+    _distance2 = std::numeric_limits<float>::max();
+    if (m_nodes.empty())
+        return best;
+
+    uint32_t stack[BVH_STACK_SIZE];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const BVHNode& node = m_nodes[index];
+        if (nodeDistance2(node, _point) >= _distance2)
+            continue;
+
+        if (node.count > 0) {
+            for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                const glm::vec3* v = &m_vertices[i * 3];
+                glm::vec3 d = Triangle::getClosestPoint(v[0], v[1], v[2], _point) - _point;
+                float d2 = glm::dot(d, d);
+                if (d2 < _distance2) {
+                    _distance2 = d2;
+                    best = i;
+                }
+            }
+            continue;
+        }
+
+        uint32_t nearChild = index + 1;
+        uint32_t farChild = node.offset;
+        float nearDist = nodeDistance2(m_nodes[nearChild], _point);
+        float farDist = nodeDistance2(m_nodes[farChild], _point);
+        if (farDist < nearDist) {
+            std::swap(nearChild, farChild);
+            std::swap(nearDist, farDist);
+        }
+
+        if (farDist < _distance2 && std::sqrt(farDist) - std::sqrt(nearDist) <= _refinement)
+            stack[top++] = farChild;
+        if (nearDist < _distance2)
+            stack[top++] = nearChild;
     }
 
-    return closest;
+    return best;
+}
+
+glm::vec3 BVH::getClosestPointOnTriangle(const glm::vec3& _point) const {
+    float distance2;
+    uint32_t i = _closest(_point, std::numeric_limits<float>::max(), distance2);
+    if (i == BVH_NONE)
+        return _point;
+
+    return Triangle::getClosestPoint(m_vertices[i * 3], m_vertices[i * 3 + 1], m_vertices[i * 3 + 2], _point);
 }
 
 float BVH::getClosestDistance(const glm::vec3& _point) const {
-    float minDist = 3.0e+038;
-    if (leaf) {
-        for (size_t i = 0; i < elements.size(); i++) {
-            float d = elements[i].getClosestDistance(_point);
-            if (d < minDist)
-                minDist = d;
-        }
-    }
-    else if (right != nullptr && left != nullptr) {
-        float left_dist = left->getClosestDistance(_point);
-        float right_dist = right->getClosestDistance(_point);
-        if (left_dist <= right_dist)
-            return left_dist;
-        else 
-            return right_dist;
-    }
-    return minDist;
+    float distance2;
+    if (_closest(_point, std::numeric_limits<float>::max(), distance2) == BVH_NONE)
+        return 3.0e+038;
+    return std::sqrt(distance2);
 }
 
 float BVH::getClosestSignedDistance(const glm::vec3& _point, float _refinement) const {
-    float minDist = 3.0e+038;
-    if (leaf) {
-        float d = minDist;
-        for (size_t i = 0; i < elements.size(); i++) {
-            d = elements[i].getClosestSignedDistance(_point);
-            if (abs(d) < abs(minDist))
-                minDist = d;
-            
-        }
-        return minDist;
-    }
-    else if (right != nullptr && left != nullptr) {
-        float left_dist  = abs( _point[axis] - left->getClosestOn(_point[axis], axis) );
-        float right_dist = abs( _point[axis] - right->getClosestOn(_point[axis], axis) );
-
-        if ( abs(left_dist - right_dist) <= _refinement) {
-        // if (left_dist == right_dist) {
-            left_dist = left->getClosestSignedDistance(_point, _refinement);
-            right_dist = right->getClosestSignedDistance(_point, _refinement);
-            if (abs(left_dist) < abs(right_dist))
-                return left_dist;
-            else 
-                return right_dist;
-        }
-        else if (left_dist <= right_dist)
-            return left->getClosestSignedDistance(_point, _refinement);
-        else 
-            return right->getClosestSignedDistance(_point, _refinement);
-
-    }
-    return minDist;
+    float distance2;
+    uint32_t i = _closest(_point, _refinement, distance2);
+    if (i == BVH_NONE)
+        return 3.0e+038;
+    return elements.getClosestSignedDistance(m_indices[i], _point);
 }
 
 glm::vec4 BVH::getClosestRGBSignedDistance(const glm::vec3& _point, float _refinement) const {
-    glm::vec4 closest = glm::vec4(1.0f, 1.0f, 1.0f, float(10.0));
+    float distance2;
+    uint32_t i = _closest(_point, _refinement, distance2);
+    if (i == BVH_NONE)
+        return glm::vec4(1.0f, 1.0f, 1.0f, float(10.0));
+    return elements.getClosestRGBSignedDistance(m_indices[i], _point);
+}
+
+// Nearest primitives of consecutive points, four at a time. Each four
+// start from what the previous four found, which for neighbouring points is
+// already close to the answer and prunes most of the tree. Nodes that can
+// not beat the best so far by more than _tolerance are skipped too.
+void BVH::_closest(const glm::vec3* _points, size_t _count, uint32_t* _primitives, float* _distances2, float _tolerance) const {
+    uint32_t seeds[4] = { BVH_NONE, BVH_NONE, BVH_NONE, BVH_NONE };
+    float x[4], y[4], z[4];
 
-    if (leaf) {
-        glm::vec4 d = closest;
-        for (size_t i = 0; i < elements.size(); i++) {
-            d = elements[i].getClosestRGBSignedDistance(_point);
-            if (abs(d.a) < abs(closest.a))
-                closest = d;
+    for (size_t first = 0; first < _count; first += 4) {
+        size_t n = std::min(_count - first, (size_t)4);
+        for (size_t k = 0; k < 4; k++) {
+            const glm::vec3& p = _points[first + std::min(k, n - 1)];
+            x[k] = p.x;
+            y[k] = p.y;
+            z[k] = p.z;
         }
-        return closest;
-    }
-    else if (right != nullptr && left != nullptr) {
-        float left_dist  = abs( _point[axis] - left->getClosestOn(_point[axis], axis) );
-        float right_dist = abs( _point[axis] - right->getClosestOn(_point[axis], axis) );
-
-        if ( abs(left_dist - right_dist) <= _refinement ) {
-        // if (left_dist == right_dist) {
-            glm::vec4 left_rgbd = left->getClosestRGBSignedDistance(_point, _refinement);
-            glm::vec4 right_rgbd = right->getClosestRGBSignedDistance(_point, _refinement);
-            if (abs(left_rgbd.a) < abs(right_rgbd.a))
-                return left_rgbd;
-            else 
-                return right_rgbd;
-        }
-        else if (left_dist <= right_dist)
-            return left->getClosestRGBSignedDistance(_point, _refinement);
-        else 
-            return right->getClosestRGBSignedDistance(_point, _refinement);
+        Lanes px = lanesLoad(x), py = lanesLoad(y), pz = lanesLoad(z);
+
+        // Nodes are only visited when closer than limit
+        Lanes best = lanes(std::numeric_limits<float>::max());
+        Lanes limit = best;
+        uint32_t prims[4] = { BVH_NONE, BVH_NONE, BVH_NONE, BVH_NONE };
+        auto test = [&](uint32_t _prim, LaneMask _mask) {
+            Lanes d2 = packetTriangleDistance2(px, py, pz, &m_vertices[_prim * 3]);
+            LaneMask closer = both(_mask, less(d2, best));
+            int bits = laneBits(closer);
+            if (bits == 0)
+                return;
+
+            best = select(closer, d2, best);
+            if (_tolerance > 0.0f) {
+                Lanes reach = lanesMax(sub(sqrt(best), lanes(_tolerance)), lanes(0.0f));
+                limit = mul(reach, reach);
+            }
+            else
+                limit = best;
+            for (int k = 0; k < 4; k++)
+                if (bits & (1 << k))
+                    prims[k] = _prim;
+        };
+
+        LaneMask all = laneMask(0xf);
+        for (size_t k = 0; k < 4; k++)
+            if (seeds[k] != BVH_NONE && std::find(seeds, seeds + k, seeds[k]) == seeds + k)
+                test(seeds[k], all);
+
+        struct Entry {
+            Lanes       distance2;
+            uint32_t    node;
+            int         bits;
+        };
+        Entry stack[BVH_STACK_SIZE];
+        size_t top = 0;
+        stack[top].distance2 = packetNodeDistance2(px, py, pz, m_nodes[0]);
+        stack[top].node = 0;
+        stack[top].bits = laneBits(less(stack[top].distance2, limit));
+        top += (stack[top].bits != 0) ? 1 : 0;
+
+        while (top > 0) {
+            Entry entry = stack[--top];
+            LaneMask mask = both(laneMask(entry.bits), less(entry.distance2, limit));
+            if (laneBits(mask) == 0)
+                continue;
+
+            uint32_t index = entry.node;
+            const BVHNode& node = m_nodes[index];
+            if (node.count > 0) {
+                for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                    test(i, mask);
+                continue;
+            }
+
+            Entry childA, childB;
+            childA.node = index + 1;
+            childA.distance2 = packetNodeDistance2(px, py, pz, m_nodes[childA.node]);
+            LaneMask maskA = both(mask, less(childA.distance2, limit));
+            childA.bits = laneBits(maskA);
+            childB.node = node.offset;
+            childB.distance2 = packetNodeDistance2(px, py, pz, m_nodes[childB.node]);
+            LaneMask maskB = both(mask, less(childB.distance2, limit));
+            childB.bits = laneBits(maskB);
 
+            // Nearest last, so it is popped first
+            Lanes far = lanes(std::numeric_limits<float>::max());
+            if (childA.bits && childB.bits && laneMin(select(maskA, childA.distance2, far)) < laneMin(select(maskB, childB.distance2, far)))
+                std::swap(childA, childB);
+            if (childA.bits)
+                stack[top++] = childA;
+            if (childB.bits)
+                stack[top++] = childB;
+        }
+
+        float d2[4];
+        lanesStore(d2, best);
+        for (size_t k = 0; k < n; k++) {
+            _primitives[first + k] = prims[k];
+            _distances2[first + k] = d2[k];
+        }
+        std::copy(prims, prims + 4, seeds);
     }
-    return closest;
+}
+
+void BVH::getClosestDistances(const std::vector<glm::vec3>& _points, std::vector<float>& _distances, std::vector<uint32_t>* _triangles, float _tolerance) const {
+    _distances.assign(_points.size(), 3.0e+038f);
+    if (_triangles)
+        _triangles->assign(_points.size(), BVHHit::NONE);
+    if (m_nodes.empty())
+        return;
+
+    std::vector<uint32_t> prims(_points.size());
+    size_t packets = (_points.size() + 3) / 4;
+    parallelFor(parallelThreads(packets, 64), packets, [&](size_t, size_t _start, size_t _end) {
+        size_t begin = _start * 4;
+        size_t end = std::min(_end * 4, _points.size());
+        _closest(&_points[begin], end - begin, &prims[begin], &_distances[begin], _tolerance);
+        for (size_t i = begin; i < end; i++) {
+            if (prims[i] == BVH_NONE) {
+                _distances[i] = 3.0e+038f;
+                continue;
+            }
+            _distances[i] = std::sqrt(_distances[i]);
+            if (_triangles)
+                (*_triangles)[i] = m_indices[prims[i]];
+        }
+    });
+}
+
+void BVH::getClosestSignedDistances(const std::vector<glm::vec3>& _points, std::vector<float>& _distances, std::vector<uint32_t>* _triangles, float _tolerance) const {
+    _distances.assign(_points.size(), 3.0e+038f);
+    if (_triangles)
+        _triangles->assign(_points.size(), BVHHit::NONE);
+    if (m_nodes.empty())
+        return;
+
+    std::vector<uint32_t> prims(_points.size());
+    size_t packets = (_points.size() + 3) / 4;
+    parallelFor(parallelThreads(packets, 64), packets, [&](size_t, size_t _start, size_t _end) {
+        size_t begin = _start * 4;
+        size_t end = std::min(_end * 4, _points.size());
+        _closest(&_points[begin], end - begin, &prims[begin], &_distances[begin], _tolerance);
+        for (size_t i = begin; i < end; i++) {
+            if (prims[i] == BVH_NONE) {
+                _distances[i] = 3.0e+038f;
+                continue;
+            }
+            uint32_t element = m_indices[prims[i]];
+            _distances[i] = elements.getClosestSignedDistance(element, _points[i]);
+            if (_triangles)
+                (*_triangles)[i] = element;
+        }
+    });
+}
+
+void BVH::getClosestRGBSignedDistances(const std::vector<glm::vec3>& _points, std::vector<glm::vec4>& _rgbd, std::vector<uint32_t>* _triangles, float _tolerance) const {
+    _rgbd.assign(_points.size(), glm::vec4(1.0f, 1.0f, 1.0f, float(10.0)));
+    if (_triangles)
+        _triangles->assign(_points.size(), BVHHit::NONE);
+    if (m_nodes.empty())
+        return;
+
+    std::vector<uint32_t> prims(_points.size());
+    std::vector<float> distances2(_points.size());
+    size_t packets = (_points.size() + 3) / 4;
+    parallelFor(parallelThreads(packets, 64), packets, [&](size_t, size_t _start, size_t _end) {
+        size_t begin = _start * 4;
+        size_t end = std::min(_end * 4, _points.size());
+        _closest(&_points[begin], end - begin, &prims[begin], &distances2[begin], _tolerance);
+        for (size_t i = begin; i < end; i++) {
+            if (prims[i] == BVH_NONE)
+                continue;
+            uint32_t element = m_indices[prims[i]];
+            _rgbd[i] = elements.getClosestRGBSignedDistance(element, _points[i]);
+            if (_triangles)
+                (*_triangles)[i] = element;
+        }
+    });
 }
 
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "vera/types/gsplat.h"
+#include "vera/types/model.h"
 #include "vera/ops/fs.h"
 #include "vera/ops/draw.h"
+#include "vera/ops/parallel.h"
 #include "vera/gl/gl.h"
 #include "vera/shaders/gsplat.h"
 #include "vera/shaders/defaultShaders.h"
@@ -11,14 +13,61 @@
 #define TINYPLY_IMPLEMENTATION
 #include "tinyply.h"
 
+#include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <sstream>
 #include <algorithm>
 #include <numeric>
+#include <limits>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GSPLAT_SIMD_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define GSPLAT_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 // Spherical harmonics constant
 constexpr float SH_C0 = 0.28209479177387814f;
 
+// Sign each higher-order SH basis function (bands 1..3, 3DGS order) takes
+// under the COLMAP -> OpenGL flip (y and z negated): odd in y or z flips
+static const float SH_FLIP_SIGN[15] = {
+    -1.0f, -1.0f, 1.0f,
+    -1.0f, 1.0f, 1.0f, -1.0f, 1.0f,
+    -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f, 1.0f };
+
+// Higher-order SH basis functions (bands 1..3, same order and constants as
+// evalSH() in the splat shaders) at the unit direction _dir
+static void splatSHBasis(const glm::vec3& _dir, float* _basis) {
+    static const float SH_C1 = 0.4886025119029199f;
+    static const float SH_C2[5] = { 1.0925484305920792f, -1.0925484305920792f, 0.31539156525252005f, -1.0925484305920792f, 0.5462742152960396f };
+    static const float SH_C3[7] = { -0.5900435899266435f, 2.890611442640554f, -0.4570457994644658f, 0.3731763325901154f, -0.4570457994644658f, 1.445305721320277f, -0.5900435899266435f };
+
+    float x = _dir.x, y = _dir.y, z = _dir.z;
+    float xx = x * x, yy = y * y, zz = z * z;
+    _basis[0] = -SH_C1 * y;
+    _basis[1] = SH_C1 * z;
+    _basis[2] = -SH_C1 * x;
+    _basis[3] = SH_C2[0] * x * y;
+    _basis[4] = SH_C2[1] * y * z;
+    _basis[5] = SH_C2[2] * (2.0f * zz - xx - yy);
+    _basis[6] = SH_C2[3] * x * z;
+    _basis[7] = SH_C2[4] * (xx - yy);
+    _basis[8] = SH_C3[0] * y * (3.0f * xx - yy);
+    _basis[9] = SH_C3[1] * x * y * z;
+    _basis[10] = SH_C3[2] * y * (4.0f * zz - xx - yy);
+    _basis[11] = SH_C3[3] * z * (2.0f * zz - 3.0f * xx - 3.0f * yy);
+    _basis[12] = SH_C3[4] * x * (4.0f * zz - xx - yy);
+    _basis[13] = SH_C3[5] * z * (xx - yy);
+    _basis[14] = SH_C3[6] * x * (xx - 3.0f * yy);
+}
+
 // Morton Encoding Helpers
 inline uint32_t expandBits(uint32_t v) {
     v = (v * 0x00010001u) & 0xFF0000FFu;
@@ -44,6 +93,14 @@ inline uint32_t morton3D(const glm::vec3& pos, const glm::vec3& min, const glm::
     return xx | (yy << 1) | (zz << 2);
 }
 
+// Maps a float to a uint32 that sorts in the same order (negatives included):
+// flip every bit of negatives, only the sign bit of positives.
+static inline uint32_t floatToSortable(float _value) {
+    uint32_t bits;
+    std::memcpy(&bits, &_value, sizeof(uint32_t));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
 // Pack two 16-bit halfs into a 32-bit uint
 uint16_t floatToHalf(float value) {
     // Avoid type-punning UB by using memcpy
@@ -119,36 +176,803 @@ float splatNormalConfidence(glm::vec3 _scale) {
     return glm::clamp((_scale.y - _scale.x) / std::max(_scale.z, 1e-6f), 0.0f, 1.0f);
 }
 
+// Per-splat depth and clip test of the sort. Splats the vertex shader would
+// throw away anyway (see "Frustum culling" in splat_vert: outside the near/
+// far planes or 20% past the screen edges) never reach the sort; the rest
+// get their w_clip depth written next to their index. Splat k of a call is
+// _indices[k], or _begin + k for a contiguous run, and outputs are packed
+// from the front, so _depths/_values may alias the input (as in LOD cuts).
+struct SplatClipRows {
+    float x[4], y[4], z[4], w[4];   // rows of viewProj
+};
+
+static const float SPLAT_CLIP_GUARD = 1.2f;
+
+typedef size_t (*SplatCullKernel)(const float* _x, const float* _y, const float* _z,
+                                  const uint32_t* _indices, uint32_t _begin, size_t _count,
+                                  const SplatClipRows& _clip, float* _depths, uint32_t* _values);
+
+static size_t cullSplatsScalar(const float* _x, const float* _y, const float* _z,
+                               const uint32_t* _indices, uint32_t _begin, size_t _count,
+                               const SplatClipRows& _clip, float* _depths, uint32_t* _values) {
+    size_t out = 0;
+    for (size_t k = 0; k < _count; k++) {
+        uint32_t i = _indices ? _indices[k] : _begin + (uint32_t)k;
+        float px = _x[i], py = _y[i], pz = _z[i];
+        float cx = _clip.x[0] * px + _clip.x[1] * py + _clip.x[2] * pz + _clip.x[3];
+        float cy = _clip.y[0] * px + _clip.y[1] * py + _clip.y[2] * pz + _clip.y[3];
+        float cz = _clip.z[0] * px + _clip.z[1] * py + _clip.z[2] * pz + _clip.z[3];
+        float w  = _clip.w[0] * px + _clip.w[1] * py + _clip.w[2] * pz + _clip.w[3];
+        float guard = SPLAT_CLIP_GUARD * w;
+        bool inside = cz >= -w && cz <= w && std::abs(cx) <= guard && std::abs(cy) <= guard;
+
+        // Branchless: always write, only advance for accepted splats
+        _values[out] = i;
+        _depths[out] = w;
+        out += inside ? 1 : 0;
+    }
+    return out;
+}
+
+#if defined(GSPLAT_SIMD_X86)
+// Lane permutations moving the accepted lanes of an 8-lane mask to the front
+static const std::vector<uint32_t>& compactTable() {
+    static const std::vector<uint32_t> table = []() {
+        std::vector<uint32_t> t(256 * 8, 0);
+        for (int mask = 0; mask < 256; mask++) {
+            int n = 0;
+            for (int lane = 0; lane < 8; lane++)
+                if (mask & (1 << lane))
+                    t[mask * 8 + n++] = lane;
+        }
+        return t;
+    }();
+    return table;
+}
+
+__attribute__((target("avx2")))
+static size_t cullSplatsAVX2(const float* _x, const float* _y, const float* _z,
+                             const uint32_t* _indices, uint32_t _begin, size_t _count,
+                             const SplatClipRows& _clip, float* _depths, uint32_t* _values) {
+    const uint32_t* table = compactTable().data();
+
+    __m256 x0 = _mm256_set1_ps(_clip.x[0]), x1 = _mm256_set1_ps(_clip.x[1]), x2 = _mm256_set1_ps(_clip.x[2]), x3 = _mm256_set1_ps(_clip.x[3]);
+    __m256 y0 = _mm256_set1_ps(_clip.y[0]), y1 = _mm256_set1_ps(_clip.y[1]), y2 = _mm256_set1_ps(_clip.y[2]), y3 = _mm256_set1_ps(_clip.y[3]);
+    __m256 z0 = _mm256_set1_ps(_clip.z[0]), z1 = _mm256_set1_ps(_clip.z[1]), z2 = _mm256_set1_ps(_clip.z[2]), z3 = _mm256_set1_ps(_clip.z[3]);
+    __m256 w0 = _mm256_set1_ps(_clip.w[0]), w1 = _mm256_set1_ps(_clip.w[1]), w2 = _mm256_set1_ps(_clip.w[2]), w3 = _mm256_set1_ps(_clip.w[3]);
+    __m256 guardScale = _mm256_set1_ps(SPLAT_CLIP_GUARD);
+    __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    size_t out = 0;
+    size_t k = 0;
+    for (; k + 8 <= _count; k += 8) {
+        __m256i idx;
+        __m256 px, py, pz;
+        if (_indices) {
+            idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_indices + k));
+            px = _mm256_i32gather_ps(_x, idx, 4);
+            py = _mm256_i32gather_ps(_y, idx, 4);
+            pz = _mm256_i32gather_ps(_z, idx, 4);
+        }
+        else {
+            uint32_t first = _begin + (uint32_t)k;
+            idx = _mm256_add_epi32(_mm256_set1_epi32((int)first), laneOffsets);
+            px = _mm256_loadu_ps(_x + first);
+            py = _mm256_loadu_ps(_y + first);
+            pz = _mm256_loadu_ps(_z + first);
+        }
+
+        // Same operation order as the scalar kernel: identical depths
+        __m256 cx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x0, px), _mm256_mul_ps(x1, py)), _mm256_mul_ps(x2, pz)), x3);
+        __m256 cy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y0, px), _mm256_mul_ps(y1, py)), _mm256_mul_ps(y2, pz)), y3);
+        __m256 cz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(z0, px), _mm256_mul_ps(z1, py)), _mm256_mul_ps(z2, pz)), z3);
+        __m256 w  = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, px), _mm256_mul_ps(w1, py)), _mm256_mul_ps(w2, pz)), w3);
+        __m256 guard = _mm256_mul_ps(guardScale, w);
+        __m256 negW = _mm256_sub_ps(_mm256_setzero_ps(), w);
+
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(cz, negW, _CMP_GE_OQ), _mm256_cmp_ps(cz, w, _CMP_LE_OQ));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_and_ps(cx, absMask), guard, _CMP_LE_OQ));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_and_ps(cy, absMask), guard, _CMP_LE_OQ));
+
+        int mask = _mm256_movemask_ps(inside);
+        if (mask == 0)
+            continue;
+
+        // out <= k, so the 8-lane stores never pass what was already read
+        __m256i perm = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + mask * 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(_values + out), _mm256_permutevar8x32_epi32(idx, perm));
+        _mm256_storeu_ps(_depths + out, _mm256_permutevar8x32_ps(w, perm));
+        out += __builtin_popcount(mask);
+    }
+
+    // The compiler doesn't always clear the upper ymm halves on this path,
+    // which would slow down every SSE instruction after it
+    _mm256_zeroupper();
+    if (k < _count)
+        out += cullSplatsScalar(_x, _y, _z, _indices ? _indices + k : nullptr, _begin + (uint32_t)k, _count - k, _clip, _depths + out, _values + out);
+    return out;
+}
+#endif
+
+#if defined(GSPLAT_SIMD_NEON)
+static size_t cullSplatsNEON(const float* _x, const float* _y, const float* _z,
+                             const uint32_t* _indices, uint32_t _begin, size_t _count,
+                             const SplatClipRows& _clip, float* _depths, uint32_t* _values) {
+    float32x4_t guardScale = vdupq_n_f32(SPLAT_CLIP_GUARD);
+    uint32x4_t laneOffsets = { 0, 1, 2, 3 };
+
+    size_t out = 0;
+    size_t k = 0;
+    for (; k + 4 <= _count; k += 4) {
+        uint32x4_t idx;
+        float32x4_t px, py, pz;
+        if (_indices) {
+            // No gather on NEON: the lane loads are what it costs
+            idx = vld1q_u32(_indices + k);
+            float gx[4] = { _x[_indices[k]], _x[_indices[k + 1]], _x[_indices[k + 2]], _x[_indices[k + 3]] };
+            float gy[4] = { _y[_indices[k]], _y[_indices[k + 1]], _y[_indices[k + 2]], _y[_indices[k + 3]] };
+            float gz[4] = { _z[_indices[k]], _z[_indices[k + 1]], _z[_indices[k + 2]], _z[_indices[k + 3]] };
+            px = vld1q_f32(gx);
+            py = vld1q_f32(gy);
+            pz = vld1q_f32(gz);
+        }
+        else {
+            uint32_t first = _begin + (uint32_t)k;
+            idx = vaddq_u32(vdupq_n_u32(first), laneOffsets);
+            px = vld1q_f32(_x + first);
+            py = vld1q_f32(_y + first);
+            pz = vld1q_f32(_z + first);
+        }
+
+        // Separate multiplies and adds (no vmla/vfma): identical depths to the scalar kernel
+        float32x4_t cx = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(px, _clip.x[0]), vmulq_n_f32(py, _clip.x[1])), vmulq_n_f32(pz, _clip.x[2])), vdupq_n_f32(_clip.x[3]));
+        float32x4_t cy = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(px, _clip.y[0]), vmulq_n_f32(py, _clip.y[1])), vmulq_n_f32(pz, _clip.y[2])), vdupq_n_f32(_clip.y[3]));
+        float32x4_t cz = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(px, _clip.z[0]), vmulq_n_f32(py, _clip.z[1])), vmulq_n_f32(pz, _clip.z[2])), vdupq_n_f32(_clip.z[3]));
+        float32x4_t w  = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(px, _clip.w[0]), vmulq_n_f32(py, _clip.w[1])), vmulq_n_f32(pz, _clip.w[2])), vdupq_n_f32(_clip.w[3]));
+        float32x4_t guard = vmulq_f32(guardScale, w);
+
+        uint32x4_t inside = vandq_u32(vcgeq_f32(cz, vnegq_f32(w)), vcleq_f32(cz, w));
+        inside = vandq_u32(inside, vcleq_f32(vabsq_f32(cx), guard));
+        inside = vandq_u32(inside, vcleq_f32(vabsq_f32(cy), guard));
+
+        uint32_t lanes[4], accepted[4];
+        float depths[4];
+        vst1q_u32(lanes, idx);
+        vst1q_u32(accepted, inside);
+        vst1q_f32(depths, w);
+        for (int lane = 0; lane < 4; lane++) {
+            _values[out] = lanes[lane];
+            _depths[out] = depths[lane];
+            out += accepted[lane] & 1;
+        }
+    }
+
+    if (k < _count)
+        out += cullSplatsScalar(_x, _y, _z, _indices ? _indices + k : nullptr, _begin + (uint32_t)k, _count - k, _clip, _depths + out, _values + out);
+    return out;
+}
+#endif
+
+// Picked once, on first use, from what the running CPU supports
+static SplatCullKernel cullKernel() {
+    static const SplatCullKernel kernel = []() -> SplatCullKernel {
+#if defined(GSPLAT_SIMD_X86)
+        if (__builtin_cpu_supports("avx2"))
+            return cullSplatsAVX2;
+#endif
+#if defined(GSPLAT_SIMD_NEON)
+        return cullSplatsNEON;
+#endif
+        return cullSplatsScalar;
+    }();
+    return kernel;
+}
+
+// Software occlusion buffer: NDC depth of the occluder hulls over the
+// viewport at a fixed low resolution, in square tiles for the coarse test
+static const int SPLAT_OCCLUSION_WIDTH = 256;
+static const int SPLAT_OCCLUSION_HEIGHT = 128;
+static const int SPLAT_OCCLUSION_TILE = 8;
+
+// A block is an occluder when the cross-sections of its opaque splats add
+// up to the area of its bounds seen along all three axes
+static const float SPLAT_OCCLUDER_ALPHA = 0.5f;
+static const float SPLAT_OCCLUDER_COVERAGE = 1.0f;
+
+// Row kernels of the occlusion buffer, over pixels [_x0, _x1): writing an
+// occluder span of depth _z + _dzdx * x (nearest wins), and testing whether
+// every pixel of a span is nearer than _depth.
+struct SplatOcclusionKernels {
+    void (*write)(float* _row, int _x0, int _x1, float _z, float _dzdx);
+    bool (*hidden)(const float* _row, int _x0, int _x1, float _depth);
+};
+
+static void occlusionWriteScalar(float* _row, int _x0, int _x1, float _z, float _dzdx) {
+    for (int x = _x0; x < _x1; x++)
+        _row[x] = std::min(_row[x], _z + _dzdx * (float)x);
+}
+
+static bool occlusionHiddenScalar(const float* _row, int _x0, int _x1, float _depth) {
+    for (int x = _x0; x < _x1; x++)
+        if (_row[x] >= _depth)
+            return false;
+    return true;
+}
+
+#if defined(GSPLAT_SIMD_X86)
+__attribute__((target("sse2")))
+static void occlusionWriteSSE(float* _row, int _x0, int _x1, float _z, float _dzdx) {
+    __m128 z = _mm_set1_ps(_z);
+    __m128 dzdx = _mm_set1_ps(_dzdx);
+    __m128 xs = _mm_setr_ps((float)_x0, (float)(_x0 + 1), (float)(_x0 + 2), (float)(_x0 + 3));
+    __m128 four = _mm_set1_ps(4.0f);
+
+    int x = _x0;
+    for (; x + 4 <= _x1; x += 4) {
+        __m128 depth = _mm_add_ps(z, _mm_mul_ps(dzdx, xs));
+        _mm_storeu_ps(_row + x, _mm_min_ps(_mm_loadu_ps(_row + x), depth));
+        xs = _mm_add_ps(xs, four);
+    }
+    occlusionWriteScalar(_row, x, _x1, _z, _dzdx);
+}
+
+__attribute__((target("sse2")))
+static bool occlusionHiddenSSE(const float* _row, int _x0, int _x1, float _depth) {
+    __m128 depth = _mm_set1_ps(_depth);
+
+    int x = _x0;
+    for (; x + 4 <= _x1; x += 4)
+        if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(_row + x), depth)))
+            return false;
+    return occlusionHiddenScalar(_row, x, _x1, _depth);
+}
+#endif
+
+#if defined(GSPLAT_SIMD_NEON)
+static void occlusionWriteNEON(float* _row, int _x0, int _x1, float _z, float _dzdx) {
+    float32x4_t z = vdupq_n_f32(_z);
+    float first[4] = { (float)_x0, (float)(_x0 + 1), (float)(_x0 + 2), (float)(_x0 + 3) };
+    float32x4_t xs = vld1q_f32(first);
+    float32x4_t four = vdupq_n_f32(4.0f);
+
+    int x = _x0;
+    for (; x + 4 <= _x1; x += 4) {
+        float32x4_t depth = vaddq_f32(z, vmulq_n_f32(xs, _dzdx));
+        vst1q_f32(_row + x, vminq_f32(vld1q_f32(_row + x), depth));
+        xs = vaddq_f32(xs, four);
+    }
+    occlusionWriteScalar(_row, x, _x1, _z, _dzdx);
+}
+
+static bool occlusionHiddenNEON(const float* _row, int _x0, int _x1, float _depth) {
+    float32x4_t depth = vdupq_n_f32(_depth);
+
+    int x = _x0;
+    for (; x + 4 <= _x1; x += 4) {
+        uint32x4_t farther = vcgeq_f32(vld1q_f32(_row + x), depth);
+        uint32x2_t any = vorr_u32(vget_low_u32(farther), vget_high_u32(farther));
+        if (vget_lane_u32(vpmax_u32(any, any), 0))
+            return false;
+    }
+    return occlusionHiddenScalar(_row, x, _x1, _depth);
+}
+#endif
+
+static const SplatOcclusionKernels& occlusionKernels() {
+    static const SplatOcclusionKernels kernels = []() -> SplatOcclusionKernels {
+#if defined(GSPLAT_SIMD_X86)
+        if (__builtin_cpu_supports("sse2"))
+            return { occlusionWriteSSE, occlusionHiddenSSE };
+#endif
+#if defined(GSPLAT_SIMD_NEON)
+        return { occlusionWriteNEON, occlusionHiddenNEON };
+#endif
+        return { occlusionWriteScalar, occlusionHiddenScalar };
+    }();
+    return kernels;
+}
+
+// Eigen decomposition of a symmetric 3x3 matrix (cyclic Jacobi): eigenvalues
+// in _values, matching unit eigenvectors in the columns of _vectors.
+static void symmetricEigen(const glm::mat3& _m, glm::vec3& _values, glm::mat3& _vectors) {
+    float a[3][3];
+    float v[3][3] = { {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f} };
+    for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++)
+            a[r][c] = _m[c][r];
+
+    static const int pairs[3][2] = { {0, 1}, {0, 2}, {1, 2} };
+    for (int sweep = 0; sweep < 16; sweep++) {
+        float off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        float diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        if (off <= 1e-14f * diag || off == 0.0f)
+            break;
+
+        for (const auto& pq : pairs) {
+            int p = pq[0], q = pq[1];
+            if (a[p][q] == 0.0f)
+                continue;
+
+            float theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]);
+            float t = (theta >= 0.0f ? 1.0f : -1.0f) / (std::abs(theta) + std::sqrt(theta * theta + 1.0f));
+            float c = 1.0f / std::sqrt(t * t + 1.0f);
+            float s = t * c;
+
+            for (int k = 0; k < 3; k++) {
+                float akp = a[k][p], akq = a[k][q];
+                a[k][p] = c * akp - s * akq;
+                a[k][q] = s * akp + c * akq;
+            }
+            for (int k = 0; k < 3; k++) {
+                float apk = a[p][k], aqk = a[q][k];
+                a[p][k] = c * apk - s * aqk;
+                a[q][k] = s * apk + c * aqk;
+            }
+            for (int k = 0; k < 3; k++) {
+                float vkp = v[k][p], vkq = v[k][q];
+                v[k][p] = c * vkp - s * vkq;
+                v[k][q] = s * vkp + c * vkq;
+            }
+        }
+    }
+
+    for (int j = 0; j < 3; j++) {
+        _values[j] = a[j][j];
+        _vectors[j] = glm::vec3(v[0][j], v[1][j], v[2][j]);
+    }
+}
+
+// .vsplat container (all little endian):
+//
+//   VsplatHeader
+//   VsplatChunk[chunkCount]
+//   splatCount records, chunk after chunk, each VSPLAT_RECORD_BYTES followed
+//   by ((shDegree + 1)^2 - 1) * 3 bytes of SH (Gsplat::m_shCoeffs layout)
+//
+// A record holds the position as 3 x 16 bits relative to its chunk bounds,
+// the rotation in smallest-three encoding (32 bits), the log-scale as
+// 3 x 8 bits over the file's logScaleRange and the RGBA8 color.
+static const char       VSPLAT_MAGIC[4] = { 'V', 'S', 'P', 'L' };
+static const uint32_t   VSPLAT_VERSION = 1;
+static const uint32_t   VSPLAT_FLAG_COLMAP_FRAME = 1;
+static const size_t     VSPLAT_RECORD_BYTES = 17;
+
+struct VsplatHeader {
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    splatCount;
+    uint32_t    chunkCount;
+    uint32_t    shDegree;
+    uint32_t    flags;
+    float       shRange[2];
+    float       logScaleRange[2];
+};
+
+struct VsplatChunk {
+    float       minBounds[3];
+    float       maxBounds[3];
+    uint32_t    first;
+    uint32_t    count;
+    float       importance;     // sum of opacity * largest scale^2, for streaming
+    uint32_t    reserved;
+};
+
+static_assert(sizeof(VsplatHeader) == 40, "VsplatHeader must be tightly packed");
+static_assert(sizeof(VsplatChunk) == 40, "VsplatChunk must be tightly packed");
+
+// Drops the largest (in magnitude) quaternion component, made positive so
+// it can be rebuilt from the other three, each stored in 10 bits over
+// [-1/sqrt(2), 1/sqrt(2)]. Its index goes in the top 2 bits.
+static uint32_t packSmallestThree(const glm::quat& _q) {
+    glm::quat q = glm::normalize(_q);
+    float c[4] = { q.x, q.y, q.z, q.w };
+
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+        if (std::abs(c[i]) > std::abs(c[largest]))
+            largest = i;
+    float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+    uint32_t bits = (uint32_t)largest << 30;
+    int shift = 20;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float v = glm::clamp(c[i] * sign * 0.70710678f + 0.5f, 0.0f, 1.0f);
+        bits |= (uint32_t)(v * 1023.0f + 0.5f) << shift;
+        shift -= 10;
+    }
+    return bits;
+}
+
+static glm::quat unpackSmallestThree(uint32_t _bits) {
+    int largest = (int)(_bits >> 30);
+    float c[4];
+    float sum = 0.0f;
+    int shift = 20;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        c[i] = (((_bits >> shift) & 0x3ffu) / 1023.0f - 0.5f) * 1.41421356f;
+        sum += c[i] * c[i];
+        shift -= 10;
+    }
+    c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return glm::normalize(glm::quat(c[3], c[0], c[1], c[2]));
+}
+
+// Header, chunk table and record size of a mapped .vsplat (validated), and
+// the per-chunk decoder shared by the regular and progressive loaders
+struct VsplatLayout {
+    VsplatHeader                header;
+    std::vector<VsplatChunk>    chunks;
+    const uint8_t*              records = nullptr;
+    size_t                      recordBytes = 0;
+
+    void read(const vera::MappedFile& _file, const std::string& _filepath) {
+        if (_file.size() < sizeof(VsplatHeader)) {
+            throw std::runtime_error("VSPLAT file too small: " + _filepath);
+        }
+        std::memcpy(&header, _file.data(), sizeof(VsplatHeader));
+        if (std::memcmp(header.magic, VSPLAT_MAGIC, 4) != 0 || header.version != VSPLAT_VERSION || header.shDegree > 3) {
+            throw std::runtime_error("Unsupported VSPLAT file: " + _filepath);
+        }
+
+        size_t fileShBytes = ((header.shDegree + 1) * (header.shDegree + 1) - 1) * 3;
+        recordBytes = VSPLAT_RECORD_BYTES + fileShBytes;
+        size_t recordsOffset = sizeof(VsplatHeader) + (size_t)header.chunkCount * sizeof(VsplatChunk);
+        if (_file.size() < recordsOffset + (size_t)header.splatCount * recordBytes) {
+            throw std::runtime_error("Truncated VSPLAT file: " + _filepath);
+        }
+
+        chunks.resize(header.chunkCount);
+        std::memcpy(chunks.data(), _file.data() + sizeof(VsplatHeader), chunks.size() * sizeof(VsplatChunk));
+        // Chunks are decoded in parallel into their own slots: they must
+        // cover every splat exactly once (in any order)
+        std::vector<std::pair<uint32_t, uint32_t>> ranges(chunks.size());
+        for (size_t c = 0; c < chunks.size(); c++)
+            ranges[c] = std::make_pair(chunks[c].first, chunks[c].count);
+        std::sort(ranges.begin(), ranges.end());
+        size_t covered = 0;
+        for (const std::pair<uint32_t, uint32_t>& range : ranges) {
+            if (range.first != covered)
+                throw std::runtime_error("Corrupted VSPLAT chunk table: " + _filepath);
+            covered += range.second;
+        }
+        if (covered != header.splatCount)
+            throw std::runtime_error("Corrupted VSPLAT chunk table: " + _filepath);
+
+        records = reinterpret_cast<const uint8_t*>(_file.data() + recordsOffset);
+    }
+
+    // Decodes a chunk into consecutive slots of the output arrays, keeping
+    // the first _shBytes of SH (lower bands come first, so a degree cap just
+    // truncates them) and flipping into the other frame when _flip is set
+    void decodeChunk(const VsplatChunk& _chunk, size_t _shBytes, bool _flip,
+                     glm::vec3* _positions, glm::vec3* _scales, glm::quat* _rotations, glm::u8vec4* _colors, uint8_t* _sh) const {
+        static const glm::quat flipval(0.0f, 1.0f, 0.0f, 0.0f);
+
+        glm::vec3 minB(_chunk.minBounds[0], _chunk.minBounds[1], _chunk.minBounds[2]);
+        glm::vec3 maxB(_chunk.maxBounds[0], _chunk.maxBounds[1], _chunk.maxBounds[2]);
+        glm::vec3 step = glm::max(maxB - minB, glm::vec3(1e-6f)) / 65535.0f;
+        float logScaleMin = header.logScaleRange[0];
+        float logScaleStep = (header.logScaleRange[1] - header.logScaleRange[0]) / 255.0f;
+
+        const uint8_t* src = records + (size_t)_chunk.first * recordBytes;
+        for (size_t i = 0; i < _chunk.count; i++) {
+            uint16_t position[3];
+            std::memcpy(position, src, 6);
+            glm::vec3 pos = minB + glm::vec3(position[0], position[1], position[2]) * step;
+
+            uint32_t rotation;
+            std::memcpy(&rotation, src + 6, 4);
+            glm::quat rot = unpackSmallestThree(rotation);
+
+            _scales[i] = glm::exp(glm::vec3(src[10], src[11], src[12]) * logScaleStep + logScaleMin);
+            _colors[i] = glm::u8vec4(src[13], src[14], src[15], src[16]);
+
+            uint8_t* sh = _sh + i * _shBytes;
+            if (_shBytes > 0)
+                std::memcpy(sh, src + VSPLAT_RECORD_BYTES, _shBytes);
+
+            if (_flip) {
+                pos.y = -pos.y;
+                pos.z = -pos.z;
+                rot = glm::normalize(flipval * rot);
+                // The SH range is symmetric, so negating is 255 - q
+                for (size_t k = 0; k < _shBytes / 3; k++)
+                    if (SH_FLIP_SIGN[k] < 0.0f)
+                        for (int ch = 0; ch < 3; ch++)
+                            sh[k * 3 + ch] = 255 - sh[k * 3 + ch];
+            }
+
+            _positions[i] = pos;
+            _rotations[i] = rot;
+            src += recordBytes;
+        }
+    }
+};
+
+// .splat records are 32 bytes: pos(3*4) + scale(3*4) + color(4) + rot(4)
+static const size_t SPLAT_RECORD_BYTES = 32;
+
+// Decodes one .splat record (shared by the regular and progressive loaders)
+static void decodeSplatRecord(const uint8_t* _record, bool _colmap,
+                              glm::vec3& _position, glm::vec3& _scale, glm::quat& _rotation, glm::u8vec4& _color) {
+    float values[6];
+    std::memcpy(values, _record, sizeof(values));
+    const uint8_t* color = _record + 24;
+    const uint8_t* rot = _record + 28;
+
+    _position = _colmap ? glm::vec3(values[0], values[1], values[2]) : glm::vec3(values[0], -values[1], -values[2]);
+    _scale = glm::vec3(values[3], values[4], values[5]);
+    _color = glm::u8vec4(color[0], color[1], color[2], color[3]);
+
+    // Rotation (mapping uint8 0..255 to -1.0..1.0)
+    glm::quat q((rot[0] - 128) / 128.0f, (rot[1] - 128) / 128.0f, (rot[2] - 128) / 128.0f, (rot[3] - 128) / 128.0f);
+    if (_colmap) {
+        _rotation = glm::normalize(q);
+    } else {
+        // Rotate 180 degrees around X axis to match OpenGL coordinates
+        static const glm::quat flipval(0.0f, 1.0f, 0.0f, 0.0f);
+        _rotation = glm::normalize(flipval * q);
+    }
+}
+
+// Vertex records of a binary little-endian 3DGS .ply, read in place from a
+// mapping at a fixed stride, decoded like loadPLY() does. read() returns
+// false for anything else (ASCII, big endian, list properties, elements
+// before the vertices, unexpected property types), which is left to
+// tinyply's general reader.
+struct PlyVertexLayout {
+    const uint8_t*      records = nullptr;
+    size_t              stride = 0;
+    size_t              count = 0;
+    int                 position[3];
+    int                 scale[3];
+    int                 rotation[4];
+    int                 dc[3] = { -1, -1, -1 };
+    int                 rgb[3] = { -1, -1, -1 };
+    int                 opacity = -1;
+    int                 shDegree = 0;
+    std::vector<int>    rest;       // f_rest kept, channel-major like the file
+
+    bool read(const vera::MappedFile& _file, int _shMaxDegree) {
+        const char* data = _file.data();
+        const char tag[] = "end_header";
+        const char* limit = data + std::min(_file.size(), (size_t)65536);
+        const char* end = std::search(data, limit, tag, tag + sizeof(tag) - 1);
+        if (end == limit)
+            return false;
+        end = static_cast<const char*>(std::memchr(end, '\n', data + _file.size() - end));
+        if (!end)
+            return false;
+
+        std::string text(data, end + 1);
+        if (text.find("format binary_little_endian") == std::string::npos)
+            return false;
+        std::istringstream header(text);
+        tinyply::PlyFile file;
+        if (!file.parse_header(header))
+            return false;
+
+        std::vector<tinyply::PlyElement> elements = file.get_elements();
+        if (elements.empty() || elements[0].name != "vertex")
+            return false;
+
+        // Offsets of the properties by name, -1 for those of another type
+        std::map<std::string, int> offsets;
+        std::map<std::string, tinyply::Type> types;
+        for (const tinyply::PlyProperty& property : elements[0].properties) {
+            if (property.isList)
+                return false;
+            offsets[property.name] = (int)stride;
+            types[property.name] = property.propertyType;
+            stride += tinyply::PropertyTable[property.propertyType].stride;
+        }
+        auto find = [&](const std::string& _name, tinyply::Type _type) {
+            auto it = offsets.find(_name);
+            return (it != offsets.end() && types[_name] == _type) ? it->second : -1;
+        };
+        auto findAll = [&](int* _out, int _n, const std::string& _a, const std::string& _b, tinyply::Type _type) {
+            for (int k = 0; k < _n; k++) {
+                _out[k] = find(_a + std::to_string(k), _type);
+                if (_out[k] < 0)
+                    _out[k] = find(_b + std::to_string(k), _type);
+                if (_out[k] < 0)
+                    return false;
+            }
+            return true;
+        };
+
+        position[0] = find("x", tinyply::Type::FLOAT32);
+        position[1] = find("y", tinyply::Type::FLOAT32);
+        position[2] = find("z", tinyply::Type::FLOAT32);
+        if (position[0] < 0 || position[1] < 0 || position[2] < 0 ||
+            !findAll(scale, 3, "scale_", "scaling_", tinyply::Type::FLOAT32) ||
+            !findAll(rotation, 4, "rot_", "rotation_", tinyply::Type::FLOAT32))
+            return false;
+
+        // Colors as loadPLY() looks for them. Present under another type:
+        // not this reader's.
+        bool hasSH = offsets.count("f_dc_0") > 0;
+        if (hasSH && !findAll(dc, 3, "f_dc_", "f_dc_", tinyply::Type::FLOAT32))
+            return false;
+        if (!hasSH && offsets.count("red") > 0) {
+            rgb[0] = find("red", tinyply::Type::UINT8);
+            rgb[1] = find("green", tinyply::Type::UINT8);
+            rgb[2] = find("blue", tinyply::Type::UINT8);
+            if (rgb[0] < 0 || rgb[1] < 0 || rgb[2] < 0)
+                return false;
+        }
+        if (offsets.count("opacity") > 0 && (opacity = find("opacity", tinyply::Type::FLOAT32)) < 0)
+            return false;
+
+        int fileCoeffs = 0;
+        if (hasSH) {
+            for (const tinyply::PlyProperty& property : elements[0].properties)
+                if (property.name.compare(0, 7, "f_rest_") == 0)
+                    fileCoeffs++;
+            fileCoeffs /= 3;
+        }
+        if (fileCoeffs >= 15)       shDegree = 3;
+        else if (fileCoeffs >= 8)   shDegree = 2;
+        else if (fileCoeffs >= 3)   shDegree = 1;
+        shDegree = std::min(shDegree, _shMaxDegree);
+
+        int shCoeffs = (shDegree + 1) * (shDegree + 1) - 1;
+        for (int c = 0; c < 3 && shDegree > 0; c++) {
+            for (int k = 0; k < shCoeffs; k++) {
+                std::string name = "f_rest_" + std::to_string(c * fileCoeffs + k);
+                if (offsets.count(name) == 0) {
+                    // Non-standard naming, fall back to the view-independent color
+                    rest.clear();
+                    shDegree = 0;
+                    break;
+                }
+                if (types[name] != tinyply::Type::FLOAT32)
+                    return false;
+                rest.push_back(offsets[name]);
+            }
+        }
+
+        size_t dataOffset = end + 1 - data;
+        count = elements[0].size;
+        if (_file.size() < dataOffset + count * stride)
+            return false;
+        records = reinterpret_cast<const uint8_t*>(data + dataOffset);
+        return true;
+    }
+
+    float value(size_t _index, int _offset) const {
+        float v;
+        std::memcpy(&v, records + _index * stride + _offset, sizeof(float));
+        return v;
+    }
+
+    // Largest |f_rest| kept, for a symmetric SH range like loadPLY()'s
+    float shExtent() const {
+        if (rest.empty() || count == 0)
+            return 0.0f;
+        size_t nThreads = vera::parallelThreads(count, 65536);
+        std::vector<float> extents(nThreads, 0.0f);
+        vera::parallelFor(nThreads, count, [&](size_t _t, size_t _start, size_t _end) {
+            for (size_t i = _start; i < _end; i++)
+                for (int offset : rest)
+                    extents[_t] = std::max(extents[_t], std::abs(value(i, offset)));
+        });
+        return *std::max_element(extents.begin(), extents.end());
+    }
+
+    void decode(size_t _index, bool _colmap, float _shExtent,
+                glm::vec3& _position, glm::vec3& _scale, glm::quat& _rotation, glm::u8vec4& _color, uint8_t* _sh) const {
+        glm::vec3 p(value(_index, position[0]), value(_index, position[1]), value(_index, position[2]));
+        _position = _colmap ? p : glm::vec3(p.x, -p.y, -p.z);
+        _scale = glm::exp(glm::vec3(value(_index, scale[0]), value(_index, scale[1]), value(_index, scale[2])));
+
+        glm::quat q(value(_index, rotation[0]), value(_index, rotation[1]), value(_index, rotation[2]), value(_index, rotation[3]));
+        if (_colmap) {
+            _rotation = glm::normalize(q);
+        } else {
+            static const glm::quat flipval(0.0f, 1.0f, 0.0f, 0.0f);
+            _rotation = glm::normalize(flipval * q);
+        }
+
+        const uint8_t* record = records + _index * stride;
+        if (dc[0] >= 0) {
+            for (int c = 0; c < 3; c++)
+                _color[c] = static_cast<uint8_t>(glm::clamp((0.5f + SH_C0 * value(_index, dc[c])) * 255.0f, 0.0f, 255.0f));
+        } else if (rgb[0] >= 0) {
+            _color = glm::u8vec4(record[rgb[0]], record[rgb[1]], record[rgb[2]], 0);
+        } else {
+            _color = glm::u8vec4(255);
+        }
+
+        if (opacity >= 0) {
+            float op = 1.0f / (1.0f + std::exp(-value(_index, opacity)));
+            _color.a = static_cast<uint8_t>(glm::clamp(op * 255.0f, 0.0f, 255.0f));
+        } else {
+            _color.a = 255;
+        }
+
+        int shCoeffs = (int)rest.size() / 3;
+        float scaleSH = (_shExtent > 0.0f) ? 255.0f / (2.0f * _shExtent) : 0.0f;
+        for (int c = 0; c < 3; c++) {
+            for (int k = 0; k < shCoeffs; k++) {
+                float sign = _colmap ? 1.0f : SH_FLIP_SIGN[k];
+                float v = sign * value(_index, rest[c * shCoeffs + k]);
+                _sh[k * 3 + c] = static_cast<uint8_t>(glm::clamp((v + _shExtent) * scaleSH + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    }
+};
+
 
 namespace vera {
 
 bool Gsplat::s_useColmapFrame = false;
+size_t Gsplat::s_multiViewFrame = 0;
+size_t Gsplat::s_multiViewFrameCount = 0;
+glm::mat4 Gsplat::s_multiViewViewProj = glm::mat4(1.0f);
+float Gsplat::s_multiViewGuard = 1.0f;
+
+void Gsplat::beginMultiView(const glm::mat4& _view, const glm::mat4& _projection, float _guard) {
+    s_multiViewFrame = ++s_multiViewFrameCount;
+    s_multiViewViewProj = _projection * _view;
+    s_multiViewGuard = std::max(_guard, 1.0f);
+}
 
 Gsplat::Gsplat() {
 }
 
 Gsplat::~Gsplat() {
+    stopSortThread();
     clear();
 }
 
-void Gsplat::clear() {
+void Gsplat::clearSplats() {
+    cancelLoad();
+    finishSort();
+    m_dirtyBegin = m_dirtyEnd = 0;
+
     m_positions.clear();
     m_scales.clear();
     m_rotations.clear();
     m_colors.clear();
-    
-    m_worldPositions.clear();
-
-    m_sorter.clear();
+    m_shCoeffs.clear();
+    m_shDegree = 0;
+
+    m_lodNodes.clear();
+    m_lodChildren.clear();
+    m_lodProxyStart = 0;
+
+    m_sortX.clear();
+    m_sortY.clear();
+    m_sortZ.clear();
+    m_sortPositionsDirty = true;
+
+    m_sortDepths.clear();
+    m_sortDepthsTmp.clear();
+    m_sortKeys.clear();
+    m_sortValues.clear();
+    m_sortKeysTmp.clear();
+    m_sortValuesTmp.clear();
+    m_sortPrevious.clear();
+    m_sortSlot.clear();
+    m_sortPreviousValid = false;
+    clearBlocks();
     m_depthFloatIndex.clear();
     m_depthUintIndex.clear();
+    m_sortOrder.clear();
     m_hasSorted = false;
+    m_indexDirty = true;
 
-    if (m_texture) {
-        m_texture->clear();
-        delete m_texture;
-        m_texture = nullptr;
-    }
+    resetTextures();
+}
+
+void Gsplat::clear() {
+    clearSplats();
 
     if (m_shader && !m_borrowedShader) {
         delete m_shader;
@@ -181,18 +1005,6 @@ void Gsplat::clear() {
         m_depthVao = 0;
     }
 
-    if (m_occlusionFbo != 0) {
-        glDeleteFramebuffers(1, &m_occlusionFbo);
-        m_occlusionFbo = 0;
-    }
-
-    if (m_occlusionDepthTex != 0) {
-        glDeleteTextures(1, &m_occlusionDepthTex);
-        m_occlusionDepthTex = 0;
-    }
-    m_occlusionFboWidth = 0;
-    m_occlusionFboHeight = 0;
-
     if (m_positionVBO != 0) {
         glDeleteBuffers(1, &m_positionVBO);
         m_positionVBO = 0;
@@ -212,46 +1024,187 @@ void Gsplat::clear() {
 }
 
 void Gsplat::setGridDim(int _dim) {
+    // Only sizes the octree leaves now (see buildSpatialIndex())
+    _dim = std::max(_dim, 1);
     if (m_gridDim != _dim) {
         m_gridDim = _dim;
-        buildSpatialIndex();
+        // A streaming load indexes once it's complete
+        if (!isLoading())
+            buildSpatialIndex();
+    }
+}
+
+void Gsplat::setBlockSize(size_t _splats) {
+    if (m_blockSize != _splats) {
+        m_blockSize = _splats;
+        if (!isLoading() && !m_positions.empty())
+            buildSpatialIndex();
     }
 }
 
+// The sort settings below are read by the sort worker: each setter waits
+// for it to be idle before changing one (which also asks for a new sort)
+
 void Gsplat::setOcclusionThreshold(int _threshold) {
+    if (m_occlusionThreshold == _threshold)
+        return;
+    finishSort();
     m_occlusionThreshold = _threshold;
 }
 
 void Gsplat::setOcclusionScale(float _scale) {
+    if (m_occlusionScale == _scale)
+        return;
+    finishSort();
     m_occlusionScale = _scale;
 }
 
+void Gsplat::setSortKey(SplatSortKey _key) {
+    if (m_sortKey == _key)
+        return;
+    finishSort();
+    m_sortKey = _key;
+}
+
+void Gsplat::setIncrementalSort(bool _incremental) {
+    if (m_incrementalSort == _incremental)
+        return;
+    finishSort();
+    m_incrementalSort = _incremental;
+}
+
+void Gsplat::setIncrementalSortThreshold(float _threshold) {
+    if (m_incrementalSortThreshold == _threshold)
+        return;
+    finishSort();
+    m_incrementalSortThreshold = _threshold;
+}
+
+void Gsplat::setLodBudget(size_t _splats) {
+    if (m_lodBudget == _splats)
+        return;
+    finishSort();
+    m_lodBudget = _splats;
+}
+
+void Gsplat::setLodErrorThreshold(float _pixels) {
+    if (m_lodErrorThreshold == _pixels)
+        return;
+    finishSort();
+    m_lodErrorThreshold = _pixels;
+}
+
+void Gsplat::setAsyncSort(bool _async) {
+    if (m_asyncSort == _async)
+        return;
+
+    if (!_async)
+        stopSortThread();
+
+    m_asyncSort = _async;
+}
+
+void Gsplat::setLodEnabled(bool _enabled) {
+    if (m_lodEnabled == _enabled)
+        return;
+
+    m_lodEnabled = _enabled;
+
+    // Otherwise built along with the spatial index on load
+    if (m_blocks.empty())
+        return;
+
+    if (_enabled)
+        buildLOD();
+    else
+        dropLOD();
+}
+
+void Gsplat::updateSplats(size_t _first, size_t _count, const glm::vec3* _positions, const glm::vec3* _scales, const glm::quat* _rotations, const glm::u8vec4* _colors) {
+    size_t n = count();
+    if (_first >= n || _count == 0 || isLoading())
+        return;
+    _count = std::min(_count, n - _first);
+    size_t end = _first + _count;
+
+    finishSort();
+
+    if (_positions)
+        std::copy(_positions, _positions + _count, m_positions.begin() + _first);
+    if (_scales)
+        std::copy(_scales, _scales + _count, m_scales.begin() + _first);
+    if (_rotations)
+        std::copy(_rotations, _rotations + _count, m_rotations.begin() + _first);
+    if (_colors)
+        std::copy(_colors, _colors + _count, m_colors.begin() + _first);
+
+    splatsChanged(_first, end, _positions != nullptr);
+}
+
+void Gsplat::splatsChanged(size_t _begin, size_t _end, bool _moved) {
+    m_generation++;
+
+    // Merged with what's still pending, uploaded by the next render
+    if (m_dirtyEnd > m_dirtyBegin) {
+        m_dirtyBegin = std::min(m_dirtyBegin, _begin);
+        m_dirtyEnd = std::max(m_dirtyEnd, _end);
+    }
+    else {
+        m_dirtyBegin = _begin;
+        m_dirtyEnd = _end;
+    }
+
+    if (_moved) {
+        m_sortPositionsDirty = true;
+        m_hasSorted = false;
+        refitBlocks(_begin, _end);
+    }
+
+    // Proxies depend on everything below them
+    updateLOD(_begin, _end);
+}
+
 bool Gsplat::load(const std::string& _filepath) {
     std::string ext = _filepath.substr(_filepath.find_last_of(".") + 1);
+
+    if (m_progressiveLoad) {
+        clear();
+        m_loadDone = false;
+        m_loadCancel = false;
+        m_loadError.clear();
+        m_loadFileTotal = 0;
+        m_loadThread = std::thread(&Gsplat::loadThreadLoop, this, _filepath, m_shMaxDegree, m_loadBatchSize);
+        return true;
+    }
+
+    bool loaded = false;
     if (ext == "ply") {
-        return loadPLY(_filepath);
+        loaded = loadPLY(_filepath);
     } else if (ext == "splat") {
-        return loadSPLAT(_filepath);
+        loaded = loadSPLAT(_filepath);
+    } else if (ext == "vsplat") {
+        loaded = loadVSPLAT(_filepath);
     } else {
         // Fallback or error
         // Try PLY as default
-        return loadPLY(_filepath);
+        loaded = loadPLY(_filepath);
     }
+
+    // .vsplat chunks were written block after block out of Morton-ordered
+    // data, so that layout is already spatially coherent
+    if (loaded)
+        finishLoad(ext != "vsplat");
+
+    return loaded;
 }
 
 bool Gsplat::loadSPLAT(const std::string& _filepath) {
-    std::ifstream file(_filepath, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
+    MappedFile file(_filepath);
+    if (!file.isOpen()) {
         throw std::runtime_error("Failed to open SPLAT file: " + _filepath);
     }
 
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    // .splat format: 32 bytes per splat
-    // pos(3*4) + scale(3*4) + color(4) + rot(4)
-    size_t splatSize = 32;
-    size_t splatCount = size / splatSize;
+    size_t splatCount = file.size() / SPLAT_RECORD_BYTES;
     
     clear();
     m_positions.resize(splatCount);
@@ -259,68 +1212,10 @@ bool Gsplat::loadSPLAT(const std::string& _filepath) {
     m_rotations.resize(splatCount);
     m_colors.resize(splatCount);
 
-    struct SplatData {
-        float x, y, z;
-        float sx, sy, sz;
-        uint8_t r, g, b, a;
-        uint8_t rot_0, rot_1, rot_2, rot_3;
-    };
-
-    std::vector<char> buffer(size);
-    if (!file.read(buffer.data(), size)) {
-         return false;
-    }
-
-    for (size_t i = 0; i < splatCount; i++) {
-        float x, y, z;
-        float sx, sy, sz;
-        uint8_t r, g, b, a;
-        uint8_t rot_0, rot_1, rot_2, rot_3;
-        float nx = 0.0f, ny = 0.0f, nz = 0.0f;
-
-        const SplatData& s = reinterpret_cast<SplatData*>(buffer.data())[i];
-        x = s.x; y = s.y; z = s.z;
-        sx = s.sx; sy = s.sy; sz = s.sz;
-        r = s.r; g = s.g; b = s.b; a = s.a;
-        rot_0 = s.rot_0; rot_1 = s.rot_1; rot_2 = s.rot_2; rot_3 = s.rot_3;
-        
-        m_positions[i] = s_useColmapFrame ? glm::vec3(x, y, z) : glm::vec3(x, -y, -z);
-        m_scales[i] = glm::vec3(sx, sy, sz);
-
-        // Color
-        m_colors[i] = glm::u8vec4(r, g, b, a);
-
-        // Rotation (mapping uint8 0..255 to -1.0..1.0)
-        // (val - 128) / 128.0
-        float r0 = (rot_0 - 128) / 128.0f;
-        float r1 = (rot_1 - 128) / 128.0f;
-        float r2 = (rot_2 - 128) / 128.0f;
-        float r3 = (rot_3 - 128) / 128.0f;
-
-        // Common packing: rot_0, rot_1, rot_2, rot_3 -> x, y, z, w ?
-        glm::quat q(r0, r1, r2, r3); // x, y, z, w
-
-        if (s_useColmapFrame) {
-            m_rotations[i] = glm::normalize(q);
-        } else {
-            // Rotate 180 degrees around X axis to match OpenGL coordinates
-            static const glm::quat flipval(0.0f, 1.0f, 0.0f, 0.0f);
-            m_rotations[i] = glm::normalize(flipval * q);
-        }
-    }
-
-    optimizeDataLayout();
-
-    size_t n = m_positions.size();
-    m_worldPositions.resize(n * 3);
-    for (size_t i = 0; i < n; i++) {
-        const glm::vec3& pos = m_positions[i];
-        m_worldPositions[i * 3 + 0] = pos.x;
-        m_worldPositions[i * 3 + 1] = pos.y;
-        m_worldPositions[i * 3 + 2] = pos.z;
-    }
-
-    buildSpatialIndex();
+    const uint8_t* records = reinterpret_cast<const uint8_t*>(file.data());
+    for (size_t i = 0; i < splatCount; i++)
+        decodeSplatRecord(records + i * SPLAT_RECORD_BYTES, s_useColmapFrame,
+                          m_positions[i], m_scales[i], m_rotations[i], m_colors[i]);
 
     return true;
 }
@@ -407,6 +1302,40 @@ bool Gsplat::loadPLY(const std::string& _filepath) {
     } catch (const std::exception&) {
         // Default full opacity
     }
+
+    // Higher-order SH bands (f_rest_*). 3DGS stores them channel-major: all
+    // of red's coefficients, then green's, then blue's. Only request the ones
+    // under the degree cap so the rest are never decoded.
+    int fileCoeffs = 0;
+    if (hasSH) {
+        for (const tinyply::PlyElement& element : file.get_elements()) {
+            if (element.name != "vertex")
+                continue;
+            for (const tinyply::PlyProperty& property : element.properties)
+                if (property.name.compare(0, 7, "f_rest_") == 0)
+                    fileCoeffs++;
+        }
+        fileCoeffs /= 3;
+    }
+
+    int shDegree = 0;
+    if (fileCoeffs >= 15)       shDegree = 3;
+    else if (fileCoeffs >= 8)   shDegree = 2;
+    else if (fileCoeffs >= 3)   shDegree = 1;
+    shDegree = std::min(shDegree, m_shMaxDegree);
+
+    int shCoeffs = (shDegree + 1) * (shDegree + 1) - 1;
+    std::vector<std::shared_ptr<tinyply::PlyData>> f_rest;
+    try {
+        for (int c = 0; c < 3; c++)
+            for (int k = 0; k < shCoeffs; k++)
+                f_rest.push_back( file.request_properties_from_element("vertex", {"f_rest_" + std::to_string(c * fileCoeffs + k)}) );
+    } catch (const std::exception&) {
+        // Non-standard naming, fall back to the view-independent color
+        f_rest.clear();
+        shDegree = 0;
+        shCoeffs = 0;
+    }
     
     file.read(ss);
     
@@ -491,35 +1420,623 @@ bool Gsplat::loadPLY(const std::string& _filepath) {
         
         m_colors[i] = glm::u8vec4(r, g, b, a);
     }
-    
-    optimizeDataLayout();
 
-    size_t n = m_positions.size();
-    m_worldPositions.resize(n * 3);
-    for (size_t i = 0; i < n; i++) {
-        const glm::vec3& pos = m_positions[i];
-        m_worldPositions[i * 3 + 0] = pos.x;
-        m_worldPositions[i * 3 + 1] = pos.y;
-        m_worldPositions[i * 3 + 2] = pos.z;
+    if (shDegree > 0) {
+        float shMin = std::numeric_limits<float>::max();
+        float shMax = std::numeric_limits<float>::lowest();
+        for (const std::shared_ptr<tinyply::PlyData>& data : f_rest) {
+            const float* values = reinterpret_cast<const float*>(data->buffer.get());
+            for (size_t i = 0; i < vertexCount; i++) {
+                shMin = std::min(shMin, values[i]);
+                shMax = std::max(shMax, values[i]);
+            }
+        }
+        // Keep the range symmetric so a frame flip (negating a quantized
+        // coefficient) is just 255 - q, here and when loading a .vsplat
+        float extent = std::max(std::abs(shMin), std::abs(shMax));
+        shMin = -extent;
+        shMax = extent;
+        float scale = (shMax > shMin) ? 255.0f / (shMax - shMin) : 0.0f;
+
+        m_shDegree = shDegree;
+        m_shRange = glm::vec2(shMin, shMax);
+        m_shCoeffs.resize(vertexCount * shCoeffs * 3);
+        for (int c = 0; c < 3; c++) {
+            for (int k = 0; k < shCoeffs; k++) {
+                const float* values = reinterpret_cast<const float*>(f_rest[c * shCoeffs + k]->buffer.get());
+                float sign = s_useColmapFrame ? 1.0f : SH_FLIP_SIGN[k];
+                uint8_t* dst = m_shCoeffs.data() + k * 3 + c;
+                for (size_t i = 0; i < vertexCount; i++)
+                    dst[i * shCoeffs * 3] = static_cast<uint8_t>(glm::clamp((sign * values[i] - shMin) * scale + 0.5f, 0.0f, 255.0f));
+            }
+        }
     }
 
-    buildSpatialIndex();
-
     return true;
 }
 
-void Gsplat::ensureSharedBuffers() {
-    // Quad corners (point-sprite geometry) and the depth-sorted instance
-    // index buffer are shader-agnostic and shared between the color VAO
-    // (m_vao) and the normal-buffer VAO (m_normalVao).
-    if (m_positionVBO == 0) {
-        float quadVertices[] = {
-            -2.0f, -2.0f,
-             2.0f, -2.0f,
-             2.0f,  2.0f,
-            -2.0f,  2.0f
-        };
-
+bool Gsplat::save(const std::string& _filepath) {
+    size_t splatCount = count();
+    if (m_blocks.empty() && splatCount > 0)
+        buildSpatialIndex();
+
+    size_t shBytes = shCoeffCount() * 3;
+    size_t recordBytes = VSPLAT_RECORD_BYTES + shBytes;
+
+    // Log-scales are quantized over the scene's range
+    glm::vec2 logScaleRange(0.0f);
+    if (splatCount > 0) {
+        logScaleRange = glm::vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < splatCount; i++) {
+            glm::vec3 logScale = glm::log(glm::max(m_scales[i], glm::vec3(1e-8f)));
+            logScaleRange.x = std::min(logScaleRange.x, std::min(logScale.x, std::min(logScale.y, logScale.z)));
+            logScaleRange.y = std::max(logScaleRange.y, std::max(logScale.x, std::max(logScale.y, logScale.z)));
+        }
+    }
+    float logScaleStep = 255.0f / std::max(logScaleRange.y - logScaleRange.x, 1e-6f);
+
+    // One chunk per spatial block, its splats stored contiguously
+    std::vector<VsplatChunk> chunks(m_blocks.size());
+    uint32_t first = 0;
+    for (size_t c = 0; c < m_blocks.size(); c++) {
+        const SplatBlock& block = m_blocks[c];
+        VsplatChunk& chunk = chunks[c];
+        std::memset(&chunk, 0, sizeof(VsplatChunk));
+        for (int k = 0; k < 3; k++) {
+            chunk.minBounds[k] = block.min_bounds[k];
+            chunk.maxBounds[k] = block.max_bounds[k];
+        }
+        chunk.first = first;
+        chunk.count = (uint32_t)block.indices.size();
+        first += chunk.count;
+    }
+
+    std::vector<uint8_t> records(splatCount * recordBytes);
+    parallelFor(parallelThreads(chunks.size(), 16), chunks.size(), [&](size_t, size_t _start, size_t _end) {
+        for (size_t c = _start; c < _end; c++) {
+            const SplatBlock& block = m_blocks[c];
+            VsplatChunk& chunk = chunks[c];
+            glm::vec3 extent = glm::max(block.max_bounds - block.min_bounds, glm::vec3(1e-6f));
+
+            float importance = 0.0f;
+            uint8_t* dst = records.data() + (size_t)chunk.first * recordBytes;
+            for (uint32_t i : block.indices) {
+                glm::vec3 p = glm::clamp((m_positions[i] - block.min_bounds) / extent, 0.0f, 1.0f) * 65535.0f + 0.5f;
+                uint16_t position[3] = { (uint16_t)p.x, (uint16_t)p.y, (uint16_t)p.z };
+                std::memcpy(dst, position, 6);
+
+                uint32_t rotation = packSmallestThree(m_rotations[i]);
+                std::memcpy(dst + 6, &rotation, 4);
+
+                const glm::vec3& scale = m_scales[i];
+                for (int k = 0; k < 3; k++) {
+                    float logScale = std::log(std::max(scale[k], 1e-8f));
+                    dst[10 + k] = (uint8_t)glm::clamp((logScale - logScaleRange.x) * logScaleStep + 0.5f, 0.0f, 255.0f);
+                }
+
+                const glm::u8vec4& color = m_colors[i];
+                dst[13] = color.r;
+                dst[14] = color.g;
+                dst[15] = color.b;
+                dst[16] = color.a;
+
+                if (shBytes > 0)
+                    std::memcpy(dst + VSPLAT_RECORD_BYTES, m_shCoeffs.data() + (size_t)i * shBytes, shBytes);
+
+                float maxScale = std::max(scale.x, std::max(scale.y, scale.z));
+                importance += (color.a / 255.0f) * maxScale * maxScale;
+                dst += recordBytes;
+            }
+            chunk.importance = importance;
+        }
+    });
+
+    VsplatHeader header;
+    std::memset(&header, 0, sizeof(VsplatHeader));
+    std::memcpy(header.magic, VSPLAT_MAGIC, 4);
+    header.version = VSPLAT_VERSION;
+    header.splatCount = (uint32_t)splatCount;
+    header.chunkCount = (uint32_t)chunks.size();
+    header.shDegree = (uint32_t)m_shDegree;
+    header.flags = s_useColmapFrame ? VSPLAT_FLAG_COLMAP_FRAME : 0;
+    header.shRange[0] = m_shRange.x;
+    header.shRange[1] = m_shRange.y;
+    header.logScaleRange[0] = logScaleRange.x;
+    header.logScaleRange[1] = logScaleRange.y;
+
+    // Written aside and renamed over, so an interrupted save never leaves
+    // a truncated file behind
+    std::string tmpPath = _filepath + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open()) {
+            std::cout << "ERROR: Gsplat: could not open " << tmpPath << " for writing" << std::endl;
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(VsplatHeader));
+        file.write(reinterpret_cast<const char*>(chunks.data()), chunks.size() * sizeof(VsplatChunk));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size());
+        if (!file.good()) {
+            file.close();
+            std::remove(tmpPath.c_str());
+            std::cout << "ERROR: Gsplat: could not write " << _filepath << std::endl;
+            return false;
+        }
+    }
+
+    // rename() does not replace an existing file on Windows
+#if defined(_WIN32)
+    std::remove(_filepath.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), _filepath.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        std::cout << "ERROR: Gsplat: could not write " << _filepath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Gsplat::loadVSPLAT(const std::string& _filepath) {
+    MappedFile file(_filepath);
+    if (!file.isOpen()) {
+        throw std::runtime_error("Failed to open VSPLAT file: " + _filepath);
+    }
+
+    VsplatLayout layout;
+    layout.read(file, _filepath);
+
+    clear();
+
+    size_t splatCount = layout.header.splatCount;
+    m_positions.resize(splatCount);
+    m_scales.resize(splatCount);
+    m_rotations.resize(splatCount);
+    m_colors.resize(splatCount);
+
+    m_shDegree = std::min((int)layout.header.shDegree, m_shMaxDegree);
+    m_shRange = glm::vec2(layout.header.shRange[0], layout.header.shRange[1]);
+    size_t shBytes = shCoeffCount() * 3;
+    m_shCoeffs.resize(splatCount * shBytes);
+
+    // Files keep the frame they were written in
+    bool flip = ((layout.header.flags & VSPLAT_FLAG_COLMAP_FRAME) != 0) != s_useColmapFrame;
+
+    parallelFor(parallelThreads(layout.chunks.size(), 16), layout.chunks.size(), [&](size_t, size_t _start, size_t _end) {
+        for (size_t c = _start; c < _end; c++) {
+            const VsplatChunk& chunk = layout.chunks[c];
+            layout.decodeChunk(chunk, shBytes, flip,
+                               &m_positions[chunk.first], &m_scales[chunk.first], &m_rotations[chunk.first],
+                               &m_colors[chunk.first], m_shCoeffs.data() + (size_t)chunk.first * shBytes);
+        }
+    });
+
+    return true;
+}
+
+void Gsplat::finishLoad(bool _optimizeLayout) {
+    m_generation++;
+    pruneSplats();
+
+    if (_optimizeLayout)
+        optimizeDataLayout();
+
+    buildSpatialIndex();
+}
+
+void Gsplat::pruneSplats() {
+    size_t n = m_positions.size();
+    m_pruneStats = SplatPruneStats();
+    m_pruneStats.loaded = n;
+
+    bool capped = m_pruneMaxCount > 0 && n > m_pruneMaxCount;
+    if (m_pruneMinOpacity <= 0.0f && m_pruneMinExtent <= 0.0f && !capped)
+        return;
+
+    std::vector<uint8_t> keep(n);
+    parallelFor(parallelThreads(n, 65536), n, [&](size_t, size_t _start, size_t _end) {
+        for (size_t i = _start; i < _end; i++) {
+            const glm::vec3& s = m_scales[i];
+            float extent = std::max(s.x, std::max(s.y, s.z));
+            keep[i] = m_colors[i].a >= m_pruneMinOpacity * 255.0f && extent >= m_pruneMinExtent;
+        }
+    });
+
+    // Over the cap: keep the largest survivors (opacity x volume)
+    size_t survivors = std::count(keep.begin(), keep.end(), (uint8_t)1);
+    if (m_pruneMaxCount > 0 && survivors > m_pruneMaxCount) {
+        std::vector<std::pair<float, uint32_t>> ranked;
+        ranked.reserve(survivors);
+        for (size_t i = 0; i < n; i++) {
+            if (keep[i]) {
+                const glm::vec3& s = m_scales[i];
+                ranked.push_back(std::make_pair(m_colors[i].a * s.x * s.y * s.z, (uint32_t)i));
+            }
+        }
+        std::nth_element(ranked.begin(), ranked.begin() + m_pruneMaxCount, ranked.end(),
+                         std::greater<std::pair<float, uint32_t>>());
+        for (size_t k = m_pruneMaxCount; k < ranked.size(); k++)
+            keep[ranked[k].second] = 0;
+        survivors = m_pruneMaxCount;
+    }
+
+    if (survivors == n)
+        return;
+
+    // Splats are about to move: no sort may be reading them
+    finishSort();
+
+    // Compact in place, keeping the file order
+    size_t stride = shCoeffCount() * 3;
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!keep[i])
+            continue;
+        if (count != i) {
+            m_positions[count] = m_positions[i];
+            m_scales[count] = m_scales[i];
+            m_rotations[count] = m_rotations[i];
+            m_colors[count] = m_colors[i];
+            if (stride > 0)
+                std::memcpy(m_shCoeffs.data() + count * stride, m_shCoeffs.data() + i * stride, stride);
+        }
+        count++;
+    }
+
+    // Release the memory for real, not just the size
+    m_positions.resize(count);
+    m_scales.resize(count);
+    m_rotations.resize(count);
+    m_colors.resize(count);
+    m_shCoeffs.resize(count * stride);
+    m_positions.shrink_to_fit();
+    m_scales.shrink_to_fit();
+    m_rotations.shrink_to_fit();
+    m_colors.shrink_to_fit();
+    m_shCoeffs.shrink_to_fit();
+
+    m_generation++;
+
+    // The published order indexes splats that moved or are gone
+    m_sortPreviousValid = false;
+    m_sortPositionsDirty = true;
+    m_hasSorted = false;
+
+    // 4 texels of 16 bytes per splat in the float and uint layouts alike,
+    // plus the SH texels
+    size_t dropped = n - count;
+    m_pruneStats.dropped = dropped;
+    m_pruneStats.cpuBytes = dropped * (sizeof(glm::vec3) * 2 + sizeof(glm::quat) + sizeof(glm::u8vec4) + stride);
+    m_pruneStats.gpuBytes = dropped * (4 + (stride + 15) / 16) * 16;
+}
+
+float Gsplat::getLoadProgress() const {
+    if (!m_loadThread.joinable())
+        return m_positions.empty() ? 0.0f : 1.0f;
+    if (m_loadTotal == 0)
+        return 0.0f;
+    return std::min(1.0f, m_positions.size() / (float)m_loadTotal);
+}
+
+void Gsplat::cancelLoad() {
+    if (!m_loadThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_loadCancel = true;
+    }
+    m_loadCondition.notify_all();
+    m_loadThread.join();
+
+    m_loadQueue.clear();
+    m_loadTotal = 0;
+}
+
+// Loader thread: never touches the live splat arrays or GL, only hands
+// decoded batches over through m_loadQueue (see updateProgressiveLoad()).
+void Gsplat::loadThreadLoop(std::string _filepath, int _shMaxDegree, size_t _batchSize) {
+    try {
+        std::string ext = _filepath.substr(_filepath.find_last_of(".") + 1);
+
+        if (ext == "vsplat") {
+            // Chunks are decoded most important first, straight from the
+            // mapping: the first batch only waits for its own chunks
+            MappedFile file(_filepath);
+            if (!file.isOpen()) {
+                throw std::runtime_error("Failed to open VSPLAT file: " + _filepath);
+            }
+
+            VsplatLayout layout;
+            layout.read(file, _filepath);
+
+            int shDegree = std::min((int)layout.header.shDegree, _shMaxDegree);
+            size_t shBytes = ((shDegree + 1) * (shDegree + 1) - 1) * 3;
+            bool flip = ((layout.header.flags & VSPLAT_FLAG_COLMAP_FRAME) != 0) != s_useColmapFrame;
+            {
+                std::lock_guard<std::mutex> lock(m_loadMutex);
+                m_loadFileTotal = layout.header.splatCount;
+                m_loadSHDegree = shDegree;
+                m_loadSHRange = glm::vec2(layout.header.shRange[0], layout.header.shRange[1]);
+            }
+
+            std::vector<uint32_t> order(layout.chunks.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return layout.chunks[a].importance > layout.chunks[b].importance;
+            });
+
+            size_t c = 0;
+            std::vector<size_t> offsets;
+            while (c < order.size()) {
+                // Whole chunks, at least _batchSize splats
+                size_t end = c;
+                size_t count = 0;
+                offsets.clear();
+                while (end < order.size() && (count < _batchSize || end == c)) {
+                    offsets.push_back(count);
+                    count += layout.chunks[order[end]].count;
+                    end++;
+                }
+
+                SplatBatch batch;
+                batch.positions.resize(count);
+                batch.scales.resize(count);
+                batch.rotations.resize(count);
+                batch.colors.resize(count);
+                batch.sh.resize(count * shBytes);
+                parallelFor(parallelThreads(end - c, 4), end - c, [&](size_t, size_t _start, size_t _end) {
+                    for (size_t k = _start; k < _end; k++) {
+                        size_t o = offsets[k];
+                        layout.decodeChunk(layout.chunks[order[c + k]], shBytes, flip,
+                                           &batch.positions[o], &batch.scales[o], &batch.rotations[o],
+                                           &batch.colors[o], batch.sh.data() + o * shBytes);
+                    }
+                });
+
+                if (!pushLoadBatch(batch))
+                    return;
+                c = end;
+            }
+        }
+        else {
+            MappedFile file(_filepath);
+            if (!file.isOpen()) {
+                throw std::runtime_error("Failed to open splat file: " + _filepath);
+            }
+
+            // .splat and binary little-endian .ply have fixed-size records:
+            // decoded straight from the mapping, a batch at a time
+            PlyVertexLayout ply;
+            if (ext == "splat") {
+                size_t n = file.size() / SPLAT_RECORD_BYTES;
+                {
+                    std::lock_guard<std::mutex> lock(m_loadMutex);
+                    m_loadFileTotal = n;
+                    m_loadSHDegree = 0;
+                    m_loadSHRange = glm::vec2(0.0f);
+                }
+
+                const uint8_t* records = reinterpret_cast<const uint8_t*>(file.data());
+                bool colmap = s_useColmapFrame;
+                streamLoadRecords(n, _batchSize, 0, [&](size_t _record, SplatBatch& _batch, size_t _slot) {
+                    decodeSplatRecord(records + _record * SPLAT_RECORD_BYTES, colmap,
+                                      _batch.positions[_slot], _batch.scales[_slot], _batch.rotations[_slot], _batch.colors[_slot]);
+                });
+            }
+            else if (ply.read(file, _shMaxDegree)) {
+                // The SH range has to be known before the first batch is
+                // quantized: one pass over just the f_rest values
+                float extent = ply.shExtent();
+                size_t shBytes = ply.rest.size();
+                {
+                    std::lock_guard<std::mutex> lock(m_loadMutex);
+                    m_loadFileTotal = ply.count;
+                    m_loadSHDegree = ply.shDegree;
+                    m_loadSHRange = glm::vec2(-extent, extent);
+                }
+
+                bool colmap = s_useColmapFrame;
+                streamLoadRecords(ply.count, _batchSize, shBytes, [&](size_t _record, SplatBatch& _batch, size_t _slot) {
+                    ply.decode(_record, colmap, extent, _batch.positions[_slot], _batch.scales[_slot], _batch.rotations[_slot],
+                               _batch.colors[_slot], _batch.sh.data() + _slot * shBytes);
+                });
+            }
+            else {
+                loadStagedBatches(_filepath, _shMaxDegree, _batchSize);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_loadError = e.what();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_loadDone = true;
+    }
+}
+
+// Record order for fixed-size records: every stride-th record first, a
+// coarse pass over the whole file in about one batch, then the rest in
+// file order. Only the batches in flight are ever held.
+bool Gsplat::streamLoadRecords(size_t _count, size_t _batchSize, size_t _shBytes,
+                               const std::function<void(size_t, SplatBatch&, size_t)>& _decode) {
+    size_t stride = std::max(_count / std::max(_batchSize, (size_t)1), (size_t)1);
+    std::vector<size_t> records;
+    records.reserve(_batchSize);
+
+    auto flush = [&]() {
+        size_t count = records.size();
+        SplatBatch batch;
+        batch.positions.resize(count);
+        batch.scales.resize(count);
+        batch.rotations.resize(count);
+        batch.colors.resize(count);
+        batch.sh.resize(count * _shBytes);
+        parallelFor(parallelThreads(count, 4096), count, [&](size_t, size_t _start, size_t _end) {
+            for (size_t k = _start; k < _end; k++)
+                _decode(records[k], batch, k);
+        });
+        records.clear();
+        return pushLoadBatch(batch);
+    };
+
+    if (stride > 1) {
+        for (size_t i = 0; i < _count; i += stride)
+            records.push_back(i);
+        if (!flush())
+            return false;
+    }
+
+    for (size_t i = 0; i < _count; i++) {
+        if (stride > 1 && i % stride == 0)
+            continue;
+        records.push_back(i);
+        if (records.size() == _batchSize && !flush())
+            return false;
+    }
+    return records.empty() || flush();
+}
+
+// ASCII and big-endian .ply, through tinyply: everything is parsed into a
+// staging copy first, then fed largest (opacity x volume) first
+void Gsplat::loadStagedBatches(const std::string& _filepath, int _shMaxDegree, size_t _batchSize) {
+    Gsplat staging;
+    staging.m_shMaxDegree = _shMaxDegree;
+    if (!staging.loadPLY(_filepath)) {
+        throw std::runtime_error("Failed to read splat file: " + _filepath);
+    }
+
+    size_t n = staging.m_positions.size();
+    size_t shBytes = staging.shCoeffCount() * 3;
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_loadFileTotal = n;
+        m_loadSHDegree = staging.m_shDegree;
+        m_loadSHRange = staging.m_shRange;
+    }
+
+    std::vector<float> importance(n);
+    for (size_t i = 0; i < n; i++) {
+        const glm::vec3& s = staging.m_scales[i];
+        importance[i] = staging.m_colors[i].a * s.x * s.y * s.z;
+    }
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return importance[a] > importance[b];
+    });
+
+    for (size_t start = 0; start < n; start += _batchSize) {
+        size_t count = std::min(_batchSize, n - start);
+        SplatBatch batch;
+        batch.positions.resize(count);
+        batch.scales.resize(count);
+        batch.rotations.resize(count);
+        batch.colors.resize(count);
+        batch.sh.resize(count * shBytes);
+        for (size_t k = 0; k < count; k++) {
+            uint32_t i = order[start + k];
+            batch.positions[k] = staging.m_positions[i];
+            batch.scales[k] = staging.m_scales[i];
+            batch.rotations[k] = staging.m_rotations[i];
+            batch.colors[k] = staging.m_colors[i];
+            if (shBytes > 0)
+                std::memcpy(batch.sh.data() + k * shBytes, staging.m_shCoeffs.data() + (size_t)i * shBytes, shBytes);
+        }
+
+        if (!pushLoadBatch(batch))
+            return;
+    }
+}
+
+bool Gsplat::pushLoadBatch(SplatBatch& _batch) {
+    std::unique_lock<std::mutex> lock(m_loadMutex);
+    // Only a few batches in flight: the render thread appends them at its
+    // own pace, the loader waits instead of piling up memory
+    m_loadCondition.wait(lock, [this]() { return m_loadCancel || m_loadQueue.size() < 4; });
+    if (m_loadCancel)
+        return false;
+
+    m_loadQueue.push_back(std::move(_batch));
+    return true;
+}
+
+void Gsplat::updateProgressiveLoad() {
+    if (!m_loadThread.joinable())
+        return;
+
+    std::deque<SplatBatch> batches;
+    bool done = false;
+    std::string error;
+    size_t total = 0;
+    int shDegree = 0;
+    glm::vec2 shRange(0.0f);
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        batches.swap(m_loadQueue);
+        done = m_loadDone;
+        error = m_loadError;
+        total = m_loadFileTotal;
+        shDegree = m_loadSHDegree;
+        shRange = m_loadSHRange;
+    }
+    m_loadCondition.notify_all();
+
+    if (!batches.empty()) {
+        finishSort();
+        dropLOD();
+
+        if (m_positions.empty()) {
+            m_shDegree = shDegree;
+            m_shRange = shRange;
+        }
+        m_loadTotal = total;
+
+        size_t begin = m_positions.size();
+        for (SplatBatch& batch : batches) {
+            m_positions.insert(m_positions.end(), batch.positions.begin(), batch.positions.end());
+            m_scales.insert(m_scales.end(), batch.scales.begin(), batch.scales.end());
+            m_rotations.insert(m_rotations.end(), batch.rotations.begin(), batch.rotations.end());
+            m_colors.insert(m_colors.end(), batch.colors.begin(), batch.colors.end());
+            m_shCoeffs.insert(m_shCoeffs.end(), batch.sh.begin(), batch.sh.end());
+        }
+
+        // No spatial index yet: every splat gets sorted until the load ends
+        m_sortPreviousValid = false;
+        m_sortPositionsDirty = true;
+        m_hasSorted = false;
+        updateTextureRows(begin, m_positions.size());
+    }
+
+    if (done) {
+        m_loadThread.join();
+        m_loadTotal = 0;
+        m_loadDone = false;
+        if (!error.empty())
+            std::cout << "Gsplat: " << error << std::endl;
+
+        // Arrival order is importance, not space: lay it out and index it
+        // like a regular load (which reorders the GPU copies too)
+        finishLoad(true);
+        resetTextures();
+    }
+}
+
+void Gsplat::ensureSharedBuffers() {
+    // Quad corners (point-sprite geometry) and the depth-sorted instance
+    // index buffer are shader-agnostic and shared between the color VAO
+    // (m_vao) and the normal-buffer VAO (m_normalVao).
+    if (m_positionVBO == 0) {
+        float quadVertices[] = {
+            -2.0f, -2.0f,
+             2.0f, -2.0f,
+             2.0f,  2.0f,
+            -2.0f,  2.0f
+        };
+
         glGenBuffers(1, &m_positionVBO);
         glBindBuffer(GL_ARRAY_BUFFER, m_positionVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
@@ -529,6 +2046,7 @@ void Gsplat::ensureSharedBuffers() {
         glGenBuffers(1, &m_indexVBO);
         glBindBuffer(GL_ARRAY_BUFFER, m_indexVBO);
         glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
+        m_indexDirty = true;
     }
 }
 
@@ -616,25 +2134,230 @@ void Gsplat::ensureDepthShader() {
 }
 
 void Gsplat::ensureTexture(int _shaderVersion) {
+    updateProgressiveLoad();
+
+    if (m_dirtyEnd > m_dirtyBegin) {
+        updateTextureRows(m_dirtyBegin, m_dirtyEnd);
+        m_dirtyBegin = m_dirtyEnd = 0;
+    }
+
     if (!m_texture) {
         if (_shaderVersion >= 300)
             m_texture = createTextureUint();
         else
             m_texture = createTextureFloat();
+        m_textureVersion = _shaderVersion;
+    }
+
+    // View-dependent color is only evaluated by the GLSL 300 shaders
+    if (!m_shTexture && m_shDegree > 0 && _shaderVersion >= 300)
+        m_shTexture = createTextureSH();
+}
+
+void Gsplat::resetTextures() {
+    if (m_texture) {
+        m_texture->clear();
+        delete m_texture;
+        m_texture = nullptr;
+    }
+
+    if (m_shTexture) {
+        m_shTexture->clear();
+        delete m_shTexture;
+        m_shTexture = nullptr;
     }
 }
 
-void Gsplat::ensureSorted(const glm::mat4& _viewProj, bool _sort) {
+void Gsplat::ensureSorted(const glm::mat4& _viewProj, const glm::mat4& _model, float _viewportHeight, bool _sort) {
+    glm::mat4 viewProj = _viewProj;
+    float viewportHeight = _viewportHeight;
+    if (s_multiViewFrame != 0) {
+        // Every view of the frame sorts with the shared viewProj, so only the
+        // first one finds it changed (and only it honours _sort). Shrinking
+        // clip x/y widens the frustum; the taller viewport keeps the LOD
+        // error in the same pixels.
+        glm::mat4 widen(1.0f);
+        widen[0][0] = widen[1][1] = 1.0f / s_multiViewGuard;
+        viewProj = widen * s_multiViewViewProj * _model;
+        viewportHeight *= s_multiViewGuard;
+        if (m_multiViewFrame == s_multiViewFrame)
+            _sort = false;
+        m_multiViewFrame = s_multiViewFrame;
+    }
+
     // Re-sort whenever the viewProj we'd sort with differs from the one we
     // last sorted with (this already folds in both camera and model-matrix
     // changes), rather than relying on Camera::bChange, which may have
     // already been consumed elsewhere earlier in the frame.
-    bool needsSort = _sort || !m_hasSorted || _viewProj != m_lastSortViewProj;
+    bool needsSort = _sort || !m_hasSorted || viewProj != m_lastSortViewProj;
+
+    if (!m_asyncSort) {
+        if (needsSort) {
+            sort(viewProj, viewportHeight);
+            m_lastSortViewProj = viewProj;
+            m_hasSorted = true;
+        }
+        return;
+    }
+
+    // Async: pick up whatever the worker finished since last time, then hand
+    // it the new viewpoint (m_lastSortViewProj is the last one *requested*).
+    collectSort(false);
+
     if (needsSort) {
-        sort(_viewProj);
-        m_lastSortViewProj = _viewProj;
-        m_hasSorted = true;
+        requestSort(viewProj, viewportHeight);
+        m_lastSortViewProj = viewProj;
+    }
+
+    // Nothing to draw yet, or the drawn order lags too far behind: block
+    // until the worker catches up.
+    while (!m_hasSorted ||
+           (m_sortMaxStaleness >= 0 && m_sortRequestTicket - m_sortPublishedTicket > (size_t)m_sortMaxStaleness)) {
+        if (!collectSort(true))
+            break;
+    }
+}
+
+void Gsplat::uploadIndexBuffer(int _shaderVersion) {
+    // The index VBO is shared by every pass, so only upload when a new order
+    // was published (or the index format the shader expects changed).
+    int format = (_shaderVersion >= 300) ? 300 : 100;
+    if (!m_indexDirty && m_indexUploadVersion == format)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_indexVBO);
+    if (format >= 300) {
+        glBufferData(GL_ARRAY_BUFFER, m_depthUintIndex.size() * sizeof(uint32_t), m_depthUintIndex.data(), GL_STREAM_DRAW);
+    }
+    else {
+        if (m_depthFloatIndex.size() != m_depthUintIndex.size()) {
+            m_depthFloatIndex.resize(m_depthUintIndex.size());
+            for (size_t i = 0; i < m_depthUintIndex.size(); i++)
+                m_depthFloatIndex[i] = static_cast<float>(m_depthUintIndex[i]);
+        }
+        glBufferData(GL_ARRAY_BUFFER, m_depthFloatIndex.size() * sizeof(float), m_depthFloatIndex.data(), GL_DYNAMIC_DRAW);
     }
+
+    m_indexDirty = false;
+    m_indexUploadVersion = format;
+}
+
+void Gsplat::startSortThread() {
+    if (m_sortThread.joinable())
+        return;
+
+    m_sortExit = false;
+    m_sortThread = std::thread(&Gsplat::sortThreadLoop, this);
+}
+
+void Gsplat::stopSortThread() {
+    if (!m_sortThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sortMutex);
+        m_sortExit = true;
+    }
+    m_sortCondition.notify_all();
+    m_sortThread.join();
+
+    m_sortPending = false;
+    m_sortBusy = false;
+    m_sortReady = false;
+}
+
+void Gsplat::finishSort() {
+    // Whatever changes next, the current order was sorted without it: ask
+    // for a new one, even from a camera that doesn't move
+    m_lastSortViewProj = glm::mat4(0.0f);
+
+    if (!m_sortThread.joinable())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_sortMutex);
+    m_sortPending = false;
+    m_sortCondition.wait(lock, [this]() { return !m_sortBusy; });
+    // Whatever it produced was computed against data that is about to change
+    m_sortReady = false;
+    m_sortPublishedTicket = m_sortRequestTicket;
+}
+
+void Gsplat::sortThreadLoop() {
+    std::vector<uint32_t>   order;
+    std::vector<uint8_t>    occluded;
+
+    while (true) {
+        glm::mat4 viewProj;
+        float viewportHeight = 0.0f;
+        bool occlusion = true;
+        size_t ticket = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_sortMutex);
+            m_sortCondition.wait(lock, [this]() { return m_sortExit || m_sortPending; });
+            if (m_sortExit)
+                return;
+
+            // Only the latest request matters, older ones were overwritten
+            viewProj = m_sortRequestViewProj;
+            viewportHeight = m_sortRequestViewportHeight;
+            ticket = m_sortPendingTicket;
+            occlusion = m_sortRequestOcclusion;
+            m_sortPending = false;
+            m_sortBusy = true;
+        }
+
+        computeOrder(viewProj, viewportHeight, occlusion, order, occluded);
+
+        {
+            std::lock_guard<std::mutex> lock(m_sortMutex);
+            // Back buffer: swapped with the front one on publish, so its
+            // storage gets recycled instead of reallocated every sort
+            m_sortBack.swap(order);
+            m_sortBackOccluded.swap(occluded);
+            m_sortBackTicket = ticket;
+            m_sortReady = true;
+            m_sortBusy = false;
+        }
+        m_sortCondition.notify_all();
+    }
+}
+
+void Gsplat::requestSort(const glm::mat4& _viewProj, float _viewportHeight) {
+    startSortThread();
+
+    {
+        std::lock_guard<std::mutex> lock(m_sortMutex);
+        m_sortRequestViewProj = _viewProj;
+        m_sortRequestViewportHeight = _viewportHeight;
+        m_sortRequestOcclusion = (s_multiViewFrame == 0);
+        m_sortPendingTicket = ++m_sortRequestTicket;
+        m_sortPending = true;
+    }
+    m_sortCondition.notify_all();
+}
+
+bool Gsplat::collectSort(bool _wait) {
+    if (!m_sortThread.joinable())
+        return false;
+
+    {
+        std::unique_lock<std::mutex> lock(m_sortMutex);
+        if (_wait)
+            m_sortCondition.wait(lock, [this]() { return m_sortReady || (!m_sortBusy && !m_sortPending); });
+
+        if (!m_sortReady)
+            return false;
+
+        m_depthUintIndex.swap(m_sortBack);
+        m_occludedBlocks.swap(m_sortBackOccluded);
+        m_sortPublishedTicket = m_sortBackTicket;
+        m_sortReady = false;
+    }
+
+    m_depthFloatIndex.clear();
+    m_indexDirty = true;
+    m_hasSorted = true;
+    return true;
 }
 
 void Gsplat::use(Shader* _shader) {
@@ -650,11 +2373,7 @@ void Gsplat::use(Shader* _shader) {
             different = true;
 
             // Clear existing texture if GLSL version changes and we pack the data differently
-            if (m_texture) {
-                m_texture->clear();
-                delete m_texture;
-                m_texture = nullptr;
-            }
+            resetTextures();
         }
 
         if (m_shader && different && !m_borrowedShader) {
@@ -714,212 +2433,200 @@ void Gsplat::use(Shader* _shader) {
     }
 }
 
+// Texture rows hold 1024 splats each. Splats are packed straight into their
+// final place (row i / 1024) of a buffer covering rows [_rowBegin, _rowEnd),
+// so the same code builds the whole texture or just the rows to update.
+// Rows are packed in parallel, and every texel of them is written (unused
+// slots and columns zeroed), so the buffers need no clearing beforehand.
+static const size_t SPLATS_PER_ROW = 1024;
+
+void Gsplat::packRowsFloat(size_t _rowBegin, size_t _rowEnd, float* _dst) const {
+    size_t texWidth = SPLATS_PER_ROW * 4;  // 4 texels per splat
+    size_t rows = _rowEnd - _rowBegin;
+
+    parallelFor(parallelThreads(rows, 8), rows, [&](size_t, size_t _start, size_t _end) {
+        for (size_t r = _start; r < _end; r++) {
+            // Splats [first, last) of this row, the rest of it zeroed
+            size_t first = (_rowBegin + r) * SPLATS_PER_ROW;
+            size_t last = std::max(first, std::min(m_positions.size(), first + SPLATS_PER_ROW));
+            float* rowDst = _dst + r * texWidth * 4;
+            for (size_t i = first; i < last; i++)
+                packSplatFloat(i, rowDst + (i - first) * 4 * 4);
+            std::memset(rowDst + (last - first) * 16, 0, (first + SPLATS_PER_ROW - last) * 16 * sizeof(float));
+        }
+    });
+}
+
+void Gsplat::packSplatFloat(size_t _index, float* _texel) const {
+    const glm::vec3& pos = m_positions[_index];
+    const glm::vec3& scale = m_scales[_index];
+    const glm::quat& rot = m_rotations[_index];
+    const glm::u8vec4& color = m_colors[_index];
+
+    // Pixel 1: Position + normal-confidence (how much to trust the
+    // thin-axis normal below; see splatNormalConfidence())
+    _texel[0] = pos.x;
+    _texel[1] = pos.y;
+    _texel[2] = pos.z;
+    _texel[3] = splatNormalConfidence(scale);
+
+    // Convert quaternion to matrix for covariance
+    glm::mat3 rotMat = glm::mat3_cast(rot);
+    glm::mat3 scaleMat(0.0f);
+    scaleMat[0][0] = scale.x;
+    scaleMat[1][1] = scale.y;
+    scaleMat[2][2] = scale.z;
+
+    glm::mat3 M = rotMat * scaleMat;
+
+    // Compute 3D covariance (symmetric)
+    float sigma[6];
+    sigma[0] = M[0][0] * M[0][0] + M[1][0] * M[1][0] + M[2][0] * M[2][0]; // xx
+    sigma[1] = M[0][0] * M[0][1] + M[1][0] * M[1][1] + M[2][0] * M[2][1]; // xy
+    sigma[2] = M[0][0] * M[0][2] + M[1][0] * M[1][2] + M[2][0] * M[2][2]; // xz
+    sigma[3] = M[0][1] * M[0][1] + M[1][1] * M[1][1] + M[2][1] * M[2][1]; // yy
+    sigma[4] = M[0][1] * M[0][2] + M[1][1] * M[1][2] + M[2][1] * M[2][2]; // yz
+    sigma[5] = M[0][2] * M[0][2] + M[1][2] * M[1][2] + M[2][2] * M[2][2]; // zz
+
+    // Pixel 2: Covariance part 1
+    _texel[4] = sigma[0]; // xx
+    _texel[5] = sigma[1]; // xy
+    _texel[6] = sigma[2]; // xz
+    _texel[7] = sigma[3]; // yy
+
+    // Pixel 3: Covariance part 2 + local-space normal (octahedral-encoded)
+    glm::vec2 octNormal = octEncode(splatLocalNormal(rotMat, scale));
+    _texel[8] = sigma[4]; // yz
+    _texel[9] = sigma[5]; // zz
+    _texel[10] = octNormal.x;
+    _texel[11] = octNormal.y;
+
+    // Pixel 4: Color (normalized)
+    _texel[12] = color.r / 255.0f;
+    _texel[13] = color.g / 255.0f;
+    _texel[14] = color.b / 255.0f;
+    _texel[15] = color.a / 255.0f;
+}
+
+void Gsplat::packRowsUint(size_t _rowBegin, size_t _rowEnd, uint32_t* _dst) const {
+    size_t texWidth = SPLATS_PER_ROW * 4;
+    size_t rows = _rowEnd - _rowBegin;
+
+    // 3 uvec4 texels per splat (of the 4 reserved columns -- 1 spare for
+    // future growth): position+normal, covariance+color, normal-confidence
+    parallelFor(parallelThreads(rows, 8), rows, [&](size_t, size_t _start, size_t _end) {
+        for (size_t r = _start; r < _end; r++) {
+            size_t first = (_rowBegin + r) * SPLATS_PER_ROW;
+            size_t last = std::max(first, std::min(m_positions.size(), first + SPLATS_PER_ROW));
+            uint32_t* rowDst = _dst + r * texWidth * 4;
+            for (size_t i = first; i < last; i++)
+                packSplatUint(i, rowDst + (i - first) * 3 * 4);
+            std::memset(rowDst + (last - first) * 12, 0, (texWidth * 4 - (last - first) * 12) * sizeof(uint32_t));
+        }
+    });
+}
+
+void Gsplat::packSplatUint(size_t _index, uint32_t* _texel) const {
+    const glm::vec3& pos = m_positions[_index];
+    const glm::vec3& scale = m_scales[_index];
+    const glm::quat& rot = m_rotations[_index];
+    const glm::u8vec4& color = m_colors[_index];
+
+    // First uvec4: position (xyz as floats reinterpreted as uint) + local-space
+    // normal (w, octahedral-encoded, half2x16-packed)
+    // Safe bit copy without violating strict aliasing
+    std::memcpy(&_texel[0], &pos.x, sizeof(uint32_t));
+    std::memcpy(&_texel[1], &pos.y, sizeof(uint32_t));
+    std::memcpy(&_texel[2], &pos.z, sizeof(uint32_t));
+
+    // Convert quaternion to matrix for covariance
+    glm::mat3 rotMat = glm::mat3_cast(rot);
+
+    glm::vec2 octNormal = octEncode(splatLocalNormal(rotMat, scale));
+    _texel[3] = packHalf2x16(octNormal.x, octNormal.y);
+
+    glm::mat3 scaleMat(0.0f);
+    scaleMat[0][0] = scale.x;
+    scaleMat[1][1] = scale.y;
+    scaleMat[2][2] = scale.z;
+
+    glm::mat3 M = rotMat * scaleMat;
+
+    // Compute 3D covariance (symmetric)
+    float sigma[6];
+    sigma[0] = M[0][0] * M[0][0] + M[1][0] * M[1][0] + M[2][0] * M[2][0]; // xx
+    sigma[1] = M[0][0] * M[0][1] + M[1][0] * M[1][1] + M[2][0] * M[2][1]; // xy
+    sigma[2] = M[0][0] * M[0][2] + M[1][0] * M[1][2] + M[2][0] * M[2][2]; // xz
+    sigma[3] = M[0][1] * M[0][1] + M[1][1] * M[1][1] + M[2][1] * M[2][1]; // yy
+    sigma[4] = M[0][1] * M[0][2] + M[1][1] * M[1][2] + M[2][1] * M[2][2]; // yz
+    sigma[5] = M[0][2] * M[0][2] + M[1][2] * M[1][2] + M[2][2] * M[2][2]; // zz
+
+    // Second uvec4: covariance (xyz as half2) + color (w as packed RGBA)
+    // Pack covariance as half-precision floats: xy, xz|yy, yz|zz
+    _texel[4] = packHalf2x16(sigma[0], sigma[1]); // xx, xy
+    _texel[5] = packHalf2x16(sigma[2], sigma[3]); // xz, yy
+    _texel[6] = packHalf2x16(sigma[4], sigma[5]); // yz, zz
+
+    // Pack color as RGBA in a single uint32
+    _texel[7] = (uint32_t)color.r | ((uint32_t)color.g << 8) | ((uint32_t)color.b << 16) | ((uint32_t)color.a << 24);
+
+    // Third uvec4: normal-confidence (x, plain float bits), rest spare
+    float normalConfidence = splatNormalConfidence(scale);
+    std::memcpy(&_texel[8], &normalConfidence, sizeof(uint32_t));
+    _texel[9]  = 0;
+    _texel[10] = 0;
+    _texel[11] = 0;
+}
+
+void Gsplat::packRowsSH(size_t _rowBegin, size_t _rowEnd, uint8_t* _dst) const {
+    // Each splat's quantized coefficients are copied as-is into a run of
+    // uvec4 texels (16 bytes each): 1, 2 and 3 texels for degree 1, 2 and 3
+    size_t stride = shCoeffCount() * 3;
+    size_t texelsPerSplat = (stride + 15) / 16;
+    size_t rowBytes = SPLATS_PER_ROW * texelsPerSplat * 16;
+    size_t rows = _rowEnd - _rowBegin;
+
+    parallelFor(parallelThreads(rows, 8), rows, [&](size_t, size_t _start, size_t _end) {
+        for (size_t r = _start; r < _end; r++) {
+            size_t first = (_rowBegin + r) * SPLATS_PER_ROW;
+            size_t last = std::max(first, std::min(m_positions.size(), first + SPLATS_PER_ROW));
+            uint8_t* rowDst = _dst + r * rowBytes;
+            std::memset(rowDst, 0, rowBytes);
+            for (size_t i = first; i < last; i++)
+                std::memcpy(rowDst + (i - first) * texelsPerSplat * 16, m_shCoeffs.data() + i * stride, stride);
+        }
+    });
+}
+
+size_t Gsplat::textureCapacity() const {
+    // While streaming, room for the whole file so batches only need updates
+    size_t splatCount = std::max(m_positions.size(), m_loadTotal);
+    return std::max((size_t)1, (splatCount + SPLATS_PER_ROW - 1) / SPLATS_PER_ROW) * SPLATS_PER_ROW;
+}
+
 Texture *Gsplat::createTextureFloat() {
+    size_t texWidth = SPLATS_PER_ROW * 4;  // 4 texels per splat
+    size_t texHeight = textureCapacity() / SPLATS_PER_ROW;
 
-    size_t splatCount = count();
-    size_t splatsPerRow = 1024;
-    size_t texWidth = splatsPerRow * 4;  // 4 texels per splat
-    size_t texHeight = std::max(1, (int)std::ceil(splatCount / (float)splatsPerRow));
+    std::unique_ptr<float[]> textureData(new float[texWidth * texHeight * 4]);
+    packRowsFloat(0, texHeight, textureData.get());
 
-    // Allocate packed data - 4 vec4 per gaussian (16 floats)
-    std::vector<float>  packedData;
-    packedData.resize(splatCount * 16); 
-    
-    for (size_t i = 0; i < splatCount; i++) {
-        const glm::vec3& pos = m_positions[i];
-        const glm::vec3& scale = m_scales[i];
-        const glm::quat& rot = m_rotations[i];
-        const glm::u8vec4& color = m_colors[i];
-        
-        // Pixel 1: Position + normal-confidence (how much to trust the
-        // thin-axis normal below; see splatNormalConfidence())
-        packedData[i * 16 + 0] = pos.x;
-        packedData[i * 16 + 1] = pos.y;
-        packedData[i * 16 + 2] = pos.z;
-        packedData[i * 16 + 3] = splatNormalConfidence(scale);
-
-        // Convert quaternion to matrix for covariance
-        glm::mat3 rotMat = glm::mat3_cast(rot);
-        glm::mat3 scaleMat(0.0f);
-        scaleMat[0][0] = scale.x;
-        scaleMat[1][1] = scale.y;
-        scaleMat[2][2] = scale.z;
-        
-        glm::mat3 M = rotMat * scaleMat;
-        
-        // Compute 3D covariance (symmetric)
-        float sigma[6];
-        sigma[0] = M[0][0] * M[0][0] + M[1][0] * M[1][0] + M[2][0] * M[2][0]; // xx
-        sigma[1] = M[0][0] * M[0][1] + M[1][0] * M[1][1] + M[2][0] * M[2][1]; // xy
-        sigma[2] = M[0][0] * M[0][2] + M[1][0] * M[1][2] + M[2][0] * M[2][2]; // xz
-        sigma[3] = M[0][1] * M[0][1] + M[1][1] * M[1][1] + M[2][1] * M[2][1]; // yy
-        sigma[4] = M[0][1] * M[0][2] + M[1][1] * M[1][2] + M[2][1] * M[2][2]; // yz
-        sigma[5] = M[0][2] * M[0][2] + M[1][2] * M[1][2] + M[2][2] * M[2][2]; // zz
-        
-        // Pixel 2: Covariance part 1
-        packedData[i * 16 + 4] = sigma[0]; // xx
-        packedData[i * 16 + 5] = sigma[1]; // xy
-        packedData[i * 16 + 6] = sigma[2]; // xz
-        packedData[i * 16 + 7] = sigma[3]; // yy
-
-        // Pixel 3: Covariance part 2 + local-space normal (octahedral-encoded)
-        glm::vec2 octNormal = octEncode(splatLocalNormal(rotMat, scale));
-        packedData[i * 16 + 8] = sigma[4]; // yz
-        packedData[i * 16 + 9] = sigma[5]; // zz
-        packedData[i * 16 + 10] = octNormal.x;
-        packedData[i * 16 + 11] = octNormal.y;
-
-        // Pixel 4: Color (normalized)
-        packedData[i * 16 + 12] = color.r / 255.0f;
-        packedData[i * 16 + 13] = color.g / 255.0f;
-        packedData[i * 16 + 14] = color.b / 255.0f;
-        packedData[i * 16 + 15] = color.a / 255.0f;
-    }
-
-    // Reorganize packed data into 2D texture layout
-    std::vector<float> textureData(texWidth * texHeight * 4, 0.0f);
-    
-    for (size_t i = 0; i < splatCount; i++) {
-        int row = i / splatsPerRow;
-        int col = (i % splatsPerRow) * 4;  // Each gaussian takes 4 columns
-        
-        // Pixel 1 (pos)
-        size_t idx1 = (row * texWidth + col) * 4;
-        textureData[idx1 + 0] = packedData[i * 16 + 0];
-        textureData[idx1 + 1] = packedData[i * 16 + 1];
-        textureData[idx1 + 2] = packedData[i * 16 + 2];
-        textureData[idx1 + 3] = packedData[i * 16 + 3];
-        
-        // Pixel 2 (cov1)
-        size_t idx2 = (row * texWidth + col + 1) * 4;
-        textureData[idx2 + 0] = packedData[i * 16 + 4];
-        textureData[idx2 + 1] = packedData[i * 16 + 5];
-        textureData[idx2 + 2] = packedData[i * 16 + 6];
-        textureData[idx2 + 3] = packedData[i * 16 + 7];
-
-        // Pixel 3 (cov2)
-        size_t idx3 = (row * texWidth + col + 2) * 4;
-        textureData[idx3 + 0] = packedData[i * 16 + 8];
-        textureData[idx3 + 1] = packedData[i * 16 + 9];
-        textureData[idx3 + 2] = packedData[i * 16 + 10];
-        textureData[idx3 + 3] = packedData[i * 16 + 11];
-
-        // Pixel 4 (color)
-        size_t idx4 = (row * texWidth + col + 3) * 4;
-        textureData[idx4 + 0] = packedData[i * 16 + 12];
-        textureData[idx4 + 1] = packedData[i * 16 + 13];
-        textureData[idx4 + 2] = packedData[i * 16 + 14];
-        textureData[idx4 + 3] = packedData[i * 16 + 15];
-    }
-    
     Texture* texture = new Texture();
-    texture->load(texWidth, texHeight, 4, 32, textureData.data(), NEAREST, CLAMP);
+    texture->load(texWidth, texHeight, 4, 32, textureData.get(), NEAREST, CLAMP);
 
     return texture;
 }
 
 Texture* Gsplat::createTextureUint() {
+    size_t texWidth = SPLATS_PER_ROW * 4;  // 4 texels per splat
+    size_t texHeight = textureCapacity() / SPLATS_PER_ROW;
 
-    size_t splatCount = count();
-    size_t splatsPerRow = 1024;
-    size_t texWidth = splatsPerRow * 4;  // 4 texels per splat
-    size_t texHeight = std::max(1, (int)std::ceil(splatCount / (float)splatsPerRow));
-
-    // 3 uvec4 texels per splat (of the 4 reserved columns -- 1 spare for
-    // future growth): position+normal, covariance+color, normal-confidence
-    std::vector<uint32_t>  packedData;
-    packedData.resize(splatCount * 12);
-    for (size_t i = 0; i < splatCount; i++) {
-        const glm::vec3& pos = m_positions[i];
-        const glm::vec3& scale = m_scales[i];
-        const glm::quat& rot = m_rotations[i];
-        const glm::u8vec4& color = m_colors[i];
-
-        // First uvec4: position (xyz as floats reinterpreted as uint) + local-space
-        // normal (w, octahedral-encoded, half2x16-packed)
-        // Safe bit copy without violating strict aliasing
-        uint32_t ux, uy, uz;
-        std::memcpy(&ux, &pos.x, sizeof(uint32_t));
-        std::memcpy(&uy, &pos.y, sizeof(uint32_t));
-        std::memcpy(&uz, &pos.z, sizeof(uint32_t));
-        packedData[i * 12 + 0] = ux;
-        packedData[i * 12 + 1] = uy;
-        packedData[i * 12 + 2] = uz;
-
-        // Convert quaternion to matrix for covariance
-        glm::mat3 rotMat = glm::mat3_cast(rot);
-
-        glm::vec2 octNormal = octEncode(splatLocalNormal(rotMat, scale));
-        packedData[i * 12 + 3] = packHalf2x16(octNormal.x, octNormal.y);
-
-        glm::mat3 scaleMat(0.0f);
-        scaleMat[0][0] = scale.x;
-        scaleMat[1][1] = scale.y;
-        scaleMat[2][2] = scale.z;
-
-        glm::mat3 M = rotMat * scaleMat;
-
-        // Compute 3D covariance (symmetric)
-        float sigma[6];
-        sigma[0] = M[0][0] * M[0][0] + M[1][0] * M[1][0] + M[2][0] * M[2][0]; // xx
-        sigma[1] = M[0][0] * M[0][1] + M[1][0] * M[1][1] + M[2][0] * M[2][1]; // xy
-        sigma[2] = M[0][0] * M[0][2] + M[1][0] * M[1][2] + M[2][0] * M[2][2]; // xz
-        sigma[3] = M[0][1] * M[0][1] + M[1][1] * M[1][1] + M[2][1] * M[2][1]; // yy
-        sigma[4] = M[0][1] * M[0][2] + M[1][1] * M[1][2] + M[2][1] * M[2][2]; // yz
-        sigma[5] = M[0][2] * M[0][2] + M[1][2] * M[1][2] + M[2][2] * M[2][2]; // zz
-
-        // Second uvec4: covariance (xyz as half2) + color (w as packed RGBA)
-        // Pack covariance as half-precision floats: xy, xz|yy, yz|zz
-        packedData[i * 12 + 4] = packHalf2x16(sigma[0], sigma[1]); // xx, xy
-        packedData[i * 12 + 5] = packHalf2x16(sigma[2], sigma[3]); // xz, yy
-        packedData[i * 12 + 6] = packHalf2x16(sigma[4], sigma[5]); // yz, zz
-
-        // Pack color as RGBA in a single uint32
-        uint32_t packedColor = (uint32_t)color.r | ((uint32_t)color.g << 8) | ((uint32_t)color.b << 16) | ((uint32_t)color.a << 24);
-        packedData[i * 12 + 7] = packedColor;
-
-        // Third uvec4: normal-confidence (x, plain float bits), rest spare
-        float normalConfidence = splatNormalConfidence(scale);
-        uint32_t confBits;
-        std::memcpy(&confBits, &normalConfidence, sizeof(uint32_t));
-        packedData[i * 12 + 8]  = confBits;
-        packedData[i * 12 + 9]  = 0;
-        packedData[i * 12 + 10] = 0;
-        packedData[i * 12 + 11] = 0;
-    }
-
-    // Reorganize packed data into 2D texture layout
-    // Each gaussian occupies 3 horizontal pixels (columns)
-    std::vector<uint32_t> textureData(texWidth * texHeight * 4);
-    for (size_t i = 0; i < splatCount; i++) {
-        int row = i / 1024;
-        int col = (i % 1024) * 3;  // Each gaussian takes 3 columns
-
-        // First uvec4 (position + normal)
-        int idx1 = (row * texWidth + col) * 4;
-        textureData[idx1 + 0] = packedData[i * 12 + 0];
-        textureData[idx1 + 1] = packedData[i * 12 + 1];
-        textureData[idx1 + 2] = packedData[i * 12 + 2];
-        textureData[idx1 + 3] = packedData[i * 12 + 3];
-
-        // Second uvec4 (covariance + color)
-        int idx2 = (row * texWidth + col + 1) * 4;
-        textureData[idx2 + 0] = packedData[i * 12 + 4];
-        textureData[idx2 + 1] = packedData[i * 12 + 5];
-        textureData[idx2 + 2] = packedData[i * 12 + 6];
-        textureData[idx2 + 3] = packedData[i * 12 + 7];
-
-        // Third uvec4 (normal-confidence)
-        int idx3 = (row * texWidth + col + 2) * 4;
-        textureData[idx3 + 0] = packedData[i * 12 + 8];
-        textureData[idx3 + 1] = packedData[i * 12 + 9];
-        textureData[idx3 + 2] = packedData[i * 12 + 10];
-        textureData[idx3 + 3] = packedData[i * 12 + 11];
-    }
+    std::unique_ptr<uint32_t[]> textureData(new uint32_t[texWidth * texHeight * 4]);
+    packRowsUint(0, texHeight, textureData.get());
 
     GLuint splatTexture;
     glGenTextures(1, &splatTexture);
-    
+
     // Upload splat data texture
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, splatTexture);
@@ -927,15 +2634,89 @@ Texture* Gsplat::createTextureUint() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, texWidth, texHeight, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, textureData.data());
-                 
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, texWidth, texHeight, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, textureData.get());
+
     Texture* texture = new Texture();
     texture->load(texWidth, texHeight, splatTexture, NEAREST, CLAMP);
     return texture;
 }
 
+Texture* Gsplat::createTextureSH() {
+    size_t texelsPerSplat = (shCoeffCount() * 3 + 15) / 16;
+    size_t texWidth = SPLATS_PER_ROW * texelsPerSplat;
+    size_t texHeight = textureCapacity() / SPLATS_PER_ROW;
+
+    std::unique_ptr<uint8_t[]> textureData(new uint8_t[texWidth * texHeight * 16]);
+    packRowsSH(0, texHeight, textureData.get());
+
+    GLuint shTexture;
+    glGenTextures(1, &shTexture);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, shTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, texWidth, texHeight, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, textureData.get());
+
+    Texture* texture = new Texture();
+    texture->load(texWidth, texHeight, shTexture, NEAREST, CLAMP);
+    return texture;
+}
+
+// Re-packs and uploads only the texture rows holding splats [_begin, _end).
+// Textures too small for them are dropped, ensureTexture() rebuilds them.
+void Gsplat::updateTextureRows(size_t _begin, size_t _end) {
+    if (_begin >= _end)
+        return;
+
+    size_t rowBegin = _begin / SPLATS_PER_ROW;
+    size_t rowEnd = (_end + SPLATS_PER_ROW - 1) / SPLATS_PER_ROW;
+    size_t rows = rowEnd - rowBegin;
+
+    if ((m_texture && (size_t)m_texture->getHeight() < rowEnd) ||
+        (m_shTexture && (size_t)m_shTexture->getHeight() < rowEnd)) {
+        resetTextures();
+        return;
+    }
+
+    if (!m_texture && !m_shTexture)
+        return;
+
+    if (m_texture) {
+        size_t texWidth = m_texture->getWidth();
+        if (m_textureVersion >= 300) {
+            std::unique_ptr<uint32_t[]> data(new uint32_t[texWidth * rows * 4]);
+            packRowsUint(rowBegin, rowEnd, data.get());
+            glBindTexture(GL_TEXTURE_2D, m_texture->getTextureId());
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rowBegin, texWidth, rows, GL_RGBA_INTEGER, GL_UNSIGNED_INT, data.get());
+        }
+        else {
+            std::unique_ptr<float[]> data(new float[texWidth * rows * 4]);
+            packRowsFloat(rowBegin, rowEnd, data.get());
+            m_texture->update(0, rowBegin, texWidth, rows, data.get());
+        }
+    }
+
+    if (m_shTexture) {
+        size_t texWidth = m_shTexture->getWidth();
+        std::unique_ptr<uint8_t[]> data(new uint8_t[texWidth * rows * 16]);
+        packRowsSH(rowBegin, rowEnd, data.get());
+        glBindTexture(GL_TEXTURE_2D, m_shTexture->getTextureId());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rowBegin, texWidth, rows, GL_RGBA_INTEGER, GL_UNSIGNED_INT, data.get());
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void Gsplat::buildSpatialIndex() {
-    m_blocks.clear();
+    finishSort();
+    dropLOD();
+    m_sortPreviousValid = false;
+    m_sortPositionsDirty = true;
+    clearBlocks();
+
     size_t count = m_positions.size();
     if (count == 0) return;
 
@@ -947,73 +2728,546 @@ void Gsplat::buildSpatialIndex() {
         minB = glm::min(minB, m_positions[i]);
         maxB = glm::max(maxB, m_positions[i]);
     }
-    
-    // Create Grid
-    m_blocks.resize(m_gridDim * m_gridDim * m_gridDim);
-    
-    glm::vec3 size = maxB - minB;
-    size = glm::max(size, glm::vec3(0.001f));
-    glm::vec3 step = size / (float)m_gridDim;
-
-    // Initialize bounds
-    for (int z = 0; z < m_gridDim; z++) {
-        for (int y = 0; y < m_gridDim; y++) {
-            for (int x = 0; x < m_gridDim; x++) {
-                int idx = z * m_gridDim * m_gridDim + y * m_gridDim + x;
-                m_blocks[idx].min_bounds = minB + glm::vec3(x, y, z) * step;
-                m_blocks[idx].max_bounds = minB + glm::vec3(x+1, y+1, z+1) * step;
-                m_blocks[idx].indices.reserve(count / m_blocks.size() * 2);
+    glm::vec3 extents = glm::max(maxB - minB, glm::vec3(0.001f));
+
+    // Octree over the Morton codes: every node is a code prefix, i.e. a
+    // contiguous range of the Morton-sorted splats. Already laid out by
+    // optimizeDataLayout() (same bounds), so the sort is usually skipped and
+    // each leaf's indices are a consecutive run of splats.
+    std::vector<uint32_t> keys(count);
+    parallelFor(parallelThreads(count, 65536), count, [&](size_t, size_t _start, size_t _end) {
+        for (size_t i = _start; i < _end; i++)
+            keys[i] = morton3D(m_positions[i], minB, extents);
+    });
+
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    m_blocksContiguous = std::is_sorted(keys.begin(), keys.end());
+    if (!m_blocksContiguous) {
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return keys[a] < keys[b];
+        });
+        std::vector<uint32_t> sorted(count);
+        for (size_t i = 0; i < count; i++)
+            sorted[i] = keys[order[i]];
+        keys.swap(sorted);
+    }
+
+    // Octree leaves end up a quarter to half full on average: a 4x larger
+    // cap lands close to the _dim^3 blocks of the old grid
+    size_t leafSize = m_blockSize;
+    if (leafSize == 0)
+        leafSize = std::max((size_t)256, 4 * count / ((size_t)m_gridDim * m_gridDim * m_gridDim));
+
+    // Children of a node are allocated together (contiguous), then filled
+    // depth first, so the leaves (blocks) come out in Morton order and every
+    // node covers a contiguous range of m_blocks.
+    std::function<void(uint32_t, size_t, size_t, int)> build = [&](uint32_t _node, size_t _begin, size_t _end, int _shift) {
+        // Nodes with a single occupied octant are skipped: one node per split
+        size_t split[9];
+        bool leaf = false;
+        while (true) {
+            if (_end - _begin <= leafSize || _shift == 0) {
+                leaf = true;
+                break;
+            }
+
+            _shift -= 3;
+            split[0] = _begin;
+            for (uint32_t c = 1; c < 8; c++) {
+                uint32_t prefix = (keys[_begin] >> (_shift + 3) << (_shift + 3)) | (c << _shift);
+                split[c] = std::lower_bound(keys.begin() + split[c - 1], keys.begin() + _end, prefix) - keys.begin();
             }
+            split[8] = _end;
+
+            int occupied = 0;
+            for (int c = 0; c < 8; c++)
+                occupied += (split[c + 1] > split[c]) ? 1 : 0;
+            if (occupied > 1)
+                break;
         }
+
+        SplatOctreeNode& node = m_octree[_node];
+        node.firstBlock = (uint32_t)m_blocks.size();
+
+        if (leaf) {
+            SplatBlock block;
+            block.indices.assign(order.begin() + _begin, order.begin() + _end);
+            block.min_bounds = block.max_bounds = m_positions[block.indices[0]];
+            for (uint32_t i : block.indices) {
+                block.min_bounds = glm::min(block.min_bounds, m_positions[i]);
+                block.max_bounds = glm::max(block.max_bounds, m_positions[i]);
+            }
+            node.min_bounds = block.min_bounds;
+            node.max_bounds = block.max_bounds;
+            node.blockCount = 1;
+            m_blocks.push_back(std::move(block));
+            return;
+        }
+
+        uint32_t firstChild = (uint32_t)m_octree.size();
+        uint32_t childCount = 0;
+        for (int c = 0; c < 8; c++)
+            childCount += (split[c + 1] > split[c]) ? 1 : 0;
+        m_octree.resize(firstChild + childCount);
+        m_octree[_node].firstChild = firstChild;
+        m_octree[_node].childCount = childCount;
+
+        uint32_t child = firstChild;
+        for (int c = 0; c < 8; c++) {
+            if (split[c + 1] > split[c])
+                build(child++, split[c], split[c + 1], _shift);
+        }
+
+        SplatOctreeNode& parent = m_octree[_node];
+        parent.min_bounds = m_octree[firstChild].min_bounds;
+        parent.max_bounds = m_octree[firstChild].max_bounds;
+        for (uint32_t k = firstChild + 1; k < firstChild + childCount; k++) {
+            parent.min_bounds = glm::min(parent.min_bounds, m_octree[k].min_bounds);
+            parent.max_bounds = glm::max(parent.max_bounds, m_octree[k].max_bounds);
+        }
+        parent.blockCount = (uint32_t)m_blocks.size() - parent.firstBlock;
+    };
+
+    m_octree.resize(1);
+    build(0, 0, count, 30);
+
+    parallelFor(parallelThreads(m_blocks.size(), 64), m_blocks.size(), [&](size_t, size_t _start, size_t _end) {
+        for (size_t b = _start; b < _end; b++)
+            classifyOccluder(m_blocks[b]);
+    });
+
+    if (m_lodEnabled)
+        buildLOD();
+    // std::cout << "Built Spatial Index: " << m_blocks.size() << " active blocks." << std::endl;
+}
+
+void Gsplat::clearBlocks() {
+    m_blocks.clear();
+    m_octree.clear();
+    m_blocksContiguous = false;
+    m_occlusionHiddenSorts.clear();
+    m_occludedBlocks.clear();
+}
+
+// Re-tightens the bounds of the blocks holding splats [_begin, _end) and of
+// the octree nodes above them, after those splats moved. The tree itself is
+// kept: a big enough move calls for a rebuild (see setBlockSize()).
+void Gsplat::refitBlocks(size_t _begin, size_t _end) {
+    for (SplatBlock& block : m_blocks) {
+        bool touched = false;
+        if (m_blocksContiguous)
+            touched = block.indices[0] < _end && block.indices[0] + block.indices.size() > _begin;
+        else
+            for (uint32_t i : block.indices)
+                touched = touched || (i >= _begin && i < _end);
+        if (!touched)
+            continue;
+
+        block.min_bounds = block.max_bounds = m_positions[block.indices[0]];
+        for (uint32_t i : block.indices) {
+            block.min_bounds = glm::min(block.min_bounds, m_positions[i]);
+            block.max_bounds = glm::max(block.max_bounds, m_positions[i]);
+        }
+        classifyOccluder(block);
     }
 
-    // Bin points
-    for (uint32_t i = 0; i < count; i++) {
-        const glm::vec3& p = m_positions[i];
-        
-        glm::vec3 relative = (p - minB) / size;
-        relative = glm::clamp(relative, 0.0f, 0.9999f);
-        
-        int x = (int)(relative.x * m_gridDim);
-        int y = (int)(relative.y * m_gridDim);
-        int z = (int)(relative.z * m_gridDim);
-        
-        int idx = z * m_gridDim * m_gridDim + y * m_gridDim + x;
-        m_blocks[idx].indices.push_back(i);
+    // Children always come after their parent
+    for (size_t n = m_octree.size(); n-- > 0;) {
+        SplatOctreeNode& node = m_octree[n];
+        if (node.childCount == 0) {
+            node.min_bounds = m_blocks[node.firstBlock].min_bounds;
+            node.max_bounds = m_blocks[node.firstBlock].max_bounds;
+            continue;
+        }
+
+        node.min_bounds = m_octree[node.firstChild].min_bounds;
+        node.max_bounds = m_octree[node.firstChild].max_bounds;
+        for (uint32_t k = node.firstChild + 1; k < node.firstChild + node.childCount; k++) {
+            node.min_bounds = glm::min(node.min_bounds, m_octree[k].min_bounds);
+            node.max_bounds = glm::max(node.max_bounds, m_octree[k].max_bounds);
+        }
     }
-    
-    // Prune empty blocks
-    std::vector<SplatBlock> packed;
-    packed.reserve(m_blocks.size());
-    
-    // Setup queries
-    bool supportQueries = false; // Check capability if needed, assuming yes for now or ignoring if 0
-    // std::vector<GLuint> ids(m_blocks.size());
-    // glGenQueries(m_blocks.size(), ids.data()); 
-    // This might be too many queries for some drivers, but for 4096 blocks it's heavy.
-    // Let's create queries only for non-empty blocks.
-
-    for(size_t i = 0; i < m_blocks.size(); ++i) {
-        if (!m_blocks[i].indices.empty()) {
-            
-            // Recalculate bounds to fit actual content
-            glm::vec3 bMin = m_positions[m_blocks[i].indices[0]];
-            glm::vec3 bMax = bMin;
-
-            for (size_t k = 1; k < m_blocks[i].indices.size(); k++) {
-                const glm::vec3& p = m_positions[m_blocks[i].indices[k]];
-                bMin = glm::min(bMin, p);
-                bMax = glm::max(bMax, p);
+}
+
+// Walks the octree, setting _visible[b] for the blocks inside the frustum.
+// Subtrees fully outside are skipped and fully inside ones are accepted
+// without testing their blocks.
+void Gsplat::cullBlocks(const Frustum& _frustum, std::vector<uint8_t>& _visible) const {
+    _visible.assign(m_blocks.size(), 0);
+    if (m_octree.empty())
+        return;
+
+    // Depth first with at most 7 pending siblings per level (10 levels)
+    uint32_t stack[128];
+    size_t top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const SplatOctreeNode& node = m_octree[stack[--top]];
+
+        int side = classifyBox(node.min_bounds, node.max_bounds, _frustum);
+        if (side < 0)
+            continue;
+
+        if (side > 0 || node.childCount == 0) {
+            std::memset(_visible.data() + node.firstBlock, 1, node.blockCount);
+            continue;
+        }
+
+        for (uint32_t k = 0; k < node.childCount; k++)
+            stack[top++] = node.firstChild + k;
+    }
+}
+
+// -1: box outside the frustum, 1: fully inside, 0: intersecting
+int Gsplat::classifyBox(const glm::vec3& min, const glm::vec3& max, const Frustum& _frustum) const {
+    int side = 1;
+    for (int i = 0; i < 6; i++) {
+        glm::vec3 normal(_frustum.planes[i]);
+        // p-vertex (furthest along the normal) and n-vertex (opposite)
+        glm::vec3 p = glm::mix(min, max, glm::greaterThan(normal, glm::vec3(0.0f)));
+        glm::vec3 n = glm::mix(max, min, glm::greaterThan(normal, glm::vec3(0.0f)));
+
+        if (glm::dot(normal, p) + _frustum.planes[i].w < 0)
+            return -1;
+        if (glm::dot(normal, n) + _frustum.planes[i].w < 0)
+            side = 0;
+    }
+    return side;
+}
+
+void Gsplat::buildLOD() {
+    finishSort();
+    dropLOD();
+    if (m_blocks.empty())
+        return;
+
+    // Nodes are only ever appended after their children, so proxies can be
+    // merged in node order. Each block gets its own subtree (its nodes are
+    // contiguous), then the block roots are grouped up to a single root.
+    const size_t fanout = 8;
+    m_lodProxyStart = m_positions.size();
+
+    auto addLevel = [&](const std::vector<uint32_t>& _level, bool _leaf, int _block, std::vector<uint32_t>& _parents) {
+        _parents.clear();
+        for (size_t s = 0; s < _level.size(); s += fanout) {
+            SplatNode node;
+            node.firstChild = (uint32_t)m_lodChildren.size();
+            node.childCount = (uint32_t)std::min(fanout, _level.size() - s);
+            node.leaf = _leaf;
+            node.block = _block;
+            node.min_bounds = glm::vec3(std::numeric_limits<float>::max());
+            node.max_bounds = glm::vec3(std::numeric_limits<float>::lowest());
+            for (size_t k = s; k < s + node.childCount; k++) {
+                uint32_t child = _level[k];
+                if (_leaf) {
+                    node.min_bounds = glm::min(node.min_bounds, m_positions[child]);
+                    node.max_bounds = glm::max(node.max_bounds, m_positions[child]);
+                }
+                else {
+                    node.min_bounds = glm::min(node.min_bounds, m_lodNodes[child].min_bounds);
+                    node.max_bounds = glm::max(node.max_bounds, m_lodNodes[child].max_bounds);
+                }
+                m_lodChildren.push_back(child);
             }
-            m_blocks[i].min_bounds = bMin;
-            m_blocks[i].max_bounds = bMax;
+            _parents.push_back((uint32_t)m_lodNodes.size());
+            m_lodNodes.push_back(node);
+        }
+    };
+
+    std::vector<size_t> blockNodes(m_blocks.size() + 1);
+    std::vector<uint32_t> roots(m_blocks.size());
+    std::vector<uint32_t> level, parents;
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+        blockNodes[b] = m_lodNodes.size();
+        addLevel(m_blocks[b].indices, true, (int)b, level);
+        while (level.size() > 1) {
+            addLevel(level, false, (int)b, parents);
+            level.swap(parents);
+        }
+        roots[b] = level[0];
+    }
+    blockNodes[m_blocks.size()] = m_lodNodes.size();
+
+    // Blocks are the octree leaves in Morton order, so grouping consecutive
+    // roots keeps siblings above the block level spatially close
+    while (roots.size() > 1) {
+        addLevel(roots, false, -1, parents);
+        roots.swap(parents);
+    }
 
-            glGenQueries(1, &m_blocks[i].occlusionQuery);
-            packed.push_back(m_blocks[i]);
+    // One proxy per node, after the source splats
+    size_t total = m_lodProxyStart + m_lodNodes.size();
+    m_positions.resize(total);
+    m_scales.resize(total);
+    m_rotations.resize(total);
+    m_colors.resize(total);
+    m_shCoeffs.resize(total * shCoeffCount() * 3);
+
+    parallelFor(parallelThreads(m_blocks.size(), 16), m_blocks.size(), [&](size_t, size_t _start, size_t _end) {
+        for (size_t b = _start; b < _end; b++)
+            for (size_t n = blockNodes[b]; n < blockNodes[b + 1]; n++)
+                mergeLODNode(n);
+    });
+    for (size_t n = blockNodes[m_blocks.size()]; n < m_lodNodes.size(); n++)
+        mergeLODNode(n);
+
+    m_sortPreviousValid = false;
+    m_sortPositionsDirty = true;
+    m_hasSorted = false;
+    // Source splats are unchanged: only the proxy rows need uploading
+    updateTextureRows(m_lodProxyStart, m_positions.size());
+}
+
+void Gsplat::updateLOD(size_t _begin, size_t _end) {
+    if (m_lodNodes.empty() || _begin >= _end)
+        return;
+
+    // Nodes come after their children, so a single pass in node order
+    // reaches every ancestor of a touched leaf
+    std::vector<uint32_t> blockNodes, topNodes;
+    std::vector<uint8_t> dirty(m_lodNodes.size(), 0);
+    for (size_t n = 0; n < m_lodNodes.size(); n++) {
+        const SplatNode& node = m_lodNodes[n];
+        const uint32_t* children = m_lodChildren.data() + node.firstChild;
+        for (uint32_t k = 0; k < node.childCount && !dirty[n]; k++)
+            dirty[n] = node.leaf ? (children[k] >= _begin && children[k] < _end) : dirty[children[k]];
+        if (dirty[n])
+            (node.block >= 0 ? blockNodes : topNodes).push_back((uint32_t)n);
+    }
+
+    // Bounds first (the LOD cut culls with them), then the proxy
+    auto refitNode = [&](size_t _node) {
+        SplatNode& node = m_lodNodes[_node];
+        const uint32_t* children = m_lodChildren.data() + node.firstChild;
+        node.min_bounds = glm::vec3(std::numeric_limits<float>::max());
+        node.max_bounds = glm::vec3(std::numeric_limits<float>::lowest());
+        for (uint32_t k = 0; k < node.childCount; k++) {
+            if (node.leaf) {
+                node.min_bounds = glm::min(node.min_bounds, m_positions[children[k]]);
+                node.max_bounds = glm::max(node.max_bounds, m_positions[children[k]]);
+            }
+            else {
+                node.min_bounds = glm::min(node.min_bounds, m_lodNodes[children[k]].min_bounds);
+                node.max_bounds = glm::max(node.max_bounds, m_lodNodes[children[k]].max_bounds);
+            }
+        }
+        mergeLODNode(_node);
+    };
+
+    // A block's nodes are contiguous and only depend on each other, so
+    // blocks go in parallel, each in node order
+    std::vector<size_t> groups;
+    for (size_t k = 0; k < blockNodes.size(); k++)
+        if (k == 0 || m_lodNodes[blockNodes[k]].block != m_lodNodes[blockNodes[k - 1]].block)
+            groups.push_back(k);
+    groups.push_back(blockNodes.size());
+
+    size_t groupCount = groups.size() - 1;
+    parallelFor(parallelThreads(groupCount, 16), groupCount, [&](size_t, size_t _start, size_t _end) {
+        for (size_t g = _start; g < _end; g++)
+            for (size_t k = groups[g]; k < groups[g + 1]; k++)
+                refitNode(blockNodes[k]);
+    });
+    for (uint32_t n : topNodes)
+        refitNode(n);
+
+    // Upload the proxy rows right away, each run of neighbouring rows at
+    // once: the pending range (m_dirtyBegin/End) is a single span and
+    // would reach from the edited splats all the way to the root
+    size_t runBegin = 0, runEnd = 0;
+    auto upload = [&](uint32_t _node) {
+        size_t i = m_lodProxyStart + _node;
+        if (runEnd > runBegin && i < runEnd + SPLATS_PER_ROW) {
+            runEnd = i + 1;
+            return;
+        }
+        updateTextureRows(runBegin, runEnd);
+        runBegin = i;
+        runEnd = i + 1;
+    };
+    for (uint32_t n : blockNodes)
+        upload(n);
+    for (uint32_t n : topNodes)
+        upload(n);
+    updateTextureRows(runBegin, runEnd);
+
+    // Proxies are weighted by opacity and size, so any edit may move them
+    m_sortPositionsDirty = true;
+    m_hasSorted = false;
+}
+
+void Gsplat::mergeLODNode(size_t _node) {
+    const SplatNode& node = m_lodNodes[_node];
+    const uint32_t* children = m_lodChildren.data() + node.firstChild;
+    if (node.leaf) {
+        mergeSplats(children, node.childCount, m_lodProxyStart + _node);
+    }
+    else {
+        uint32_t proxies[8];
+        for (uint32_t k = 0; k < node.childCount; k++)
+            proxies[k] = (uint32_t)m_lodProxyStart + children[k];
+        mergeSplats(proxies, node.childCount, m_lodProxyStart + _node);
+    }
+}
+
+void Gsplat::dropLOD() {
+    if (m_lodNodes.empty())
+        return;
+
+    finishSort();
+
+    size_t n = m_lodProxyStart;
+    m_positions.resize(n);
+    m_scales.resize(n);
+    m_rotations.resize(n);
+    m_colors.resize(n);
+    m_shCoeffs.resize(n * shCoeffCount() * 3);
+
+    m_lodNodes.clear();
+    m_lodChildren.clear();
+    m_lodProxyStart = 0;
+
+    // The published order may point at proxies that are gone. Their texture
+    // rows can stay: nothing references them anymore.
+    m_sortPreviousValid = false;
+    m_sortPositionsDirty = true;
+    m_hasSorted = false;
+}
+
+// Moment-matched merge: the proxy has the weighted mean and covariance
+// (spread of the means included) of its inputs, weighted by opacity times
+// footprint, and the opacity that keeps that total coverage.
+void Gsplat::mergeSplats(const uint32_t* _splats, size_t _count, size_t _target) {
+    float weights[8];
+    float totalWeight = 0.0f;
+    glm::vec3 mean(0.0f);
+    for (size_t k = 0; k < _count; k++) {
+        uint32_t i = _splats[k];
+        const glm::vec3& s = m_scales[i];
+        float area = std::max(s.x * s.y, std::max(s.y * s.z, s.z * s.x)); // two largest axes
+        weights[k] = std::max((m_colors[i].a / 255.0f) * area, 1e-12f);
+        totalWeight += weights[k];
+        mean += weights[k] * m_positions[i];
+    }
+    mean /= totalWeight;
+
+    glm::mat3 cov(0.0f);
+    glm::vec3 color(0.0f);
+    for (size_t k = 0; k < _count; k++) {
+        uint32_t i = _splats[k];
+        glm::mat3 M = glm::mat3_cast(m_rotations[i]) * glm::mat3(
+            m_scales[i].x, 0.0f, 0.0f,
+            0.0f, m_scales[i].y, 0.0f,
+            0.0f, 0.0f, m_scales[i].z);
+        glm::vec3 d = m_positions[i] - mean;
+        cov += weights[k] * (M * glm::transpose(M) + glm::outerProduct(d, d));
+        color += weights[k] * glm::vec3(m_colors[i]);
+    }
+    cov /= totalWeight;
+    color /= totalWeight;
+
+    glm::vec3 values;
+    glm::mat3 axes;
+    symmetricEigen(cov, values, axes);
+    if (glm::determinant(axes) < 0.0f)
+        axes[2] = -axes[2];
+    glm::vec3 scale = glm::sqrt(glm::max(values, glm::vec3(1e-12f)));
+
+    glm::vec3 sorted = scale;
+    if (sorted.x > sorted.y) std::swap(sorted.x, sorted.y);
+    if (sorted.y > sorted.z) std::swap(sorted.y, sorted.z);
+    float alpha = glm::clamp(totalWeight / std::max(sorted.y * sorted.z, 1e-12f), 0.0f, 1.0f);
+
+    m_positions[_target] = mean;
+    m_scales[_target] = scale;
+    m_rotations[_target] = glm::normalize(glm::quat_cast(axes));
+    m_colors[_target] = glm::u8vec4(glm::clamp(color + 0.5f, 0.0f, 255.0f), alpha * 255.0f + 0.5f);
+
+    size_t stride = shCoeffCount() * 3;
+    for (size_t c = 0; c < stride; c++) {
+        float sh = 0.0f;
+        for (size_t k = 0; k < _count; k++)
+            sh += weights[k] * m_shCoeffs[_splats[k] * stride + c];
+        m_shCoeffs[_target * stride + c] = (uint8_t)glm::clamp(sh / totalWeight + 0.5f, 0.0f, 255.0f);
+    }
+}
+
+// Refines the tree largest-projected-error first, writing the splats and
+// proxies of the cut into _values. A node is drawn as its proxy when its
+// projected size drops under the error threshold, or when refining it
+// would push the cut over the splat budget.
+size_t Gsplat::cutLOD(const glm::mat4& _viewProj, float _viewportHeight, const Frustum& _frustum, uint32_t* _values) {
+    float M03 = _viewProj[0][3]; float M13 = _viewProj[1][3]; float M23 = _viewProj[2][3]; float M33 = _viewProj[3][3];
+
+    // Pixels covered by one world unit at unit depth (clip y row of viewProj)
+    float pixelScale = 0.5f * _viewportHeight * glm::length(glm::vec3(_viewProj[0][1], _viewProj[1][1], _viewProj[2][1]));
+
+    auto visible = [&](const SplatNode& _node) {
+        if (_node.block >= 0 && !m_sortVisible[_node.block])
+            return false;
+        return isBoxInFrustum(_node.min_bounds, _node.max_bounds, _frustum);
+    };
+
+    auto error = [&](const SplatNode& _node) {
+        glm::vec3 center = (_node.min_bounds + _node.max_bounds) * 0.5f;
+        float radius = 0.5f * glm::length(_node.max_bounds - _node.min_bounds);
+        float depth = M03 * center.x + M13 * center.y + M23 * center.z + M33;
+        // Reaches the camera plane: always refine
+        if (depth <= radius)
+            return std::numeric_limits<float>::max();
+        return radius * pixelScale / depth;
+    };
+
+    // Without a budget the refinement order doesn't matter: a plain
+    // depth-first walk (m_lodHeap used as a stack) skips the heap upkeep
+    bool budgeted = m_lodBudget > 0;
+    size_t budget = budgeted ? m_lodBudget : std::numeric_limits<size_t>::max();
+    size_t count = 0;
+
+    uint32_t root = (uint32_t)m_lodNodes.size() - 1;
+    if (!visible(m_lodNodes[root]))
+        return 0;
+
+    m_lodHeap.clear();
+    m_lodHeap.push_back(std::make_pair(error(m_lodNodes[root]), root));
+    size_t committed = 1;
+
+    while (!m_lodHeap.empty()) {
+        if (budgeted)
+            std::pop_heap(m_lodHeap.begin(), m_lodHeap.end());
+        float nodeError = m_lodHeap.back().first;
+        uint32_t n = m_lodHeap.back().second;
+        m_lodHeap.pop_back();
+
+        const SplatNode& node = m_lodNodes[n];
+        if (nodeError <= m_lodErrorThreshold || committed + node.childCount - 1 > budget) {
+            _values[count++] = (uint32_t)m_lodProxyStart + n;
+            continue;
+        }
+
+        committed += node.childCount - 1;
+        const uint32_t* children = m_lodChildren.data() + node.firstChild;
+        for (uint32_t k = 0; k < node.childCount; k++) {
+            if (node.leaf) {
+                _values[count++] = children[k];
+                continue;
+            }
+
+            const SplatNode& child = m_lodNodes[children[k]];
+            if (visible(child)) {
+                m_lodHeap.push_back(std::make_pair(error(child), children[k]));
+                if (budgeted)
+                    std::push_heap(m_lodHeap.begin(), m_lodHeap.end());
+            }
+            else {
+                committed--;
+            }
         }
     }
-    m_blocks = packed;
-    // std::cout << "Built Spatial Index: " << m_blocks.size() << " active blocks." << std::endl;
+
+    return count;
 }
 
 BoundingBox Gsplat::getBoundingBox() const {
@@ -1043,147 +3297,257 @@ BoundingBox Gsplat::getBoundingBox() const {
     return bbox;
 }
 
-void Gsplat::ensureOcclusionFbo(int _width, int _height) {
-    if (m_occlusionFbo != 0 && m_occlusionFboWidth == _width && m_occlusionFboHeight == _height)
-        return;
-
-    if (m_occlusionFbo == 0) {
-        glGenFramebuffers(1, &m_occlusionFbo);
-        glGenTextures(1, &m_occlusionDepthTex);
+void Gsplat::classifyOccluder(SplatBlock& _block) const {
+    glm::vec3 size = _block.max_bounds - _block.min_bounds;
+    float area = size.x * size.y + size.y * size.z + size.z * size.x;
+
+    // One standard deviation cross-section, across the two largest axes, and
+    // extent along each world axis (sqrt of the covariance diagonal)
+    float coverage = 0.0f;
+    glm::vec3 opaqueExtent(0.0f);
+    size_t opaque = 0;
+    _block.splatPadding = glm::vec3(0.0f);
+    for (uint32_t i : _block.indices) {
+        glm::mat3 R = glm::mat3_cast(m_rotations[i]);
+        glm::vec3 s = m_scales[i];
+        glm::vec3 extent = glm::sqrt(glm::vec3(
+            R[0][0] * R[0][0] * s.x * s.x + R[1][0] * R[1][0] * s.y * s.y + R[2][0] * R[2][0] * s.z * s.z,
+            R[0][1] * R[0][1] * s.x * s.x + R[1][1] * R[1][1] * s.y * s.y + R[2][1] * R[2][1] * s.z * s.z,
+            R[0][2] * R[0][2] * s.x * s.x + R[1][2] * R[1][2] * s.y * s.y + R[2][2] * R[2][2] * s.z * s.z));
+        _block.splatPadding = glm::max(_block.splatPadding, 3.0f * extent);
+
+        if (m_colors[i].a < SPLAT_OCCLUDER_ALPHA * 255.0f)
+            continue;
+        float smallest = std::min(s.x, std::min(s.y, s.z));
+        float largest = std::max(s.x, std::max(s.y, s.z));
+        float middle = s.x + s.y + s.z - smallest - largest;
+        coverage += glm::pi<float>() * middle * largest;
+        opaqueExtent += extent;
+        opaque++;
     }
 
-    m_occlusionFboWidth = _width;
-    m_occlusionFboHeight = _height;
+    _block.occluder = area > 0.0f && coverage >= SPLAT_OCCLUDER_COVERAGE * area;
+    // Splats reach past the bounds of their centers: without this, hulls of
+    // neighbouring blocks of a surface would leave cracks between them. It
+    // stays well within splatPadding, which the tested bounds get, so a
+    // block's own splats never end up behind its neighbours' hulls.
+    _block.occluderPadding = opaque > 0 ? opaqueExtent / (float)opaque : glm::vec3(0.0f);
+}
 
-    glBindTexture(GL_TEXTURE_2D, m_occlusionDepthTex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, _width, _height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+// Occluder hulls (block bounds scaled by m_occlusionScale and padded by the
+// typical extent of their splats, front faces only) are rasterized into a
+// SPLAT_OCCLUSION_WIDTH x HEIGHT NDC depth buffer, one horizontal band of
+// tiles per thread. Then the octree is walked, testing bounds padded by the
+// full extent of their splats: a node behind the buffer hides all its blocks
+// at once, and each test first compares against the farthest depth of every
+// tile it overlaps, only reading the pixels of tiles that don't settle it.
+void Gsplat::occludeBlocks(const glm::mat4& _viewProj, std::vector<uint8_t>& _visible, std::vector<uint8_t>& _occluded) {
+    const int width = SPLAT_OCCLUSION_WIDTH;
+    const int height = SPLAT_OCCLUSION_HEIGHT;
+    const int tile = SPLAT_OCCLUSION_TILE;
+    const int tilesX = width / tile;
+    const int tilesY = height / tile;
+    const SplatOcclusionKernels& kernels = occlusionKernels();
+
+    // Buffer pixels (x, y) and NDC depth (z) of a point, false behind the near plane
+    auto project = [&](const glm::vec3& _p, glm::vec3& _out) {
+        glm::vec4 clip = _viewProj * glm::vec4(_p, 1.0f);
+        if (clip.w <= 0.0f || clip.z < -clip.w)
+            return false;
+        _out = glm::vec3((clip.x / clip.w * 0.5f + 0.5f) * width,
+                         (clip.y / clip.w * 0.5f + 0.5f) * height,
+                         clip.z / clip.w);
+        return true;
+    };
 
-    glBindFramebuffer(GL_FRAMEBUFFER, m_occlusionFbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_occlusionDepthTex, 0);
-    // Depth-only: no color attachment, so the default draw/read buffer (which
-    // expects COLOR_ATTACHMENT0) must be explicitly turned off for the FBO
-    // to be considered complete.
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
+    // Hull corners of the occluders in view (corner k at bit 0/1/2 of k on
+    // x/y/z), skipping the ones reaching behind the near plane
+    std::vector<glm::vec3> corners;
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+        const SplatBlock& block = m_blocks[b];
+        if (!_visible[b] || !block.occluder)
+            continue;
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
+        glm::vec3 center = (block.min_bounds + block.max_bounds) * 0.5f;
+        glm::vec3 half = (block.max_bounds - block.min_bounds) * 0.5f * m_occlusionScale + block.occluderPadding;
+        glm::vec3 projected[8];
+        bool inFront = true;
+        for (int k = 0; k < 8 && inFront; k++) {
+            glm::vec3 corner = center + half * glm::vec3((k & 1) ? 1.0f : -1.0f, (k & 2) ? 1.0f : -1.0f, (k & 4) ? 1.0f : -1.0f);
+            inFront = project(corner, projected[k]);
+        }
+        if (inFront)
+            corners.insert(corners.end(), projected, projected + 8);
+    }
 
-void Gsplat::performOcclusionQuery(const glm::mat4& _viewProj) {
-    if (m_blocks.empty()) return;
+    m_occlusionHiddenSorts.resize(m_blocks.size(), 0);
+    size_t occluders = corners.size() / 8;
+    if (occluders == 0) {
+        std::fill(m_occlusionHiddenSorts.begin(), m_occlusionHiddenSorts.end(), 0);
+        return;
+    }
 
-    Frustum frustum = extractFrustum(_viewProj);
+    // Counter-clockwise seen from outside
+    static const int faces[6][4] = {
+        { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 },
+        { 2, 6, 7, 3 }, { 0, 2, 3, 1 }, { 4, 5, 7, 6 } };
+
+    // Pixels whose center is inside the triangle, rows [_y0, _y1)
+    auto rasterize = [&](const glm::vec3& _a, const glm::vec3& _b, const glm::vec3& _c, int _y0, int _y1) {
+        float area = (_b.x - _a.x) * (_c.y - _a.y) - (_b.y - _a.y) * (_c.x - _a.x);
+        if (!(area > 0.0f))
+            return;
+        float dzdx = ((_b.z - _a.z) * (_c.y - _a.y) - (_b.y - _a.y) * (_c.z - _a.z)) / area;
+        float dzdy = ((_b.x - _a.x) * (_c.z - _a.z) - (_b.z - _a.z) * (_c.x - _a.x)) / area;
+
+        float minY = std::min(_a.y, std::min(_b.y, _c.y));
+        float maxY = std::max(_a.y, std::max(_b.y, _c.y));
+        int rowStart = (int)glm::clamp(std::ceil(minY - 0.5f), (float)_y0, (float)_y1);
+        int rowEnd = (int)glm::clamp(std::floor(maxY - 0.5f) + 1.0f, (float)_y0, (float)_y1);
+
+        const glm::vec3* v[3] = { &_a, &_b, &_c };
+        for (int y = rowStart; y < rowEnd; y++) {
+            float yc = y + 0.5f;
+            // Inside: left of every edge, each one bounding x on one side
+            float left = 0.0f, right = (float)width;
+            for (int e = 0; e < 3; e++) {
+                const glm::vec3& p = *v[e];
+                const glm::vec3& q = *v[(e + 1) % 3];
+                float slope = p.y - q.y;
+                float offset = (q.x - p.x) * (yc - p.y) + (q.y - p.y) * p.x;
+                if (slope > 0.0f)
+                    left = std::max(left, -offset / slope);
+                else if (slope < 0.0f)
+                    right = std::min(right, -offset / slope);
+                else if (offset < 0.0f)
+                    right = left;
+            }
 
-    // 1. Check previous frame results - THIS UPDATES OCCLUSION STATE
-    for (auto& block : m_blocks) {
-        if (block.occlusionQuery == 0 || !block.queryIssued) continue;
-        
-        GLuint result = 0;
-        GLuint available = 0;
-        glGetQueryObjectuiv(block.occlusionQuery, GL_QUERY_RESULT_AVAILABLE, &available);
-        if (available) {
-            glGetQueryObjectuiv(block.occlusionQuery, GL_QUERY_RESULT, &result);
-            
-            if (result == 0) {
-                block.framesHidden++;
-                // Require N consecutive hidden frames to mark as occluded (Hysteresis)
-                if (block.framesHidden > m_occlusionThreshold) {
-                    block.occluded = true;
-                }
-            } else {
-                block.framesHidden = 0;
-                block.occluded = false; // Immediately visible
+            int x0 = (int)glm::clamp(std::ceil(left - 0.5f), 0.0f, (float)width);
+            int x1 = (int)glm::clamp(std::floor(right - 0.5f) + 1.0f, 0.0f, (float)width);
+            if (x0 < x1) {
+                float z = _a.z + dzdx * (0.5f - _a.x) + dzdy * (yc - _a.y);
+                kernels.write(m_occlusionDepth.data() + (size_t)y * width, x0, x1, z, dzdx);
             }
         }
-    }
+    };
 
-    // Save state
-    GLboolean colorMask[4];
-    glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
-    GLboolean depthMask;
-    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
-    GLboolean depthTest;
-    glGetBooleanv(GL_DEPTH_TEST, &depthTest);
-    GLint depthFunc;
-    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
-
-    // Redirect to a private depth-only FBO: these are coarse, shrunk
-    // block-shaped occluder proxies, purely a heuristic for next frame's
-    // culling decisions. Writing them into whatever depth buffer is actually
-    // bound (e.g. the main scene's, backing u_sceneDepth) would visibly
-    // show up as blocky artifacts wherever a proxy is nearer than the real,
-    // per-splat depth from renderDepth().
-    GLint prevFbo = 0;
-    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
-    GLint prevViewport[4];
-    glGetIntegerv(GL_VIEWPORT, prevViewport);
-
-    ensureOcclusionFbo(prevViewport[2], prevViewport[3]);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_occlusionFbo);
-    glViewport(0, 0, prevViewport[2], prevViewport[3]);
-    glClear(GL_DEPTH_BUFFER_BIT);
-
-    // Filter visible blocks for depth pre-pass
-    std::vector<SplatBlock*> visibleBlocks;
-    visibleBlocks.reserve(m_blocks.size());
-    for (auto& block : m_blocks) {
-        if (!block.occluded && isBoxInFrustum(block.min_bounds, block.max_bounds, frustum)) {
-            visibleBlocks.push_back(&block);
-        }
-    }
-
-    vera::fill(255);
-    vera::noStroke();
-
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    m_occlusionDepth.assign((size_t)width * height, std::numeric_limits<float>::max());
+    m_occlusionTileMax.resize((size_t)tilesX * tilesY);
+    parallelFor(std::min(parallelThreads(occluders, 64), (size_t)tilesY), tilesY, [&](size_t, size_t _start, size_t _end) {
+        int y0 = (int)_start * tile;
+        int y1 = (int)_end * tile;
+        for (size_t o = 0; o < occluders; o++) {
+            const glm::vec3* c = corners.data() + o * 8;
+            float minY = c[0].y, maxY = c[0].y;
+            for (int k = 1; k < 8; k++) {
+                minY = std::min(minY, c[k].y);
+                maxY = std::max(maxY, c[k].y);
+            }
+            if (maxY < y0 || minY > y1)
+                continue;
 
-    // PASS 1: Fill Depth Buffer with Occluders (Visible Blocks)
-    glDepthMask(GL_TRUE);
+            for (const auto& f : faces) {
+                rasterize(c[f[0]], c[f[1]], c[f[2]], y0, y1);
+                rasterize(c[f[0]], c[f[2]], c[f[3]], y0, y1);
+            }
+        }
 
-    for (auto* block : visibleBlocks) {
-        glm::vec3 center = (block->min_bounds + block->max_bounds) * 0.5f;
-        glm::vec3 size = block->max_bounds - block->min_bounds;
-        glm::vec3 shrinkSize = size * m_occlusionScale;
+        for (int ty = (int)_start; ty < (int)_end; ty++) {
+            for (int tx = 0; tx < tilesX; tx++) {
+                float farthest = 0.0f;
+                for (int y = ty * tile; y < (ty + 1) * tile; y++) {
+                    const float* row = m_occlusionDepth.data() + (size_t)y * width + tx * tile;
+                    for (int x = 0; x < tile; x++)
+                        farthest = std::max(farthest, row[x]);
+                }
+                m_occlusionTileMax[ty * tilesX + tx] = farthest;
+            }
+        }
+    });
 
-        vera::push();
-        vera::translate(center);
-        vera::scale(shrinkSize);
-        vera::box(1.0f);
-        vera::pop();
-    }
+    // Bounds reaching behind the near plane or off the buffer are never hidden
+    auto hidden = [&](const glm::vec3& _min, const glm::vec3& _max) {
+        glm::vec3 lo(std::numeric_limits<float>::max());
+        glm::vec3 hi(std::numeric_limits<float>::lowest());
+        for (int k = 0; k < 8; k++) {
+            glm::vec3 corner((k & 1) ? _max.x : _min.x, (k & 2) ? _max.y : _min.y, (k & 4) ? _max.z : _min.z);
+            glm::vec3 p;
+            if (!project(corner, p))
+                return false;
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
+        if (hi.x < 0.0f || lo.x >= width || hi.y < 0.0f || lo.y >= height)
+            return false;
 
-    // PASS 2: Issue Queries for All Blocks
-    glDepthMask(GL_FALSE); // Read-only depth
+        int x0 = (int)std::max(lo.x, 0.0f);
+        int x1 = (int)std::min(hi.x, width - 1.0f);
+        int y0 = (int)std::max(lo.y, 0.0f);
+        int y1 = (int)std::min(hi.y, height - 1.0f);
+        float nearest = lo.z;
+        for (int ty = y0 / tile; ty <= y1 / tile; ty++) {
+            for (int tx = x0 / tile; tx <= x1 / tile; tx++) {
+                if (m_occlusionTileMax[ty * tilesX + tx] < nearest)
+                    continue;
+
+                int rowStart = std::max(y0, ty * tile), rowEnd = std::min(y1 + 1, (ty + 1) * tile);
+                int colStart = std::max(x0, tx * tile), colEnd = std::min(x1 + 1, (tx + 1) * tile);
+                for (int y = rowStart; y < rowEnd; y++)
+                    if (!kernels.hidden(m_occlusionDepth.data() + (size_t)y * width, colStart, colEnd, nearest))
+                        return false;
+            }
+        }
+        return true;
+    };
 
-    for (auto& block : m_blocks) {
-        if (block.occlusionQuery == 0) continue;
+    // Children always come after their parent
+    std::vector<glm::vec3> padding(m_octree.size());
+    for (size_t n = m_octree.size(); n-- > 0;) {
+        const SplatOctreeNode& node = m_octree[n];
+        if (node.childCount == 0) {
+            padding[n] = m_blocks[node.firstBlock].splatPadding;
+            continue;
+        }
+        padding[n] = padding[node.firstChild];
+        for (uint32_t k = 1; k < node.childCount; k++)
+            padding[n] = glm::max(padding[n], padding[node.firstChild + k]);
+    }
 
-        glm::vec3 center = (block.min_bounds + block.max_bounds) * 0.5f;
-        glm::vec3 size = block.max_bounds - block.min_bounds;
+    std::vector<uint8_t> hiddenNow(m_blocks.size(), 0);
+    uint32_t stack[128];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t n = stack[--top];
+        const SplatOctreeNode& node = m_octree[n];
+
+        const uint8_t* visible = _visible.data() + node.firstBlock;
+        if (std::find(visible, visible + node.blockCount, 1) == visible + node.blockCount)
+            continue;
+
+        if (hidden(node.min_bounds - padding[n], node.max_bounds + padding[n])) {
+            std::memset(hiddenNow.data() + node.firstBlock, 1, node.blockCount);
+            continue;
+        }
 
-        glBeginQuery(GL_ANY_SAMPLES_PASSED, block.occlusionQuery);
-        vera::push();
-        vera::translate(center);
-        vera::scale(size);
-        vera::box(1.0f);
-        vera::pop();
-        glEndQuery(GL_ANY_SAMPLES_PASSED);
-        block.queryIssued = true;
+        for (uint32_t k = 0; k < node.childCount; k++)
+            stack[top++] = node.firstChild + k;
     }
 
-    // Restore state
-    glBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
-    glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
-    glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
-    glDepthMask(depthMask);
-    glDepthFunc(depthFunc);
-    if (!depthTest) glDisable(GL_DEPTH_TEST);
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+        uint8_t& sorts = m_occlusionHiddenSorts[b];
+        if (!_visible[b] || !hiddenNow[b]) {
+            sorts = 0;
+            continue;
+        }
+
+        sorts = (uint8_t)std::min(sorts + 1, 255);
+        if (sorts > m_occlusionThreshold) {
+            _visible[b] = 0;
+            _occluded[b] = 1;
+        }
+    }
 }
 
 Frustum Gsplat::extractFrustum(const glm::mat4& _viewProj) const {
@@ -1290,174 +3654,310 @@ bool Gsplat::isBoxInFrustum(const glm::vec3& min, const glm::vec3& max, const gl
 }
 */
 
-void Gsplat::sort(const glm::mat4& _viewProj) {
-    m_sorter.clear();
-    // Reserve to avoid reallocs
-    m_sorter.reserve(m_positions.size()); 
-    
+void Gsplat::sort(const glm::mat4& _viewProj, float _viewportHeight) {
+    // No single view's occlusion holds for all views of a multi-view frame
+    computeOrder(_viewProj, _viewportHeight, s_multiViewFrame == 0, m_sortOrder, m_sortOccluded);
+    publishOrder(m_sortOrder);
+    m_occludedBlocks.swap(m_sortOccluded);
+}
+
+void Gsplat::computeOrder(const glm::mat4& _viewProj, float _viewportHeight, bool _occlusion, std::vector<uint32_t>& _order, std::vector<uint8_t>& _occluded) {
+    // Preallocated to the full splat count: no per-sort reallocation
+    size_t n = m_positions.size();
+    if (m_sortDepths.size() < n) {
+        m_sortDepths.resize(n);
+        m_sortDepthsTmp.resize(n);
+        m_sortKeys.resize(n);
+        m_sortValues.resize(n);
+        m_sortKeysTmp.resize(n);
+        m_sortValuesTmp.resize(n);
+    }
+    m_sortSlot.resize(n, 0);
+    float*      depths = m_sortDepths.data();
+    uint32_t*   values = m_sortValues.data();
+    size_t      count = 0;
+
+    // SoA copy of the positions for the depth kernel
+    if (m_sortPositionsDirty || m_sortX.size() != n) {
+        m_sortX.resize(n);
+        m_sortY.resize(n);
+        m_sortZ.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            m_sortX[i] = m_positions[i].x;
+            m_sortY[i] = m_positions[i].y;
+            m_sortZ[i] = m_positions[i].z;
+        }
+        m_sortPositionsDirty = false;
+    }
+
     // Extract FRUSTUM
     Frustum frustum = extractFrustum(_viewProj);
 
     // View Proj Matrix components for depth calculation (using w_clip as depth approximation)
     float M03 = _viewProj[0][3]; float M13 = _viewProj[1][3]; float M23 = _viewProj[2][3]; float M33 = _viewProj[3][3];
 
-    // If no blocks (e.g. failed load), fallback to all
-    if (m_blocks.empty()) {
-        size_t vertexCount = m_positions.size();
-        for (uint32_t i = 0; i < vertexCount; i++) {
-            float x = m_positions[i].x;
-            float y = m_positions[i].y; 
-            float z = m_positions[i].z;
-            
-            // Use w_clip as depth. (Distance from camera plane approx)
-            float depth = M03 * x + M13 * y + M23 * z + M33;
-            
-            m_sorter.push_back({depth, i});
+    SplatClipRows clip;
+    for (int c = 0; c < 4; c++) {
+        clip.x[c] = _viewProj[c][0];
+        clip.y[c] = _viewProj[c][1];
+        clip.z[c] = _viewProj[c][2];
+        clip.w[c] = _viewProj[c][3];
+    }
+    SplatCullKernel kernel = cullKernel();
+
+    // Block-based culling: frustum, then occlusion
+    cullBlocks(frustum, m_sortVisible);
+    _occluded.assign(m_blocks.size(), 0);
+    if (_occlusion)
+        occludeBlocks(_viewProj, m_sortVisible, _occluded);
+
+    // Depths and indices of the splats of visible blocks that pass the clip
+    // test. Blocks are runs of consecutive splats once the layout is
+    // optimized, read straight from the SoA arrays (gathered otherwise).
+    auto cullVisible = [&](float* _depths, uint32_t* _values) {
+        if (m_blocks.empty())
+            return kernel(m_sortX.data(), m_sortY.data(), m_sortZ.data(), nullptr, 0, n, clip, _depths, _values);
+
+        size_t visible = 0;
+        for (size_t b = 0; b < m_blocks.size(); b++) {
+            if (!m_sortVisible[b])
+                continue;
+
+            const std::vector<uint32_t>& indices = m_blocks[b].indices;
+            visible += kernel(m_sortX.data(), m_sortY.data(), m_sortZ.data(),
+                              m_blocksContiguous ? nullptr : indices.data(), indices[0], indices.size(),
+                              clip, _depths + visible, _values + visible);
+        }
+        return visible;
+    };
+
+    // Between consecutive frames the order barely changes: start from the
+    // previous one, minus splats that dropped out of view, plus the ones that
+    // came into view (appended, the repair pass moves them into place).
+    // (Not with LOD: the cut changes which splats/proxies are drawn.)
+    bool lod = !m_lodNodes.empty();
+    bool coherent = !lod && m_incrementalSort && m_sortPreviousValid;
+
+    // Dense captures reorder a lot even under small camera moves (depth gaps
+    // between neighbours are tiny), so first estimate the disorder on a
+    // sample of neighbouring pairs of the previous order, and go straight to
+    // the full sort without paying for the gather below when it's too high.
+    if (coherent && m_sortPrevious.size() > 1) {
+        size_t pairs = std::min((size_t)4096, m_sortPrevious.size() - 1);
+        size_t stride = (m_sortPrevious.size() - 1) / pairs;
+        // With 16-bit keys, pairs closer than one quantization step tie anyway
+        float tolerance = (m_sortKey == SORT_KEY_16BITS) ? m_sortDepthRange / 65535.0f : 0.0f;
+        size_t descents = 0;
+        for (size_t k = 0; k < pairs; k++) {
+            const glm::vec3& a = m_positions[m_sortPrevious[k * stride]];
+            const glm::vec3& b = m_positions[m_sortPrevious[k * stride + 1]];
+            float depthA = M03 * a.x + M13 * a.y + M23 * a.z + M33;
+            float depthB = M03 * b.x + M13 * b.y + M23 * b.z + M33;
+            // Back-to-front: depth should not increase
+            if (depthB > depthA + tolerance)
+                descents++;
         }
-    } else {
-        // Block-based Culling
-        for (auto& block : m_blocks) {
-            bool visible = isBoxInFrustum(block.min_bounds, block.max_bounds, frustum);
-            
-            // Check Occlusion Result
-            if (visible && block.occlusionQuery != 0 && block.queryIssued) {
-                 GLuint available = 0;
-                 glGetQueryObjectuiv(block.occlusionQuery, GL_QUERY_RESULT_AVAILABLE, &available);
-                 if (available) {
-                     GLuint samples = 0;
-                     glGetQueryObjectuiv(block.occlusionQuery, GL_QUERY_RESULT, &samples);
-                     if (samples == 0) {
-                         block.occluded = true;
-                         visible = false; // Aggressively cull
-                     } else {
-                         block.occluded = false;
-                     }
-                 } else {
-                    // Result not ready, use previous state or assume visible
-                    if (block.occluded) visible = false;
-                 }
+        coherent = descents <= pairs * m_incrementalSortThreshold;
+    }
+
+    if (lod) {
+        // Clip test in place over the cut
+        count = cutLOD(_viewProj, _viewportHeight, frustum, values);
+        count = kernel(m_sortX.data(), m_sortY.data(), m_sortZ.data(), values, 0, count, clip, depths, values);
+    }
+    else if (coherent) {
+        // m_sortSlot maps each candidate splat to its slot + 1 (0 elsewhere,
+        // and back to all zeros once both passes below consumed it)
+        float* candidateDepths = m_sortDepthsTmp.data();
+        uint32_t* candidates = m_sortValuesTmp.data();
+        size_t candidateCount = cullVisible(candidateDepths, candidates);
+        for (size_t k = 0; k < candidateCount; k++)
+            m_sortSlot[candidates[k]] = (uint32_t)k + 1;
+
+        for (uint32_t i : m_sortPrevious) {
+            uint32_t slot = m_sortSlot[i];
+            if (slot) {
+                depths[count] = candidateDepths[slot - 1];
+                values[count++] = i;
+                m_sortSlot[i] = 0;
             }
-            
-            if (visible) {
-                // Optimization: get pointers to data
-                const uint32_t* indices = block.indices.data();
-                size_t idxCount = block.indices.size();
-                
-                for (size_t k = 0; k < idxCount; k++) {
-                    uint32_t i = indices[k];
-                    // Direct access to local position (assuming model matrix handles transform)
-                    float x = m_positions[i].x;
-                    float y = m_positions[i].y;
-                    float z = m_positions[i].z;
-                    
-                    float depth = M03 * x + M13 * y + M23 * z + M33;
-                    m_sorter.push_back({depth, i});
-                }
+        }
+
+        for (size_t k = 0; k < candidateCount; k++) {
+            uint32_t i = candidates[k];
+            if (m_sortSlot[i]) {
+                depths[count] = candidateDepths[k];
+                values[count++] = i;
+                m_sortSlot[i] = 0;
             }
         }
     }
-    
+    else {
+        count = cullVisible(depths, values);
+    }
+
     // Sort by depth (Back-to-Front)
     // Painter's Algo: Draw Farthest First.
-    if (m_sorter.size() > 1000) {
-        radixSort(m_sorter); 
-    } else {
-        std::sort(m_sorter.begin(), m_sorter.end(),
-            [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
-    }
+    int keyBits = buildSortKeys(count);
+    if (!coherent || !repairOrder(count))
+        radixSort(count, keyBits);
 
-    size_t sortedCount = m_sorter.size();
+    _order.assign(m_sortValues.begin(), m_sortValues.begin() + count);
 
-    if (m_shader) {
-        if (m_shader->getVersion() >= 300) {
-            // Use integer indices for modern OpenGL
-            if (m_depthUintIndex.size() != sortedCount)
-                m_depthUintIndex.resize(sortedCount);
+    m_sortPrevious.assign(m_sortValues.begin(), m_sortValues.begin() + count);
+    m_sortPreviousValid = true;
+}
 
-            for (size_t i = 0; i < sortedCount; i++)
-                m_depthUintIndex[i] = m_sorter[i].second;
-        }
-        else {
-            // Use float indices for older OpenGL
-            if (m_depthFloatIndex.size() != sortedCount)
-                m_depthFloatIndex.resize(sortedCount);
+int Gsplat::buildSortKeys(size_t _count) {
+    // Keys are built inverted so that ascending key order already is
+    // back-to-front (no reverse pass needed after the radix sort).
+    const float* depths = m_sortDepths.data();
+    uint32_t* keys = m_sortKeys.data();
+    size_t nThreads = parallelThreads(_count, 65536);
+
+    if (m_sortKey == SORT_KEY_16BITS) {
+        std::vector<float> minD(nThreads, std::numeric_limits<float>::max());
+        std::vector<float> maxD(nThreads, std::numeric_limits<float>::lowest());
+        parallelFor(nThreads, _count, [&](size_t t, size_t start, size_t end) {
+            for (size_t i = start; i < end; i++) {
+                minD[t] = std::min(minD[t], depths[i]);
+                maxD[t] = std::max(maxD[t], depths[i]);
+            }
+        });
+        float nearest = *std::min_element(minD.begin(), minD.end());
+        float farthest = *std::max_element(maxD.begin(), maxD.end());
+        float scale = (farthest > nearest) ? 65535.0f / (farthest - nearest) : 0.0f;
+        m_sortDepthRange = std::max(farthest - nearest, 0.0f);
+
+        parallelFor(nThreads, _count, [&](size_t t, size_t start, size_t end) {
+            for (size_t i = start; i < end; i++)
+                keys[i] = (uint32_t)glm::clamp((farthest - depths[i]) * scale, 0.0f, 65535.0f);
+        });
+        return 16;
+    }
+
+    parallelFor(nThreads, _count, [&](size_t t, size_t start, size_t end) {
+        for (size_t i = start; i < end; i++)
+            keys[i] = ~floatToSortable(depths[i]);
+    });
+    return 32;
+}
 
-            for (size_t i = 0; i < sortedCount; i++)
-                m_depthFloatIndex[i] = static_cast<float>(m_sorter[i].second);
+bool Gsplat::repairOrder(size_t _count) {
+    uint32_t* keys = m_sortKeys.data();
+    uint32_t* values = m_sortValues.data();
+
+    // Estimate the disorder by the number of out-of-order neighbours
+    size_t descents = 0;
+    for (size_t i = 1; i < _count; i++)
+        if (keys[i] < keys[i - 1])
+            descents++;
+
+    if (descents == 0)
+        return true;
+
+    if (descents > _count * m_incrementalSortThreshold)
+        return false;
+
+    // Insertion sort is O(n + inversions). Cap the total element moves
+    // around what a full radix sort would cost and bail out past that.
+    size_t budget = _count * 4;
+    size_t moves = 0;
+    for (size_t i = 1; i < _count; i++) {
+        uint32_t key = keys[i];
+        if (key >= keys[i - 1])
+            continue;
+
+        uint32_t value = values[i];
+        size_t j = i;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j] = keys[j - 1];
+            values[j] = values[j - 1];
+            j--;
         }
+        keys[j] = key;
+        values[j] = value;
+
+        moves += i - j;
+        if (moves > budget)
+            return false;
     }
+
+    return true;
 }
 
-// Radix sort implementation
-void Gsplat::radixSort(std::vector<std::pair<float, uint32_t>>& arr) {
-    if (arr.empty()) return;
+void Gsplat::publishOrder(std::vector<uint32_t>& _order) {
+    // Swap rather than copy: the previous front buffer becomes the next
+    // scratch order. The float index (GLSL < 300) is derived lazily on upload.
+    m_depthUintIndex.swap(_order);
+    m_depthFloatIndex.clear();
+    m_indexDirty = true;
+}
+
+// Parallel LSD radix sort, 8 bits per pass: every thread histograms its own
+// contiguous slice, a prefix scan over (digit, thread) turns those into
+// per-thread write offsets, and every thread scatters its slice -- stable,
+// so later passes keep the order of earlier ones. Ping-pongs between
+// m_sortKeys/Values and their persistent *Tmp scratch buffers.
+void Gsplat::radixSort(size_t _count, int _keyBits) {
+    if (_count < 2)
+        return;
+
+    size_t nThreads = parallelThreads(_count, 65536);
+    std::vector<size_t> histograms(nThreads * 256);
+
+    uint32_t* keysIn = m_sortKeys.data();
+    uint32_t* valuesIn = m_sortValues.data();
+    uint32_t* keysOut = m_sortKeysTmp.data();
+    uint32_t* valuesOut = m_sortValuesTmp.data();
+
+    for (int shift = 0; shift < _keyBits; shift += 8) {
+        std::fill(histograms.begin(), histograms.end(), 0);
 
-    size_t n = arr.size();
-    std::vector<std::pair<float, uint32_t>> buffer(n);
-    
-    // We treat the float key as uint32 to sort (handling sign bit if necessary, 
-    // but assuming positive depth for simplicity or standard float sort tricks)
-    // For sorting floats: 
-    // - Positive floats sort correctly as uints
-    // - Negative floats are reversed 
-    // Here we likely deal with positive depths in view space (z < 0 usually but we sort by distance or -z)
-    
-    // 3 passes for 11 bits each? Or 4 passes of 8 bits. 4 passes is standard for 32-bit.
-    
-    std::pair<float, uint32_t>* input = arr.data();
-    std::pair<float, uint32_t>* output = buffer.data();
-    
-    for (int shift = 0; shift < 32; shift += 8) {
-        size_t count[256] = {0};
-        
         // Histogram
-        for (size_t i = 0; i < n; i++) {
-            uint32_t f_bits;
-            std::memcpy(&f_bits, &input[i].first, 4);
-            
-            // Flip sign bit for correct float sorting if needed
-            // if (f_bits & 0x80000000) f_bits = ~f_bits; 
-            // else f_bits |= 0x80000000; 
-            // Simplification: We assume we sort by projected w or z which is generally > 0
-            
-            count[(f_bits >> shift) & 0xFF]++;
-        }
-        
-        // Prefix sum
-        size_t start[256];
+        parallelFor(nThreads, _count, [&](size_t t, size_t start, size_t end) {
+            size_t* count = &histograms[t * 256];
+            for (size_t i = start; i < end; i++)
+                count[(keysIn[i] >> shift) & 0xFF]++;
+        });
+
+        // Prefix sum, digit-major then thread-major. A pass where every key
+        // shares the same digit wouldn't move anything: skip it.
+        bool trivial = false;
         size_t total = 0;
-        for (int i = 0; i < 256; i++) { // Normal order for Ascending? 
-            // We want Back-to-Front (Descending sort)
-            // So we can compute prefix sum backwards?
-            // Or just sort Ascending and iterate backwards later?
-            // Let's standard Ascending sort first.
-            start[i] = total;
-            total += count[i];
+        for (size_t d = 0; d < 256; d++) {
+            size_t digitTotal = 0;
+            for (size_t t = 0; t < nThreads; t++) {
+                size_t c = histograms[t * 256 + d];
+                histograms[t * 256 + d] = total;
+                total += c;
+                digitTotal += c;
+            }
+            if (digitTotal == _count)
+                trivial = true;
         }
-        
+        if (trivial)
+            continue;
+
         // Reorder
-        for (size_t i = 0; i < n; i++) {
-            uint32_t f_bits;
-            std::memcpy(&f_bits, &input[i].first, 4);
-            size_t pos = start[(f_bits >> shift) & 0xFF]++;
-            output[pos] = input[i];
-        }
-        
-        std::swap(input, output);
+        parallelFor(nThreads, _count, [&](size_t t, size_t start, size_t end) {
+            size_t* offset = &histograms[t * 256];
+            for (size_t i = start; i < end; i++) {
+                size_t pos = offset[(keysIn[i] >> shift) & 0xFF]++;
+                keysOut[pos] = keysIn[i];
+                valuesOut[pos] = valuesIn[i];
+            }
+        });
+
+        std::swap(keysIn, keysOut);
+        std::swap(valuesIn, valuesOut);
     }
-    
-    // Since we want Descending (Back-to-Front), and Radix sorts Ascending,
-    // we just need to read the result in reverse, OR flip the logic.
-    // However, since we write to GL buffers, best to have the vector sorted correctly.
-    // Reversing the vector is cheap-ish or we can invert the key.
-    
-    // Result is in 'input' (which might be arr or buffer)
-    if (input != arr.data()) {
-        std::memcpy((void*)arr.data(), (const void*)buffer.data(), n * sizeof(std::pair<float, uint32_t>));
+
+    // Result must end up in m_sortKeys/m_sortValues
+    if (keysIn != m_sortKeys.data()) {
+        std::memcpy(m_sortKeys.data(), keysIn, _count * sizeof(uint32_t));
+        std::memcpy(m_sortValues.data(), valuesIn, _count * sizeof(uint32_t));
     }
-    
-    // Reverse for Back-to-front
-    std::reverse(arr.begin(), arr.end());
 }
 
 
@@ -1471,16 +3971,10 @@ void Gsplat::render(Camera* _camera, glm::mat4 _model, bool _sort) {
     // Sort splats by depth. Note: we deliberately don't rely on
     // _camera->bChange here (see ensureSorted()).
     glm::mat4 viewProj = _camera->getProjectionMatrix() * _camera->getViewMatrix() * _model;
-    ensureSorted(viewProj, _sort);
+    ensureSorted(viewProj, _model, _camera->getViewport().w, _sort);
 
     // Update index buffer
-    glBindBuffer(GL_ARRAY_BUFFER, m_indexVBO);
-    if (m_shader->getVersion() >= 300) {
-        glBufferData(GL_ARRAY_BUFFER, m_depthUintIndex.size() * sizeof(uint32_t), m_depthUintIndex.data(), GL_STREAM_DRAW);
-    }
-    else {
-        glBufferData(GL_ARRAY_BUFFER, m_depthFloatIndex.size() * sizeof(float), m_depthFloatIndex.data(), GL_DYNAMIC_DRAW);
-    }
+    uploadIndexBuffer(m_shader->getVersion());
 
     m_shader->use();
 
@@ -1512,6 +4006,18 @@ void Gsplat::render(Camera* _camera, glm::mat4 _model, bool _sort) {
     m_shader->setUniform("u_focal", glm::vec2(fx, fy));
 
     if (m_shader->getVersion() >= 300) {
+        // View-dependent color: the shader evaluates SH against the direction
+        // from the camera to each splat, both in model space
+        int shDegree = m_shTexture ? std::min(m_shDegree, m_shMaxDegree) : 0;
+        m_shader->setUniform("u_gsplatSHDegree", shDegree);
+        if (shDegree > 0) {
+            m_shader->setUniformTexture("u_gsplatSHTex", m_shTexture, 1);
+            m_shader->setUniform("u_gsplatSHStride", (int)(m_shTexture->getWidth() / 1024));
+            m_shader->setUniform("u_gsplatSHRange", m_shRange);
+            glm::vec4 eye = glm::inverse(_camera->getViewMatrix() * _model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            m_shader->setUniform("u_gsplatCameraPosition", glm::vec3(eye));
+        }
+
         // Setup vertex attributes
         glBindBuffer(GL_ARRAY_BUFFER, m_positionVBO);
         glEnableVertexAttribArray(m_position);
@@ -1528,7 +4034,7 @@ void Gsplat::render(Camera* _camera, glm::mat4 _model, bool _sort) {
     glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
     glDepthMask(GL_FALSE);  // Disable depth writes for transparency
 
-    size_t drawCount = (m_shader->getVersion() >= 300) ? m_depthUintIndex.size() : m_depthFloatIndex.size();
+    size_t drawCount = m_depthUintIndex.size();
     glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, drawCount);
     
     glDepthMask(depthMask); // Restore depth mask
@@ -1539,11 +4045,12 @@ void Gsplat::render(Camera* _camera, glm::mat4 _model, bool _sort) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     // Unbind texture
+    if (m_shTexture) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, 0);
-
-    // After render, we issue occlusion queries for next frame
-    performOcclusionQuery(viewProj);
 }
 
 // Renders splats into a view-space "scene normal" G-buffer, using each
@@ -1560,16 +4067,10 @@ void Gsplat::renderNormal(Camera* _camera, glm::mat4 _model, bool _sort) {
     ensureTexture(m_normalShader->getVersion());
 
     glm::mat4 viewProj = _camera->getProjectionMatrix() * _camera->getViewMatrix() * _model;
-    ensureSorted(viewProj, _sort);
+    ensureSorted(viewProj, _model, _camera->getViewport().w, _sort);
 
     // Update index buffer
-    glBindBuffer(GL_ARRAY_BUFFER, m_indexVBO);
-    if (m_normalShader->getVersion() >= 300) {
-        glBufferData(GL_ARRAY_BUFFER, m_depthUintIndex.size() * sizeof(uint32_t), m_depthUintIndex.data(), GL_STREAM_DRAW);
-    }
-    else {
-        glBufferData(GL_ARRAY_BUFFER, m_depthFloatIndex.size() * sizeof(float), m_depthFloatIndex.data(), GL_DYNAMIC_DRAW);
-    }
+    uploadIndexBuffer(m_normalShader->getVersion());
 
     m_normalShader->use();
 
@@ -1613,7 +4114,7 @@ void Gsplat::renderNormal(Camera* _camera, glm::mat4 _model, bool _sort) {
     glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
     glDepthMask(GL_FALSE);
 
-    size_t drawCount = (m_normalShader->getVersion() >= 300) ? m_depthUintIndex.size() : m_depthFloatIndex.size();
+    size_t drawCount = m_depthUintIndex.size();
     glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, drawCount);
 
     glDepthMask(depthMask);
@@ -1634,18 +4135,12 @@ void Gsplat::renderDepth(Camera* _camera, glm::mat4 _model, bool _sort) {
     ensureTexture(m_depthShader->getVersion());
 
     glm::mat4 viewProj = _camera->getProjectionMatrix() * _camera->getViewMatrix() * _model;
-    ensureSorted(viewProj, _sort);
+    ensureSorted(viewProj, _model, _camera->getViewport().w, _sort);
 
     // Update index buffer. Draw order doesn't affect correctness here (the
     // hardware depth test resolves overlap regardless of order), reusing it
     // just avoids a redundant upload/sort path.
-    glBindBuffer(GL_ARRAY_BUFFER, m_indexVBO);
-    if (m_depthShader->getVersion() >= 300) {
-        glBufferData(GL_ARRAY_BUFFER, m_depthUintIndex.size() * sizeof(uint32_t), m_depthUintIndex.data(), GL_STREAM_DRAW);
-    }
-    else {
-        glBufferData(GL_ARRAY_BUFFER, m_depthFloatIndex.size() * sizeof(float), m_depthFloatIndex.data(), GL_DYNAMIC_DRAW);
-    }
+    uploadIndexBuffer(m_depthShader->getVersion());
 
     m_depthShader->use();
 
@@ -1692,7 +4187,7 @@ void Gsplat::renderDepth(Camera* _camera, glm::mat4 _model, bool _sort) {
     glDepthMask(GL_TRUE);
     blendMode(BLEND_NONE);
 
-    size_t drawCount = (m_depthShader->getVersion() >= 300) ? m_depthUintIndex.size() : m_depthFloatIndex.size();
+    size_t drawCount = m_depthUintIndex.size();
     glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, drawCount);
 
     glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
@@ -1706,6 +4201,263 @@ void Gsplat::renderDepth(Camera* _camera, glm::mat4 _model, bool _sort) {
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+// CPU rasterizer (renderImage()). Everything a fragment of splat_frag_300
+// needs that does not vary over the quad is worked out once per splat: the
+// window-space center, the inverse quad axes and the final (tone mapped)
+// color, so a pixel only costs its quad coordinates and one exp().
+static const int SPLAT_TILE_SIZE = 16;
+
+struct SplatFootprint {
+    glm::vec2   center;         // window pixels, origin bottom left
+    glm::vec2   majorInv;       // pixel offset -> quad coordinate (+-2 at the corners)
+    glm::vec2   minorInv;
+    glm::vec3   color;
+    float       alpha;
+    int         pixelMin[2];    // pixel rectangle covered, inclusive
+    int         pixelMax[2];
+};
+
+// View-dependent color offset of bands 1.._degree (mirrors evalSH() of the shader)
+static glm::vec3 evalSplatSH(const uint8_t* _coeffs, int _degree, const glm::vec2& _range, const glm::vec3& _dir) {
+    float basis[15];
+    splatSHBasis(_dir, basis);
+
+    float step = (_range.y - _range.x) / 255.0f;
+    int count = (_degree + 1) * (_degree + 1) - 1;
+    glm::vec3 result(0.0f);
+    for (int k = 0; k < count; k++) {
+        const uint8_t* q = _coeffs + k * 3;
+        result += basis[k] * (_range.x + glm::vec3(q[0], q[1], q[2]) * step);
+    }
+    return result;
+}
+
+// Saturation, white point and sharpening of splat_frag_300, clamped like
+// a fixed point color buffer does
+static glm::vec3 splatFragmentColor(glm::vec3 _color) {
+    float luminance = glm::dot(_color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+    _color = glm::mix(glm::vec3(luminance), _color, 1.2f);
+    _color = _color * (1.0f + _color / (0.9f * 0.9f)) / (1.0f + _color);
+    _color = glm::pow(glm::max(_color, 0.0f), glm::vec3(1.0f / 1.05f));
+    return glm::clamp(_color, 0.0f, 1.0f);
+}
+
+bool Gsplat::renderImage(Camera* _camera, Image& _image, glm::mat4 _model) {
+    if (!_camera)
+        return false;
+
+    if (!_image.isAllocated()) {
+        glm::ivec4 viewport = _camera->getViewport();
+        if (viewport.z <= 0 || viewport.w <= 0)
+            return false;
+        _image.allocate(viewport.z, viewport.w, 4);
+    }
+    int width = _image.getWidth();
+    int height = _image.getHeight();
+
+    // Same visible set (culling, LOD cut) as render(). The order comes back
+    // to front; it's walked backwards below.
+    finishSort();
+    glm::mat4 modelView = _camera->getViewMatrix() * _model;
+    glm::mat4 viewProj = _camera->getProjectionMatrix() * modelView;
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> occluded;
+    computeOrder(viewProj, (float)height, true, order, occluded);
+    size_t n = order.size();
+
+    const glm::mat4& proj = _camera->getProjectionMatrix();
+    glm::vec2 focal(width * 0.5f * std::abs(proj[0][0]), height * 0.5f * std::abs(proj[1][1]));
+    glm::mat3 W = glm::transpose(glm::mat3(modelView));
+    glm::vec3 eye = glm::vec3(glm::inverse(modelView) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    int shDegree = std::min(m_shDegree, m_shMaxDegree);
+    size_t shStride = shCoeffCount() * 3;
+
+    int tilesX = (width + SPLAT_TILE_SIZE - 1) / SPLAT_TILE_SIZE;
+    int tilesY = (height + SPLAT_TILE_SIZE - 1) / SPLAT_TILE_SIZE;
+    size_t tileCount = (size_t)tilesX * tilesY;
+
+    // 1. Project every splat front to back (footprint k is order[n - 1 - k]),
+    // following splat_vert_300 step by step. Splats it would drop get an
+    // empty pixel rectangle.
+    std::vector<SplatFootprint> footprints(n);
+    size_t nThreads = parallelThreads(n, 4096);
+    parallelFor(nThreads, n, [&](size_t, size_t _start, size_t _end) {
+        for (size_t k = _start; k < _end; k++) {
+            uint32_t i = order[n - 1 - k];
+            SplatFootprint& fp = footprints[k];
+            fp.pixelMin[0] = fp.pixelMin[1] = 0;
+            fp.pixelMax[0] = fp.pixelMax[1] = -1;
+
+            glm::vec4 cam = modelView * glm::vec4(m_positions[i], 1.0f);
+            glm::vec4 pos2d = proj * cam;
+
+            glm::mat3 M = glm::mat3_cast(m_rotations[i]) * glm::mat3(
+                m_scales[i].x, 0.0f, 0.0f,
+                0.0f, m_scales[i].y, 0.0f,
+                0.0f, 0.0f, m_scales[i].z);
+            glm::mat3 Vrk = M * glm::transpose(M);
+
+            glm::mat3 J = glm::mat3(
+                focal.x / cam.z, 0.0f, -(focal.x * cam.x) / (cam.z * cam.z),
+                0.0f, focal.y / cam.z, -(focal.y * cam.y) / (cam.z * cam.z),
+                0.0f, 0.0f, 0.0f);
+            glm::mat3 T = W * J;
+            glm::mat3 cov2d = glm::transpose(T) * Vrk * T;
+            cov2d[0][0] += 0.1f;
+            cov2d[1][1] += 0.1f;
+
+            float mid = (cov2d[0][0] + cov2d[1][1]) * 0.5f;
+            float radius = glm::length(glm::vec2((cov2d[0][0] - cov2d[1][1]) * 0.5f, cov2d[0][1]));
+            float lambda1 = mid + radius;
+            float lambda2 = mid - radius;
+            if (lambda2 < 0.0f)
+                continue;
+
+            glm::vec2 diagonalVector = glm::normalize(glm::vec2(cov2d[0][1], lambda1 - cov2d[0][0]));
+            if (!std::isfinite(diagonalVector.x))
+                diagonalVector = glm::vec2(1.0f, 0.0f);   // isotropic: any axes do
+
+            // The quad corners sit at +-2 along the axes, half of each in
+            // pixels (the shader scales them by 1 / resolution in NDC)
+            glm::vec2 majorAxis = 0.5f * 2.5f * std::min(std::sqrt(2.0f * lambda1), 1024.0f) * diagonalVector;
+            glm::vec2 minorAxis = 0.5f * 2.5f * std::min(std::sqrt(2.0f * lambda2), 1024.0f) * glm::vec2(diagonalVector.y, -diagonalVector.x);
+            float majorLength2 = glm::dot(majorAxis, majorAxis);
+            float minorLength2 = glm::dot(minorAxis, minorAxis);
+            if (majorLength2 <= 0.0f || minorLength2 <= 0.0f)
+                continue;
+
+            fp.center = (glm::vec2(pos2d) / pos2d.w * 0.5f + 0.5f) * glm::vec2(width, height);
+            fp.majorInv = majorAxis / majorLength2;
+            fp.minorInv = minorAxis / minorLength2;
+
+            glm::vec4 color = glm::vec4(m_colors[i]) / 255.0f;
+            if (shDegree > 0) {
+                glm::vec3 dir = glm::normalize(m_positions[i] - eye);
+                color = glm::vec4(glm::max(glm::vec3(color) + evalSplatSH(m_shCoeffs.data() + i * shStride, shDegree, m_shRange, dir), 0.0f), color.a);
+            }
+            fp.color = splatFragmentColor(glm::vec3(color));
+            fp.alpha = color.a;
+
+            // Bounding box of the ellipse |quad coordinate| = 2 (anything
+            // further out is discarded)
+            glm::vec2 extent = 2.0f * glm::sqrt(majorAxis * majorAxis + minorAxis * minorAxis);
+            glm::vec2 lo = glm::max(fp.center - extent, glm::vec2(0.0f));
+            glm::vec2 hi = glm::min(fp.center + extent, glm::vec2(width - 1, height - 1));
+            if (lo.x > hi.x || lo.y > hi.y)
+                continue;
+            fp.pixelMin[0] = (int)lo.x;
+            fp.pixelMin[1] = (int)lo.y;
+            fp.pixelMax[0] = (int)hi.x;
+            fp.pixelMax[1] = (int)hi.y;
+        }
+    });
+
+    // 2. Bin them into tiles. Same scheme as radixSort(): per-thread counts,
+    // a scan over (tile, thread), then a stable scatter, so every tile list
+    // keeps the front-to-back order without a sort of its own.
+    std::vector<uint32_t> counts(nThreads * tileCount, 0);
+    parallelFor(nThreads, n, [&](size_t t, size_t _start, size_t _end) {
+        uint32_t* tileCounts = counts.data() + t * tileCount;
+        for (size_t k = _start; k < _end; k++) {
+            const SplatFootprint& fp = footprints[k];
+            // Dropped: -1 / SPLAT_TILE_SIZE would still land in tile 0
+            if (fp.pixelMax[0] < fp.pixelMin[0] || fp.pixelMax[1] < fp.pixelMin[1])
+                continue;
+            for (int ty = fp.pixelMin[1] / SPLAT_TILE_SIZE; ty <= fp.pixelMax[1] / SPLAT_TILE_SIZE; ty++)
+                for (int tx = fp.pixelMin[0] / SPLAT_TILE_SIZE; tx <= fp.pixelMax[0] / SPLAT_TILE_SIZE; tx++)
+                    tileCounts[ty * tilesX + tx]++;
+        }
+    });
+
+    std::vector<size_t> tileStart(tileCount + 1);
+    std::vector<size_t> offsets(nThreads * tileCount);
+    size_t total = 0;
+    for (size_t tile = 0; tile < tileCount; tile++) {
+        tileStart[tile] = total;
+        for (size_t t = 0; t < nThreads; t++) {
+            offsets[t * tileCount + tile] = total;
+            total += counts[t * tileCount + tile];
+        }
+    }
+    tileStart[tileCount] = total;
+
+    std::vector<uint32_t> entries(total);
+    parallelFor(nThreads, n, [&](size_t t, size_t _start, size_t _end) {
+        size_t* tileOffsets = offsets.data() + t * tileCount;
+        for (size_t k = _start; k < _end; k++) {
+            const SplatFootprint& fp = footprints[k];
+            if (fp.pixelMax[0] < fp.pixelMin[0] || fp.pixelMax[1] < fp.pixelMin[1])
+                continue;
+            for (int ty = fp.pixelMin[1] / SPLAT_TILE_SIZE; ty <= fp.pixelMax[1] / SPLAT_TILE_SIZE; ty++)
+                for (int tx = fp.pixelMin[0] / SPLAT_TILE_SIZE; tx <= fp.pixelMax[0] / SPLAT_TILE_SIZE; tx++)
+                    entries[tileOffsets[ty * tilesX + tx]++] = (uint32_t)k;
+        }
+    });
+
+    // 3. Composite each tile front to back: the same result as blending
+    // back to front with (SRC_ALPHA, ONE_MINUS_SRC_ALPHA) over black, but
+    // a pixel stops once what's left of it can't change its 8-bit value.
+    // Tile costs vary a lot, so threads pull tiles from a shared counter.
+    const float minTransmittance = 1.0f / 255.0f;
+    std::atomic<size_t> nextTile(0);
+    size_t tileThreads = parallelThreads(tileCount, 4);
+    parallelFor(tileThreads, tileThreads, [&](size_t, size_t, size_t) {
+        glm::vec3 color[SPLAT_TILE_SIZE * SPLAT_TILE_SIZE];
+        float transmittance[SPLAT_TILE_SIZE * SPLAT_TILE_SIZE];
+
+        for (size_t tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            int x0 = (int)(tile % tilesX) * SPLAT_TILE_SIZE;
+            int y0 = (int)(tile / tilesX) * SPLAT_TILE_SIZE;
+            int tileW = std::min(SPLAT_TILE_SIZE, width - x0);
+            int tileH = std::min(SPLAT_TILE_SIZE, height - y0);
+            int active = tileW * tileH;
+            for (int p = 0; p < SPLAT_TILE_SIZE * SPLAT_TILE_SIZE; p++) {
+                color[p] = glm::vec3(0.0f);
+                transmittance[p] = 1.0f;
+            }
+
+            for (size_t e = tileStart[tile]; e < tileStart[tile + 1] && active > 0; e++) {
+                const SplatFootprint& fp = footprints[entries[e]];
+                int pxBegin = std::max(fp.pixelMin[0] - x0, 0);
+                int pxEnd = std::min(fp.pixelMax[0] - x0 + 1, tileW);
+                int pyBegin = std::max(fp.pixelMin[1] - y0, 0);
+                int pyEnd = std::min(fp.pixelMax[1] - y0 + 1, tileH);
+                for (int py = pyBegin; py < pyEnd; py++) {
+                    for (int px = pxBegin; px < pxEnd; px++) {
+                        int p = py * SPLAT_TILE_SIZE + px;
+                        if (transmittance[p] < minTransmittance)
+                            continue;
+
+                        // Fragment centers, in the quad's own coordinates
+                        glm::vec2 d = glm::vec2(x0 + px + 0.5f, y0 + py + 0.5f) - fp.center;
+                        glm::vec2 uv(glm::dot(d, fp.majorInv), glm::dot(d, fp.minorInv));
+                        float A = -glm::dot(uv, uv);
+                        if (A < -4.0f)
+                            continue;
+
+                        float B = std::exp(A) * fp.alpha * glm::smoothstep(-4.0f, -3.5f, A);
+                        color[p] += fp.color * (B * transmittance[p]);
+                        transmittance[p] *= 1.0f - B;
+                        if (transmittance[p] < minTransmittance)
+                            active--;
+                    }
+                }
+            }
+
+            // Window rows go up, image rows go down
+            for (int py = 0; py < tileH; py++) {
+                for (int px = 0; px < tileW; px++) {
+                    int p = py * SPLAT_TILE_SIZE + px;
+                    size_t index = _image.getIndex(x0 + px, height - 1 - (y0 + py));
+                    _image.setColor(index, glm::vec4(color[p], 1.0f - transmittance[p]));
+                }
+            }
+        }
+    });
+
+    return true;
+}
+
 void Gsplat::renderBlocks(Camera* _camera, glm::mat4 _model) {
     if (!_camera)
         return;
@@ -1719,9 +4471,10 @@ void Gsplat::renderBlocks(Camera* _camera, glm::mat4 _model) {
     glm::mat4 viewProj = _camera->getProjectionMatrix() * _camera->getViewMatrix() * _model;
     Frustum frustum = extractFrustum(viewProj);
 
-    for (const auto& block : m_blocks) {
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+        const SplatBlock& block = m_blocks[b];
         bool visible = isBoxInFrustum(block.min_bounds, block.max_bounds, frustum);
-        bool occluded = block.occluded;
+        bool occluded = b < m_occludedBlocks.size() && m_occludedBlocks[b];
         
         if (visible && !occluded) {
             vera::stroke(0.0f, 1.0f, 0.0f, 1.0f);
@@ -1737,6 +4490,13 @@ void Gsplat::renderBlocks(Camera* _camera, glm::mat4 _model) {
 }
 
 void Gsplat::optimizeDataLayout() {
+    finishSort();
+    dropLOD();
+    // The published order indexes the splats before the permutation
+    m_sortPreviousValid = false;
+    m_sortPositionsDirty = true;
+    m_hasSorted = false;
+
     size_t count = m_positions.size();
     if (count == 0) return;
 
@@ -1778,6 +4538,359 @@ void Gsplat::optimizeDataLayout() {
     permute(m_scales);
     permute(m_rotations);
     permute(m_colors);
+
+    if (m_shDegree > 0) {
+        size_t stride = shCoeffCount() * 3;
+        std::vector<uint8_t> temp = m_shCoeffs;
+        for (size_t i = 0; i < count; i++)
+            std::memcpy(m_shCoeffs.data() + i * stride, temp.data() + indices[i] * stride, stride);
+    }
+}
+
+// Per-band matrices rotating SH coefficients: for each band l, _bands[l-1]
+// takes a splat's coefficients to those whose value at a direction d equals
+// the original's at _rotation^T d. Solved from 2l+1 sample directions
+// (Y * M = Yr, both sampled with the basis of splatSHBasis()).
+static void splatSHRotation(const glm::mat3& _rotation, float _bands[3][7][7]) {
+    static const glm::vec3 samples[7] = {
+        glm::vec3(0.577f, 0.316f, 0.753f), glm::vec3(-0.612f, 0.771f, 0.175f),
+        glm::vec3(0.213f, -0.877f, 0.431f), glm::vec3(-0.359f, -0.148f, -0.921f),
+        glm::vec3(0.941f, 0.262f, -0.215f), glm::vec3(-0.802f, -0.513f, 0.306f),
+        glm::vec3(0.108f, 0.634f, -0.766f) };
+
+    float basis[7][15], rotated[7][15];
+    for (int j = 0; j < 7; j++) {
+        glm::vec3 d = glm::normalize(samples[j]);
+        splatSHBasis(d, basis[j]);
+        splatSHBasis(glm::transpose(_rotation) * d, rotated[j]);
+    }
+
+    for (int l = 1; l <= 3; l++) {
+        int m = 2 * l + 1;
+        int o = l * l - 1;
+        double a[7][14];
+        for (int j = 0; j < m; j++) {
+            for (int k = 0; k < m; k++) {
+                a[j][k] = basis[j][o + k];
+                a[j][m + k] = rotated[j][o + k];
+            }
+        }
+
+        // Gauss-Jordan with partial pivoting on [Y | Yr]
+        for (int c = 0; c < m; c++) {
+            int pivot = c;
+            for (int r = c + 1; r < m; r++)
+                if (std::abs(a[r][c]) > std::abs(a[pivot][c]))
+                    pivot = r;
+            for (int k = 0; k < 2 * m; k++)
+                std::swap(a[c][k], a[pivot][k]);
+            double inv = 1.0 / a[c][c];
+            for (int k = 0; k < 2 * m; k++)
+                a[c][k] *= inv;
+            for (int r = 0; r < m; r++) {
+                if (r == c || a[r][c] == 0.0)
+                    continue;
+                double f = a[r][c];
+                for (int k = 0; k < 2 * m; k++)
+                    a[r][k] -= f * a[c][k];
+            }
+        }
+
+        for (int r = 0; r < m; r++)
+            for (int k = 0; k < m; k++)
+                _bands[l - 1][r][k] = (float)a[r][m + k];
+    }
+}
+
+// World-space copy of the sources. Each one keeps a contiguous range, in
+// source order, already pruned and laid out by its own load.
+void Gsplat::mergeFrom(const std::vector<const Gsplat*>& _sources, const std::vector<glm::mat4>& _matrices) {
+    clearSplats();
+
+    size_t total = 0;
+    int shDegree = 0;
+    for (const Gsplat* src : _sources) {
+        total += src->count();
+        shDegree = std::max(shDegree, src->m_shDegree);
+    }
+    shDegree = std::min(shDegree, m_shMaxDegree);
+
+    m_positions.resize(total);
+    m_scales.resize(total);
+    m_rotations.resize(total);
+    m_colors.resize(total);
+    m_shDegree = shDegree;
+    int shCoeffs = shCoeffCount();
+    m_shCoeffs.resize(total * shCoeffs * 3);
+
+    // One range for every rotation: a rotation keeps the length of each
+    // band (per channel), so no coefficient can outgrow the longest band.
+    // Symmetric, like the loaders' (see loadPLY()).
+    float extent = 0.0f;
+    for (const Gsplat* src : _sources)
+        extent = std::max(extent, src->shBandExtent(std::min(src->shCoeffCount(), shCoeffs)));
+    m_shRange = glm::vec2(-extent, extent);
+
+    size_t first = 0;
+    for (size_t s = 0; s < _sources.size(); s++) {
+        transformSource(_sources[s], _matrices[s], first);
+        first += _sources[s]->count();
+    }
+
+    buildSpatialIndex();
+}
+
+float Gsplat::shBandExtent(int _coeffs) const {
+    if (_coeffs <= 0 || count() == 0)
+        return 0.0f;
+
+    size_t stride = shCoeffCount() * 3;
+    float step = (m_shRange.y - m_shRange.x) / 255.0f;
+    size_t nThreads = parallelThreads(count(), 4096);
+    std::vector<float> extents(nThreads, 0.0f);
+    parallelFor(nThreads, count(), [&](size_t _t, size_t _start, size_t _end) {
+        for (size_t i = _start; i < _end; i++) {
+            const uint8_t* q = m_shCoeffs.data() + i * stride;
+            for (int l = 1; l * l - 1 < _coeffs; l++)
+                for (int ch = 0; ch < 3; ch++) {
+                    float length = 0.0f;
+                    for (int k = l * l - 1; k < (l + 1) * (l + 1) - 1; k++) {
+                        float v = m_shRange.x + q[k * 3 + ch] * step;
+                        length += v * v;
+                    }
+                    extents[_t] = std::max(extents[_t], std::sqrt(length));
+                }
+        }
+    });
+    return *std::max_element(extents.begin(), extents.end());
+}
+
+void Gsplat::moveSource(const Gsplat* _source, const glm::mat4& _matrix, size_t _first) {
+    finishSort();
+    transformSource(_source, _matrix, _first);
+    splatsChanged(_first, _first + _source->count(), true);
+}
+
+// Similarity transforms scale and rotate each splat directly; anything else
+// (non-uniform scale, shear, mirroring) goes through the transformed
+// covariance. SH are rotated by the orthogonal part of the matrix and
+// re-quantized against m_shRange.
+void Gsplat::transformSource(const Gsplat* _source, const glm::mat4& _matrix, size_t _first) {
+    glm::mat3 linear = glm::mat3(_matrix);
+    glm::vec3 translation = glm::vec3(_matrix[3]);
+
+    // Orthogonal part: A (A^T A)^-1/2
+    glm::vec3 values;
+    glm::mat3 vectors;
+    symmetricEigen(glm::transpose(linear) * linear, values, vectors);
+    glm::vec3 invRoot = 1.0f / glm::sqrt(glm::max(values, glm::vec3(1e-20f)));
+    glm::mat3 orthogonal = linear * vectors * glm::mat3(
+        invRoot.x, 0.0f, 0.0f,
+        0.0f, invRoot.y, 0.0f,
+        0.0f, 0.0f, invRoot.z) * glm::transpose(vectors);
+
+    float maxValue = std::max(values.x, std::max(values.y, values.z));
+    float minValue = std::min(values.x, std::min(values.y, values.z));
+    float scale = std::sqrt(std::max(maxValue, 0.0f));
+    bool similar = (maxValue - minValue) <= 1e-4f * maxValue && glm::determinant(linear) > 0.0f;
+    glm::quat rotation = glm::normalize(glm::quat_cast(orthogonal));
+
+    int shCoeffs = shCoeffCount();
+    size_t stride = shCoeffs * 3;
+    int srcCoeffs = std::min(_source->shCoeffCount(), shCoeffs);
+    size_t srcStride = _source->shCoeffCount() * 3;
+    float shBands[3][7][7];
+    if (shCoeffs > 0)
+        splatSHRotation(orthogonal, shBands);
+    float srcStep = (_source->m_shRange.y - _source->m_shRange.x) / 255.0f;
+    float extent = m_shRange.y;
+    float shScale = (extent > 0.0f) ? 255.0f / (2.0f * extent) : 0.0f;
+
+    size_t count = _source->count();
+    parallelFor(parallelThreads(count, 4096), count, [&](size_t, size_t _start, size_t _end) {
+        float in[45], rotated[45];
+        for (size_t local = _start; local < _end; local++) {
+            size_t i = _first + local;
+            m_positions[i] = linear * _source->m_positions[local] + translation;
+            m_colors[i] = _source->m_colors[local];
+            if (similar) {
+                m_scales[i] = _source->m_scales[local] * scale;
+                m_rotations[i] = glm::normalize(rotation * _source->m_rotations[local]);
+            }
+            else {
+                const glm::vec3& sc = _source->m_scales[local];
+                glm::mat3 M = linear * glm::mat3_cast(_source->m_rotations[local]) * glm::mat3(
+                    sc.x, 0.0f, 0.0f,
+                    0.0f, sc.y, 0.0f,
+                    0.0f, 0.0f, sc.z);
+                glm::vec3 axesValues;
+                glm::mat3 axes;
+                symmetricEigen(M * glm::transpose(M), axesValues, axes);
+                if (glm::determinant(axes) < 0.0f)
+                    axes[2] = -axes[2];
+                m_scales[i] = glm::sqrt(glm::max(axesValues, glm::vec3(1e-12f)));
+                m_rotations[i] = glm::normalize(glm::quat_cast(axes));
+            }
+
+            if (shCoeffs == 0)
+                continue;
+
+            // Dequantized, bands up to m_shDegree (missing ones are zero)
+            const uint8_t* q = _source->m_shCoeffs.data() + local * srcStride;
+            for (size_t c = 0; c < stride; c++)
+                in[c] = (c < (size_t)srcCoeffs * 3) ? _source->m_shRange.x + q[c] * srcStep : 0.0f;
+
+            for (int l = 1; l * l - 1 < shCoeffs; l++) {
+                int m = 2 * l + 1;
+                int o = l * l - 1;
+                const float (*band)[7] = shBands[l - 1];
+                for (int r = 0; r < m; r++) {
+                    for (int ch = 0; ch < 3; ch++) {
+                        float v = 0.0f;
+                        for (int k = 0; k < m; k++)
+                            v += band[r][k] * in[(o + k) * 3 + ch];
+                        rotated[(o + r) * 3 + ch] = v;
+                    }
+                }
+            }
+
+            uint8_t* dst = m_shCoeffs.data() + i * stride;
+            for (size_t c = 0; c < stride; c++)
+                dst[c] = static_cast<uint8_t>(glm::clamp((rotated[c] + extent) * shScale + 0.5f, 0.0f, 255.0f));
+        }
+    });
+}
+
+void GsplatCompositor::add(Gsplat* _gsplat, const glm::mat4& _matrix) {
+    if (!_gsplat)
+        return;
+
+    Source source;
+    source.gsplat = _gsplat;
+    source.model = nullptr;
+    source.matrix = _matrix;
+    m_sources.push_back(source);
+    m_dirty = true;
+}
+
+void GsplatCompositor::add(Model* _model) {
+    if (!_model)
+        return;
+
+    Source source;
+    source.gsplat = nullptr;
+    source.model = _model;
+    source.matrix = glm::mat4(1.0f);
+    m_sources.push_back(source);
+    m_dirty = true;
+}
+
+void GsplatCompositor::add(const std::map<std::string, Model*>& _models) {
+    for (const auto& it : _models)
+        if (it.second && it.second->getGsplat())
+            add(it.second);
+}
+
+void GsplatCompositor::clear() {
+    m_sources.clear();
+    m_merged.clear();
+    m_dirty = true;
+}
+
+// Refits that leave the blocks this much larger (sources moved away from
+// the ones they share blocks with) index the merged splats again
+static const float COMPOSITOR_REINDEX_AREA = 2.0f;
+
+void GsplatCompositor::update() {
+    std::vector<const Gsplat*> gsplats;
+    std::vector<glm::mat4> matrices;
+    std::vector<Source*> moved;
+    bool changed = m_dirty;
+    size_t first = 0;
+
+    for (Source& source : m_sources) {
+        Gsplat* gsplat = source.model ? source.model->getGsplat() : source.gsplat;
+        glm::mat4 matrix = source.model ? source.model->getTransformMatrix() : source.matrix;
+
+        // Sources still streaming in join once complete
+        if (gsplat)
+            gsplat->updateProgressiveLoad();
+        if (!gsplat || gsplat->isLoading()) {
+            if (source.mergedCount > 0)
+                changed = true;
+            source.mergedGsplat = nullptr;
+            source.mergedCount = 0;
+            continue;
+        }
+
+        if (gsplat != source.mergedGsplat || gsplat->count() != source.mergedCount || first != source.mergedFirst)
+            changed = true;
+        else if (gsplat->getGeneration() != source.mergedGeneration && !fitsMerged(gsplat))
+            changed = true;
+        else if ((matrix != source.mergedMatrix || gsplat->getGeneration() != source.mergedGeneration) && gsplat->count() > 0)
+            moved.push_back(&source);
+        source.mergedGsplat = gsplat;
+        source.mergedMatrix = matrix;
+        source.mergedCount = gsplat->count();
+        source.mergedFirst = first;
+        source.mergedGeneration = gsplat->getGeneration();
+
+        if (gsplat->count() > 0) {
+            gsplats.push_back(gsplat);
+            matrices.push_back(matrix);
+            first += gsplat->count();
+        }
+    }
+
+    if (changed) {
+        m_merged.mergeFrom(gsplats, matrices);
+        m_mergedArea = blocksArea();
+        m_dirty = false;
+        return;
+    }
+
+    if (moved.empty())
+        return;
+
+    for (Source* source : moved)
+        m_merged.moveSource(source->mergedGsplat, source->mergedMatrix, source->mergedFirst);
+
+    if (blocksArea() > m_mergedArea * COMPOSITOR_REINDEX_AREA) {
+        m_merged.buildSpatialIndex();
+        m_mergedArea = blocksArea();
+    }
+}
+
+bool GsplatCompositor::fitsMerged(const Gsplat* _gsplat) const {
+    // More SH bands than merged, that the merged copy could have kept
+    if (std::min(_gsplat->m_shDegree, m_merged.m_shMaxDegree) > m_merged.m_shDegree)
+        return false;
+    int coeffs = std::min(_gsplat->shCoeffCount(), m_merged.shCoeffCount());
+    return _gsplat->shBandExtent(coeffs) <= m_merged.m_shRange.y;
+}
+
+float GsplatCompositor::blocksArea() const {
+    float area = 0.0f;
+    for (const SplatBlock& block : m_merged.m_blocks) {
+        glm::vec3 d = block.max_bounds - block.min_bounds;
+        area += 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    return area;
+}
+
+void GsplatCompositor::render(Camera* _camera, bool _sort) {
+    update();
+    m_merged.render(_camera, glm::mat4(1.0f), _sort);
+}
+
+void GsplatCompositor::renderNormal(Camera* _camera, bool _sort) {
+    update();
+    m_merged.renderNormal(_camera, glm::mat4(1.0f), _sort);
+}
+
+void GsplatCompositor::renderDepth(Camera* _camera, bool _sort) {
+    update();
+    m_merged.renderDepth(_camera, glm::mat4(1.0f), _sort);
 }
 
 } // namespace vera
\ No newline at end of file
@@ -790,6 +790,7 @@ void Scene::clearModels() {
     for (ModelsMap::iterator it = models.begin(); it != models.end(); ++it)
         delete (it->second);
     models.clear();
+    m_modelsBVH.clear();
     m_changed = true;
 }
 
@@ -802,6 +803,8 @@ void Scene::removeModelsByPrefix(const std::string& _prefix) {
         // Match the whole-name case (single-model files: key == prefix) and the
         // sub-model case (multi-model files: key == prefix + "_" + subname).
         if (it->first == _prefix || it->first.compare(0, sub.size(), sub) == 0) {
+            // A model allocated later at the same address is not this one
+            m_modelsBVH.invalidate(it->second);
             delete it->second;
             it = models.erase(it);
         }
@@ -811,6 +814,37 @@ void Scene::removeModelsByPrefix(const std::string& _prefix) {
     m_changed = true;
 }
 
+bool Scene::raycast(const Ray& _ray, SceneHit& _hit, float _maxDistance) {
+    m_modelsBVH.update(models);
+    return m_modelsBVH.intersect(_ray, _hit, _maxDistance);
+}
+
+Model* Scene::raycast(const Ray& _ray) {
+    SceneHit hit;
+    return raycast(_ray, hit) ? hit.model : nullptr;
+}
+
+Model* Scene::pick(float _x, float _y, SceneHit* _hit) {
+    if (activeCamera == nullptr)
+        return nullptr;
+
+    // From the near to the far plane through the pixel
+    glm::ivec4 viewport = activeCamera->getViewport();
+    glm::vec4 ndc(_x / viewport.z * 2.0f - 1.0f, 1.0f - _y / viewport.w * 2.0f, -1.0f, 1.0f);
+    glm::vec4 near = activeCamera->getInverseViewMatrix() * (activeCamera->getInverseProjectionMatrix() * ndc);
+    ndc.z = 1.0f;
+    glm::vec4 far = activeCamera->getInverseViewMatrix() * (activeCamera->getInverseProjectionMatrix() * ndc);
+    glm::vec3 origin = glm::vec3(near) / near.w;
+
+    SceneHit hit;
+    if (!raycast(Ray(origin, glm::vec3(far) / far.w - origin), hit))
+        return nullptr;
+
+    if (_hit)
+        *_hit = hit;
+    return hit.model;
+}
+
 // MATERIAL
 // 
 void Scene::printMaterials() {
@@ -0,0 +1,304 @@
+#include "vera/types/sceneBVH.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace vera {
+
+// Models per top level leaf. Splits are at the median, so the depth (and
+// the traversal stack) stays under 32 levels for any number of models.
+static const size_t SCENE_BVH_LEAF_SIZE = 2;
+static const size_t SCENE_BVH_STACK_SIZE = 64;
+
+// Refits that leave the top level this many times costlier than built
+// (models moved far from their neighbours) build it again
+static const float SCENE_BVH_REBUILD_COST = 2.0f;
+
+static float boxArea(const glm::vec3& _min, const glm::vec3& _max) {
+    glm::vec3 d = glm::max(_max - _min, glm::vec3(0.0f));
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static bool boxHit(const glm::vec3& _min, const glm::vec3& _max, const glm::vec3& _origin, const glm::vec3& _invDirection, float _maxDistance, float& _enter) {
+    glm::vec3 t0 = (_min - _origin) * _invDirection;
+    glm::vec3 t1 = (_max - _origin) * _invDirection;
+    glm::vec3 tmin = glm::min(t0, t1);
+    glm::vec3 tmax = glm::max(t0, t1);
+    _enter = std::max(0.0f, std::max(tmin.x, std::max(tmin.y, tmin.z)));
+    float exit = std::min(_maxDistance, std::min(tmax.x, std::min(tmax.y, tmax.z)));
+    return _enter <= exit;
+}
+
+// Bounds of _local once moved by _matrix (its eight corners)
+static BoundingBox transformBounds(const BoundingBox& _local, const glm::mat4& _matrix) {
+    BoundingBox bounds;
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner((i & 1) ? _local.max.x : _local.min.x,
+                         (i & 2) ? _local.max.y : _local.min.y,
+                         (i & 4) ? _local.max.z : _local.min.z);
+        glm::vec3 p = glm::vec3(_matrix * glm::vec4(corner, 1.0f));
+        bounds.min = glm::min(bounds.min, p);
+        bounds.max = glm::max(bounds.max, p);
+    }
+    return bounds;
+}
+
+SceneBVH::SceneBVH() {
+}
+
+SceneBVH::~SceneBVH() {
+    clear();
+}
+
+void SceneBVH::clear() {
+    m_instances.clear();
+    m_order.clear();
+    m_nodes.clear();
+    m_buildCost = 0.0f;
+}
+
+void SceneBVH::invalidate(const Model* _model) {
+    for (Instance& instance : m_instances)
+        if (instance.model == _model)
+            instance.bvh.reset();
+}
+
+void SceneBVH::update(const ModelsMap& _models) {
+    // Only triangle meshes can be hit (not lines, points or splats)
+    std::vector<Model*> models;
+    models.reserve(_models.size());
+    for (ModelsMap::const_iterator it = _models.begin(); it != _models.end(); ++it) {
+        Model* model = it->second;
+        if (model != nullptr && model->mesh.getDrawMode() == TRIANGLES && model->mesh.getVerticesTotal() > 0)
+            models.push_back(model);
+    }
+
+    bool rebuild = models.size() != m_instances.size();
+    for (size_t i = 0; i < models.size() && !rebuild; i++)
+        rebuild = models[i] != m_instances[i].model;
+
+    if (rebuild) {
+        // Models still there keep their mesh BVH
+        std::map<const Model*, Instance> previous;
+        for (Instance& instance : m_instances)
+            previous[instance.model] = instance;
+
+        m_instances.resize(models.size());
+        for (size_t i = 0; i < models.size(); i++) {
+            std::map<const Model*, Instance>::iterator it = previous.find(models[i]);
+            m_instances[i] = (it != previous.end()) ? it->second : Instance();
+            m_instances[i].model = models[i];
+        }
+    }
+
+    bool moved = false;
+    for (size_t i = 0; i < m_instances.size(); i++) {
+        Instance& instance = m_instances[i];
+        const Mesh& mesh = instance.model->mesh;
+        if (mesh.getVerticesTotal() != instance.vertices || mesh.getIndicesTotal() != instance.indices) {
+            instance.vertices = mesh.getVerticesTotal();
+            instance.indices = mesh.getIndicesTotal();
+            instance.bvh.reset();
+        }
+
+        const glm::mat4& matrix = instance.model->getTransformMatrix();
+        const BoundingBox& local = instance.model->getBoundingBox();
+        if (rebuild || matrix != instance.matrix ||
+            local.min != instance.localBounds.min || local.max != instance.localBounds.max) {
+            instance.matrix = matrix;
+            instance.inverse = glm::inverse(matrix);
+            instance.localBounds = local;
+            instance.bounds = transformBounds(local, matrix);
+            moved = true;
+        }
+    }
+
+    if (rebuild)
+        _build();
+    else if (moved) {
+        _refit();
+        if (_cost() > m_buildCost * SCENE_BVH_REBUILD_COST)
+            _build();
+    }
+}
+
+void SceneBVH::_build() {
+    m_nodes.clear();
+    m_order.resize(m_instances.size());
+    std::iota(m_order.begin(), m_order.end(), 0);
+    if (m_instances.empty())
+        return;
+
+    m_nodes.reserve(m_instances.size() * 2);
+    _build(0, m_instances.size());
+    m_buildCost = _cost();
+}
+
+void SceneBVH::_build(size_t _begin, size_t _end) {
+    uint32_t index = (uint32_t)m_nodes.size();
+    m_nodes.push_back(BVHNode());
+
+    BVHNode node;
+    node.min = glm::vec3(std::numeric_limits<float>::max());
+    node.max = glm::vec3(std::numeric_limits<float>::lowest());
+    glm::vec3 centerMin = node.min;
+    glm::vec3 centerMax = node.max;
+    for (size_t i = _begin; i < _end; i++) {
+        const BoundingBox& bounds = m_instances[m_order[i]].bounds;
+        glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+        node.min = glm::min(node.min, bounds.min);
+        node.max = glm::max(node.max, bounds.max);
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+
+    if (_end - _begin <= SCENE_BVH_LEAF_SIZE) {
+        node.offset = (uint32_t)_begin;
+        node.count = (uint32_t)(_end - _begin);
+        m_nodes[index] = node;
+        return;
+    }
+
+    glm::vec3 extent = centerMax - centerMin;
+    int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+    size_t mid = (_begin + _end) / 2;
+    std::nth_element(m_order.begin() + _begin, m_order.begin() + mid, m_order.begin() + _end, [&](uint32_t a, uint32_t b) {
+        const BoundingBox& ba = m_instances[a].bounds;
+        const BoundingBox& bb = m_instances[b].bounds;
+        return ba.min[axis] + ba.max[axis] < bb.min[axis] + bb.max[axis];
+    });
+
+    _build(_begin, mid);
+    node.offset = (uint32_t)m_nodes.size();
+    node.count = 0;
+    _build(mid, _end);
+    m_nodes[index] = node;
+}
+
+// Children always come after their parent: back to front, each node sees
+// its children already refit
+void SceneBVH::_refit() {
+    for (size_t n = m_nodes.size(); n-- > 0; ) {
+        BVHNode& node = m_nodes[n];
+        if (node.count == 0) {
+            node.min = glm::min(m_nodes[n + 1].min, m_nodes[node.offset].min);
+            node.max = glm::max(m_nodes[n + 1].max, m_nodes[node.offset].max);
+            continue;
+        }
+
+        const BoundingBox& first = m_instances[m_order[node.offset]].bounds;
+        node.min = first.min;
+        node.max = first.max;
+        for (size_t i = node.offset + 1; i < node.offset + node.count; i++) {
+            const BoundingBox& bounds = m_instances[m_order[i]].bounds;
+            node.min = glm::min(node.min, bounds.min);
+            node.max = glm::max(node.max, bounds.max);
+        }
+    }
+}
+
+// Expected number of boxes and models a ray through the root is tested
+// against (a SAH cost where testing a model costs as much as a box)
+float SceneBVH::_cost() const {
+    if (m_nodes.empty())
+        return 0.0f;
+
+    float rootArea = std::max(boxArea(m_nodes[0].min, m_nodes[0].max), 1e-30f);
+    float cost = 0.0f;
+    for (const BVHNode& node : m_nodes)
+        cost += boxArea(node.min, node.max) / rootArea * (node.count == 0 ? 1.0f : (float)node.count);
+    return cost;
+}
+
+bool SceneBVH::intersect(const Ray& _ray, SceneHit& _hit, float _maxDistance) {
+    _hit = SceneHit();
+    if (m_nodes.empty())
+        return false;
+
+    const glm::vec3& origin = _ray.getOrigin();
+    const glm::vec3& invDirection = _ray.getInvertDirection();
+    float maxDistance = _maxDistance;
+    Instance* hitInstance = nullptr;
+
+    struct Entry {
+        uint32_t    node;
+        float       enter;
+    };
+    Entry stack[SCENE_BVH_STACK_SIZE];
+    size_t size = 0;
+
+    float enter;
+    if (boxHit(m_nodes[0].min, m_nodes[0].max, origin, invDirection, maxDistance, enter))
+        stack[size++] = { 0, enter };
+
+    while (size > 0) {
+        Entry entry = stack[--size];
+        if (entry.enter > maxDistance)
+            continue;
+
+        const BVHNode& node = m_nodes[entry.node];
+        if (node.count == 0) {
+            // Nearest child on top, so it is searched first
+            uint32_t near = entry.node + 1;
+            uint32_t far = node.offset;
+            float enterNear, enterFar;
+            bool hitNear = boxHit(m_nodes[near].min, m_nodes[near].max, origin, invDirection, maxDistance, enterNear);
+            bool hitFar = boxHit(m_nodes[far].min, m_nodes[far].max, origin, invDirection, maxDistance, enterFar);
+            if (hitNear && hitFar && enterFar < enterNear) {
+                std::swap(near, far);
+                std::swap(enterNear, enterFar);
+            }
+            if (hitFar)
+                stack[size++] = { far, enterFar };
+            if (hitNear)
+                stack[size++] = { near, enterNear };
+            continue;
+        }
+
+        for (size_t i = node.offset; i < node.offset + node.count; i++) {
+            Instance& instance = m_instances[m_order[i]];
+            float instanceEnter;
+            if (!boxHit(instance.bounds.min, instance.bounds.max, origin, invDirection, maxDistance, instanceEnter))
+                continue;
+
+            // Into the model's space, where distances scale by the length
+            // the matrix gives the direction
+            glm::vec3 localOrigin = glm::vec3(instance.inverse * glm::vec4(origin, 1.0f));
+            glm::vec3 localDirection = glm::mat3(instance.inverse) * _ray.getDirection();
+            float scale = glm::length(localDirection);
+            if (!(scale > 0.0f))
+                continue;
+
+            if (instance.bvh == nullptr)
+                instance.bvh = std::make_shared<BVH>(TriangleSoup(instance.model->mesh), SPLIT_SAH);
+
+            BVHHit hit;
+            float localMax = (maxDistance < std::numeric_limits<float>::max() / scale) ? maxDistance * scale : std::numeric_limits<float>::max();
+            if (!instance.bvh->intersect(Ray(localOrigin, localDirection), hit, 0.0f, localMax))
+                continue;
+
+            float t = hit.t / scale;
+            if (t <= maxDistance) {
+                maxDistance = t;
+                hitInstance = &instance;
+                _hit.t = t;
+                _hit.triangle = hit.triangle;
+                _hit.barycentric = hit.barycentric;
+            }
+        }
+    }
+
+    if (hitInstance == nullptr)
+        return false;
+
+    _hit.model = hitInstance->model;
+    _hit.position = _ray.getAt(_hit.t);
+    glm::vec3 normal = hitInstance->bvh->elements.getNormal(_hit.triangle);
+    _hit.normal = glm::normalize(glm::transpose(glm::mat3(hitInstance->inverse)) * normal);
+    return true;
+}
+
+}
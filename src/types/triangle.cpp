@@ -207,39 +207,43 @@ glm::vec4 Triangle::getTangent(const glm::vec3& _barycenter ) const {
 }
 
 glm::vec3 Triangle::getClosestPoint(const glm::vec3& _p) const {
+    return getClosestPoint(m_vertices[0], m_vertices[1], m_vertices[2], _p);
+}
+
+glm::vec3 Triangle::getClosestPoint(const glm::vec3& _v0, const glm::vec3& _v1, const glm::vec3& _v2, const glm::vec3& _p) {
     // https://github.com/nmoehrle/libacc/blob/master/primitives.h#L71
-    glm::vec3 ab = m_vertices[1] - m_vertices[0];
-    glm::vec3 ac = m_vertices[2] - m_vertices[0];
+    glm::vec3 ab = _v1 - _v0;
+    glm::vec3 ac = _v2 - _v0;
     glm::vec3 normal = glm::normalize( glm::cross(ac,ab) );
 
-    glm::vec3 p = _p - glm::dot(normal, _p - m_vertices[0]) * normal;
-    glm::vec3 ap = p - m_vertices[0];
+    glm::vec3 p = _p - glm::dot(normal, _p - _v0) * normal;
+    glm::vec3 ap = p - _v0;
 
     glm::vec3 bcoords = getBarycentric(ab, ac, ap);
 
     if (bcoords[0] < 0.0f) {
-        glm::vec3 bc = m_vertices[2] - m_vertices[1];
+        glm::vec3 bc = _v2 - _v1;
         float n = glm::length( bc ); // bc.norm();
-        float t = glm::max(0.0f, glm::min( glm::dot(bc, p - m_vertices[1]) / n, n));
-        return m_vertices[1] + t / n * bc;
+        float t = glm::max(0.0f, glm::min( glm::dot(bc, p - _v1) / n, n));
+        return _v1 + t / n * bc;
     }
 
     if (bcoords[1] < 0.0f) {
-        glm::vec3 ca = m_vertices[0] - m_vertices[2];
+        glm::vec3 ca = _v0 - _v2;
         float n = glm::length( ca ); //ca.norm();
-        float t = glm::max(0.0f, glm::min( glm::dot(ca, p - m_vertices[2]) / n, n));
-        return m_vertices[2] + t / n * ca;
+        float t = glm::max(0.0f, glm::min( glm::dot(ca, p - _v2) / n, n));
+        return _v2 + t / n * ca;
     }
 
     if (bcoords[2] < 0.0f) {
-        //glm::vec3 ab = m_vertices[1] - m_vertices[0];
+        //glm::vec3 ab = _v1 - _v0;
         float n = glm::length( ab ); //ab.norm();
         
-        float t = glm::max(0.0f, glm::min( glm::dot(ab, p - m_vertices[0]) / n, n));
-        return m_vertices[0] + t / n * ab;
+        float t = glm::max(0.0f, glm::min( glm::dot(ab, p - _v0) / n, n));
+        return _v0 + t / n * ab;
     }
 
-    return (m_vertices[0] * bcoords[0] + m_vertices[1] * bcoords[1] + m_vertices[2] * bcoords[2]);
+    return (_v0 * bcoords[0] + _v1 * bcoords[1] + _v2 * bcoords[2]);
 }
 
 // by Inigo Quiles
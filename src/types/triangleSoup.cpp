@@ -0,0 +1,291 @@
+#include "vera/types/triangleSoup.h"
+#include "vera/types/mesh.h"
+#include "vera/ops/parallel.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace vera {
+
+// Hashed in blocks of this many bytes, one thread per run of blocks (the
+// result does not depend on the number of threads)
+static const size_t SOUP_HASH_BLOCK = 1 << 20;
+
+// MurmurHash3's 64-bit finalizer
+static inline uint64_t hashMix(uint64_t _h) {
+    _h ^= _h >> 33;
+    _h *= 0xff51afd7ed558ccdULL;
+    _h ^= _h >> 33;
+    _h *= 0xc4ceb9fe1a85ec53ULL;
+    _h ^= _h >> 33;
+    return _h;
+}
+
+static uint64_t hashBytes(const uint8_t* _data, size_t _size, uint64_t _seed) {
+    size_t blocks = (_size + SOUP_HASH_BLOCK - 1) / SOUP_HASH_BLOCK;
+    std::vector<uint64_t> hashes(blocks);
+    parallelFor(parallelThreads(blocks, 4), blocks, [&](size_t, size_t _start, size_t _end) {
+        for (size_t b = _start; b < _end; b++) {
+            const uint8_t* data = _data + b * SOUP_HASH_BLOCK;
+            size_t size = std::min(SOUP_HASH_BLOCK, _size - b * SOUP_HASH_BLOCK);
+            uint64_t h = b;
+            size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, data + i, 8);
+                h = (h ^ hashMix(word)) * 0x9e3779b97f4a7c15ULL;
+            }
+            uint64_t tail = 0;
+            std::memcpy(&tail, data + i, size - i);
+            hashes[b] = hashMix(h ^ hashMix(tail));
+        }
+    });
+
+    uint64_t h = _seed ^ _size;
+    for (uint64_t block : hashes)
+        h = (h ^ block) * 0x9e3779b97f4a7c15ULL;
+    return hashMix(h);
+}
+
+TriangleSoup::TriangleSoup() {
+}
+
+TriangleSoup::TriangleSoup(const Mesh& _mesh) {
+    load(_mesh);
+}
+
+TriangleSoup::TriangleSoup(const std::vector<Triangle>& _triangles) {
+    load(_triangles);
+}
+
+void TriangleSoup::clear() {
+    positions.clear();
+    colors.clear();
+    normals.clear();
+    texCoords.clear();
+    tangents.clear();
+    faces.clear();
+    material = nullptr;
+    materials.clear();
+}
+
+// Shares the mesh vertices as they are: only the index list is rewritten
+void TriangleSoup::load(const Mesh& _mesh) {
+    clear();
+
+    if (_mesh.getDrawMode() != TRIANGLES) {
+        std::cout << "ERROR: TriangleSoup: Mesh only add TRIANGLES for NOW !!" << std::endl;
+        return;
+    }
+
+    positions = _mesh.getVertices();
+    size_t count = positions.size();
+    if (_mesh.getColorsTotal() == count) colors = _mesh.getColors();
+    if (_mesh.getNormalsTotal() == count) normals = _mesh.getNormals();
+    if (_mesh.getTexCoordsTotal() == count) texCoords = _mesh.getTexCoords();
+    if (_mesh.getTangentsTotal() == count) tangents = _mesh.getTangents();
+    material = _mesh.getMaterial();
+
+    if (_mesh.haveIndices()) {
+        const std::vector<INDEX_TYPE>& indices = _mesh.getIndices();
+        faces.resize(indices.size() / 3);
+        for (size_t i = 0; i < faces.size(); i++)
+            faces[i] = glm::uvec3(indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]);
+    }
+    else {
+        faces.resize(count / 3);
+        for (size_t i = 0; i < faces.size(); i++)
+            faces[i] = glm::uvec3(i * 3, i * 3 + 1, i * 3 + 2);
+    }
+}
+
+// Each triangle gets its own three vertices. An attribute only some of
+// them have is filled in the way Triangle defaults it.
+void TriangleSoup::load(const std::vector<Triangle>& _triangles) {
+    clear();
+
+    bool haveColors = false, haveNormals = false, haveTexCoords = false, haveTangents = false, sameMaterial = true;
+    for (const Triangle& tri : _triangles) {
+        haveColors |= tri.haveColors();
+        haveNormals |= tri.haveNormals();
+        haveTexCoords |= tri.haveTexCoords();
+        haveTangents |= tri.haveTangents();
+        sameMaterial &= tri.material == _triangles[0].material;
+    }
+
+    size_t count = _triangles.size() * 3;
+    positions.resize(count);
+    if (haveColors) colors.resize(count, glm::vec4(1.0f));
+    if (haveNormals) normals.resize(count);
+    if (haveTexCoords) texCoords.resize(count, glm::vec2(0.0f));
+    if (haveTangents) tangents.resize(count, glm::vec4(0.0f));
+    faces.resize(_triangles.size());
+
+    for (size_t i = 0; i < _triangles.size(); i++) {
+        const Triangle& tri = _triangles[i];
+        for (size_t v = 0; v < 3; v++) {
+            size_t index = i * 3 + v;
+            positions[index] = tri[v];
+            if (tri.haveColors()) colors[index] = tri.getColor(v);
+            if (haveNormals) normals[index] = tri.getNormal(v);
+            if (tri.haveTexCoords()) texCoords[index] = tri.getTexCoord(v);
+            if (tri.haveTangents()) tangents[index] = tri.getTangent(v);
+        }
+        faces[i] = glm::uvec3(i * 3, i * 3 + 1, i * 3 + 2);
+    }
+
+    if (_triangles.empty())
+        return;
+
+    if (sameMaterial)
+        material = _triangles[0].material;
+    else {
+        materials.resize(_triangles.size());
+        for (size_t i = 0; i < _triangles.size(); i++)
+            materials[i] = _triangles[i].material;
+    }
+}
+
+void TriangleSoup::addFace(const TriangleSoup& _soup, size_t _face) {
+    if (empty())
+        material = _soup.material;
+
+    uint32_t first = (uint32_t)positions.size();
+    for (size_t v = 0; v < 3; v++) {
+        uint32_t index = _soup.faces[_face][v];
+        positions.push_back(_soup.positions[index]);
+        if (_soup.haveColors()) colors.push_back(_soup.colors[index]);
+        if (_soup.haveNormals()) normals.push_back(_soup.normals[index]);
+        if (_soup.haveTexCoords()) texCoords.push_back(_soup.texCoords[index]);
+        if (_soup.haveTangents()) tangents.push_back(_soup.tangents[index]);
+    }
+
+    if (!_soup.materials.empty() || !materials.empty() || material != _soup.material) {
+        if (materials.empty())
+            materials.resize(faces.size(), material);
+        materials.push_back(_soup.getMaterial(_face));
+    }
+    addFace(first, first + 1, first + 2);
+}
+
+uint64_t TriangleSoup::getHash() const {
+    uint64_t h = hashBytes(reinterpret_cast<const uint8_t*>(positions.data()), positions.size() * sizeof(glm::vec3), 0);
+    return hashBytes(reinterpret_cast<const uint8_t*>(faces.data()), faces.size() * sizeof(glm::uvec3), h);
+}
+
+glm::vec3 TriangleSoup::getNormal(size_t _face) const {
+    const glm::vec3& v0 = getVertex(_face, 0);
+    return glm::normalize( glm::cross(getVertex(_face, 1) - v0, getVertex(_face, 2) - v0) );
+}
+
+glm::vec3 TriangleSoup::getBarycentricOf(size_t _face, const glm::vec3& _p) const {
+    const glm::vec3& v0 = getVertex(_face, 0);
+    const glm::vec3& v1 = getVertex(_face, 1);
+    const glm::vec3& v2 = getVertex(_face, 2);
+    float area = glm::length( glm::cross(v1 - v0, v2 - v0) );
+
+    const glm::vec3 f0 = v0 - _p;
+    const glm::vec3 f1 = v1 - _p;
+    const glm::vec3 f2 = v2 - _p;
+    return glm::vec3(   glm::length(glm::cross(f1, f2)),
+                        glm::length(glm::cross(f2, f0)),
+                        glm::length(glm::cross(f0, f1))) / area;
+}
+
+glm::vec4 TriangleSoup::getColor(size_t _face, const glm::vec3& _barycenter) const {
+    Material* mat = getMaterial(_face);
+    if (mat != nullptr) {
+        if ( mat->haveProperty("diffuse") ) {
+            if (haveTexCoords())
+                return mat->getColor("diffuse", glm::fract( getTexCoord(_face, _barycenter) ) );
+            else
+                return mat->getColor("diffuse");
+        }
+    }
+
+    if (haveColors()) {
+        const glm::uvec3& f = faces[_face];
+        return  colors[f.x] * _barycenter.x +
+                colors[f.y] * _barycenter.y +
+                colors[f.z] * _barycenter.z;
+    }
+    else
+        return glm::vec4(1.0f);
+}
+
+glm::vec3 TriangleSoup::getNormal(size_t _face, const glm::vec3& _barycenter) const {
+    if (haveNormals()) {
+        const glm::uvec3& f = faces[_face];
+        return  normals[f.x] * _barycenter.x +
+                normals[f.y] * _barycenter.y +
+                normals[f.z] * _barycenter.z;
+    }
+    else
+        return  getNormal(_face);
+}
+
+glm::vec2 TriangleSoup::getTexCoord(size_t _face, const glm::vec3& _barycenter) const {
+    if (!haveTexCoords())
+        return glm::vec2(0.0f);
+
+    const glm::uvec3& f = faces[_face];
+    return  texCoords[f.x] * _barycenter.x +
+            texCoords[f.y] * _barycenter.y +
+            texCoords[f.z] * _barycenter.z;
+}
+
+glm::vec4 TriangleSoup::getTangent(size_t _face, const glm::vec3& _barycenter) const {
+    if (!haveTangents())
+        return glm::vec4(0.0f);
+
+    const glm::uvec3& f = faces[_face];
+    return  tangents[f.x] * _barycenter.x +
+            tangents[f.y] * _barycenter.y +
+            tangents[f.z] * _barycenter.z;
+}
+
+glm::vec3 TriangleSoup::getClosestPoint(size_t _face, const glm::vec3& _p) const {
+    return Triangle::getClosestPoint(getVertex(_face, 0), getVertex(_face, 1), getVertex(_face, 2), _p);
+}
+
+float TriangleSoup::getClosestDistance(size_t _face, const glm::vec3& _p) const {
+    return glm::length(_p - getClosestPoint(_face, _p));
+}
+
+float TriangleSoup::getClosestSignedDistance(size_t _face, const glm::vec3& _p) const {
+    glm::vec3 nearest = getClosestPoint(_face, _p);
+
+    glm::vec3 u = _p - nearest;
+    float distance = glm::length(u);
+
+    glm::vec3 pseudo_normal = getNormal(_face, getBarycentricOf(_face, nearest));
+    return (glm::dot( glm::normalize(u), glm::normalize(pseudo_normal) ) >= 0.0)? distance : -distance;
+}
+
+glm::vec4 TriangleSoup::getClosestRGBSignedDistance(size_t _face, const glm::vec3& _p) const {
+    glm::vec3 nearest = getClosestPoint(_face, _p);
+
+    glm::vec3 barycentric = getBarycentricOf(_face, nearest);
+    glm::vec4 c = getColor(_face, barycentric);
+
+    glm::vec3 u = _p - nearest;
+    c.a = glm::length(u);
+
+    glm::vec3 pseudo_normal = getNormal(_face, barycentric);
+    c.a = (glm::dot( glm::normalize(u), glm::normalize(pseudo_normal) ) >= 0.0)? c.a : -c.a;
+
+    return c;
+}
+
+Triangle TriangleSoup::getTriangle(size_t _face) const {
+    const glm::uvec3& f = faces[_face];
+    Triangle tri = Triangle(positions[f.x], positions[f.y], positions[f.z]);
+    if (haveColors()) tri.setColors(colors[f.x], colors[f.y], colors[f.z]);
+    if (haveNormals()) tri.setNormals(normals[f.x], normals[f.y], normals[f.z]);
+    if (haveTexCoords()) tri.setTexCoords(texCoords[f.x], texCoords[f.y], texCoords[f.z]);
+    if (haveTangents()) tri.setTangents(tangents[f.x], tangents[f.y], tangents[f.z]);
+    tri.material = getMaterial(_face);
+    return tri;
+}
+
+}
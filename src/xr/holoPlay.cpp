@@ -2,6 +2,10 @@
 #include "vera/gl/gl.h"
 #include "vera/ops/draw.h"
 #include "vera/ops/string.h"
+#ifdef SUPPORT_GSPLAT
+#include "vera/types/gsplat.h"
+#include "glm/gtc/matrix_transform.hpp"
+#endif
 
 #include <fstream> 
 
@@ -101,6 +105,14 @@ void renderQuilt(std::function<void(const QuiltProperties&, glm::vec4&, int&)> _
         int qs_viewWidth = int(float(quilt.width) / float(quilt.columns));
         int qs_viewHeight = int(float(quilt.height) / float(quilt.rows));
 
+#ifdef SUPPORT_GSPLAT
+        // Views only differ by a sideways shift of the eye (and the matching
+        // skew), which leaves view depths alone: one sort against the center
+        // camera is exact for all of them
+        Gsplat::beginMultiView( glm::inverse(cam->getTransformMatrix()),
+                                glm::perspective(cam->getFOV(), cam->getAspect(), cam->getNearClip(), cam->getFarClip()) );
+#endif
+
         // render views and copy each view to the quilt
         for (int viewIndex = 0; viewIndex < quilt.totalViews; viewIndex++) {
             // get the x and y origin for this view
@@ -128,6 +140,10 @@ void renderQuilt(std::function<void(const QuiltProperties&, glm::vec4&, int&)> _
             glScissor(viewport[0], viewport[1], viewport[2], viewport[3]);
         }
 
+#ifdef SUPPORT_GSPLAT
+        Gsplat::endMultiView();
+#endif
+
     }
     else {
         currentViewIndex = _viewIndex;
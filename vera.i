@@ -62,6 +62,7 @@
     #include "vera/ops/pixel.h"
     #include "vera/ops/string.h"
     #include "vera/ops/time.h"
+    #include "vera/types/aoBaker.h"
     #include "vera/types/boundingBox.h"
     #include "vera/types/bvh.h"
     #include "vera/types/camera.h"
@@ -78,8 +79,10 @@
     #include "vera/types/props.h"
     #include "vera/types/ray.h"
     #include "vera/types/scene.h"
+    #include "vera/types/sceneBVH.h"
     #include "vera/types/sky.h"
     #include "vera/types/triangle.h"
+    #include "vera/types/triangleSoup.h"
     #include "vera/xr/holoPlay.h"
     #include "vera/xr/xr.h"
     #include "vera/app.h"
@@ -166,8 +169,10 @@ namespace std {
 %include "include/vera/gl/vertexLayout.h"
 %include "include/vera/types/material.h"
 %include "include/vera/types/triangle.h"
+%include "include/vera/types/triangleSoup.h"
 %include "include/vera/types/boundingBox.h"
 %include "include/vera/types/bvh.h"
+%include "include/vera/types/aoBaker.h"
 %include "include/vera/types/plane.h"
 %include "include/vera/types/mesh.h"
 %include "include/vera/types/camera.h"
@@ -178,6 +183,7 @@ namespace std {
 %include "include/vera/types/polarPoint.h"
 %include "include/vera/types/polyline.h"
 %include "include/vera/types/label.h"
+%include "include/vera/types/sceneBVH.h"
 %include "include/vera/types/scene.h"
 %include "include/vera/io/ply.h"
 %include "include/vera/io/stl.h"